@@ -7,28 +7,19 @@
 *  call back functions.  Once the system is up and running the BLE process
 *  is responsible for processing BLE communication events.
 *
-*  Because BLE is extremely time sensitive this process runs everytime we enter
-*  the coop loop and does not follow the normal periodic block based process
-*  structure.
+*  Because BLE is extremely time sensitive this process does not follow the
+*  normal periodic block based process structure.  Every BLESS interrupt posts
+*  an EVENT_SOURCE_BLE event that queues it, see BLE_Bless_Isr(), and the
+*  producers of notification data queue it when they have something to send.
 *
 *********************************************************************************
 */
 #include "BLE.h"
 
-#if (PROCESS_DEBUG_ENABLED == 1u)
+#if (DEBUG_POINTERS_ENABLED == 1u)
     uint8 * BLE_DebugOutput;
 #endif
 
-uint8 BLE_Enable = BLE_ENABLE_INIT;
-/* BLE follows its own path and does not utilized these system variables */
-//uint16 BLE_Timer_Count = BLE_PROCESS_PERIOD_INIT;
-//uint16 BLE_Period = BLE_PROCESS_PERIOD_INIT;
-//T_BLE_STATE s_BLE_State = S_BLE_STATE_INIT;
-
-uint8 BLE_SleepCountInit = 0u;
-uint8 BLE_SleepCounter8;
-uint16 BLE_SleepCounter16;
-
 uint8 Device_Connected = false;
 
 CYBLE_GATTS_HANDLE_VALUE_NTF_T notificationHandle;
@@ -36,25 +27,78 @@ CYBLE_GATTS_HANDLE_VALUE_NTF_T notificationHandle;
 /* Notification Flags */
 uint8 Batt_Notification;
 uint8 Touch_Notification;
+uint8 Gesture_Notification;
+uint8 Capture_Notification;
 
 /* This flag is used to let application update the CCCD value for correct read 
 * operation by connected Central device */
 uint8 Update_Batt_Notification = false;
 uint8 Update_Touch_Notification = false;
 
+#if (PROFILER_ENABLED == 1u) && defined(CYBLE_DIAGNOSTICS_PROFILER_CHAR_HANDLE)
+/* Profiler record selected by the last write to the profiler characteristic */
+uint8 Profiler_Select_ID;
+uint8 Profiler_Select_State;
+uint8 Update_Profiler_Record = false;
+#endif
+
+#if defined(CYBLE_DIAGNOSTICS_POWER_CHAR_HANDLE)
+/* First power statistic selected by the last write to the power characteristic */
+uint8 Power_Select_Stat;
+uint8 Update_Power_Record = false;
+#endif
+
+#if (TRACE_ENABLED == 1u) && defined(CYBLE_DIAGNOSTICS_TRACE_CHAR_HANDLE)
+/* First trace record selected by the last write to the trace characteristic */
+uint16 Trace_Select_Index;
+uint8 Update_Trace_Packet = false;
+#endif
+
+#if (CAPTURE_ENABLED == 1u) && defined(CYBLE_DIAGNOSTICS_CAPTURE_CHAR_HANDLE)
+uint8 Update_Capture_Notification = false;
+#endif
+
+#if defined(CYBLE_TOUCH_SLIDER_GESTURE_CHAR_HANDLE)
+uint8 Update_Gesture_Notification = false;
+/* Gesture the stack had no room for, sent before the next one */
+static TOUCH_EVENT Gesture_Pending;
+static uint8 Gesture_IsPending = false;
+#endif
+
+#if (PROCESS_DEBUG_ENABLED == 1u) && defined(CYBLE_DIAGNOSTICS_TESTMUX_CHAR_HANDLE)
+/* Test mux record from the last write to the test mux characteristic */
+uint8 TestMux_Select[TESTMUX_RECORD_LEN];
+uint8 Update_TestMux_Record = false;
+#endif
+
+#if defined(BLE_1_bless_isr__INTC_NUMBER)
+/* BLESS interrupt handler of the BLE component, called by BLE_Bless_Isr() */
+static cyisraddress BLE_StackIsr;
+#endif
+
 /***************************************
 *   Local Function Prototypes
 ***************************************/
+#if defined(BLE_1_bless_isr__INTC_NUMBER)
+CY_ISR_PROTO(BLE_Bless_Isr);
+#endif
 void Stack_Event_Handler(uint32 event, void* eventParam);
 void BAS_Event_Handler(uint32 event, void* eventParam);
 void HTS_Event_Handler(uint32 event, void *eventParam);
 void HrsEventHandler(uint32 event, void* eventParam);
 void RSCS_Event_Handler(uint32 event, void *eventParam);
 
+static void Drop_Subscriptions(void);
 void Check_For_BLE_Data(void);
 void Update_Gatts_Attribute(CYBLE_GATT_DB_ATTR_HANDLE_T handle, uint8* data, uint8 length);
 void Send_BAS_Over_BLE(void);
 void Send_Touch_Over_BLE(void);
+#if (CAPTURE_ENABLED == 1u) && defined(CYBLE_DIAGNOSTICS_CAPTURE_CHAR_HANDLE)
+static void Send_Capture_Over_BLE(void);
+#endif
+#if defined(CYBLE_TOUCH_SLIDER_GESTURE_CHAR_HANDLE)
+static void Send_Gesture_Over_BLE(void);
+#endif
 
 /***************************************
 *   Interal Varaibles
@@ -71,7 +115,7 @@ void BLE_Process_Init(void)
                               (uint8)ProjectMinorVersion%10 + 0x30};
     
     
-    #if (PROCESS_DEBUG_ENABLED == 1u)
+    #if (DEBUG_POINTERS_ENABLED == 1u)
         if(TestMux_Register(BLE_PROCESS_ID, &BLE_DebugOutput)  == TESTMUX_FAIL)
         {
             Log_Error(BLE_PROCESS_ID, BLE_ERROR_FAILED_TO_REGISTER_TESTMUX);
@@ -82,12 +126,45 @@ void BLE_Process_Init(void)
     CyBle_Start(Stack_Event_Handler);
     CyBle_BasRegisterAttrCallback(BAS_Event_Handler);
     
+    #if defined(BLE_1_bless_isr__INTC_NUMBER)
+    /* CyBle_Start() installed the BLESS interrupt handler of the stack.  Chain
+    onto it so every BLESS interrupt also wakes the co-op loop with an event */
+    BLE_StackIsr = CyIntSetVector(BLE_1_bless_isr__INTC_NUMBER, &BLE_Bless_Isr);
+    #endif
+    
+    /* Run on the first tick to take the stack on event */
+    mProcess_NextTick(BLE_PROCESS);
+    
     /* Update Database with Current Firmware Version string */
     CyBle_DissSetCharacteristicValue(CYBLE_DIS_FIRMWARE_REV, 5, versionString);
     
     return;
 }
 
+#if defined(BLE_1_bless_isr__INTC_NUMBER)
+/*******************************************************************************
+* Function Name: BLE_Bless_Isr
+********************************************************************************
+*
+* Summary:
+*  BLESS interrupt.  Lets the stack handle the hardware, then posts an event
+*  so the BLE process runs CyBle_ProcessEvents() on this wakeup.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+CY_ISR(BLE_Bless_Isr)
+{
+    BLE_StackIsr();
+    
+    (void)Event_Post(EVENT_SOURCE_BLE, 0u);
+}
+#endif
+
 /* BLE Process state machine */
 void BLE_Process(void)
 {
@@ -101,11 +178,17 @@ void BLE_Process(void)
     /* Call BLE Output Functions */
     Send_BAS_Over_BLE();
     Send_Touch_Over_BLE();
+    #if defined(CYBLE_TOUCH_SLIDER_GESTURE_CHAR_HANDLE)
+    Send_Gesture_Over_BLE();
+    #endif
+    #if (CAPTURE_ENABLED == 1u) && defined(CYBLE_DIAGNOSTICS_CAPTURE_CHAR_HANDLE)
+    Send_Capture_Over_BLE();
+    #endif
     
     /* Check for new written data from central */
     Check_For_BLE_Data();
        
-    mBLE_DeQueue();
+    mProcess_DeQueue(BLE_PROCESS);
     
     mDebugClear(BLE_DebugOutput, BLE_DEBUG_ENTER_SM);
     
@@ -140,6 +223,7 @@ void Stack_Event_Handler(uint32 event, void *eventParam)
         case CYBLE_EVT_GAP_DEVICE_DISCONNECTED:
 			/* This event is generated at GAP disconnection. 
 			* Restart advertisement */
+            Drop_Subscriptions();
 			CyBle_GappStartAdvertisement(CYBLE_ADVERTISING_FAST);
 			break;
                     /* BLE stack is on. Start BLE advertisement */
@@ -152,6 +236,7 @@ void Stack_Event_Handler(uint32 event, void *eventParam)
 			{
 				CyBle_GappStartAdvertisement(CYBLE_ADVERTISING_FAST);
                 Device_Connected = false;
+                mProcess_ReleaseFineTick(BLE_PROCESS);
 			}
             break;
         
@@ -168,6 +253,89 @@ void Stack_Event_Handler(uint32 event, void *eventParam)
                 Touch_Notification = wrReqParam->handleValPair.value.val[CYBLE_TOUCH_SLIDER_CURRENT_CENTROID_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_INDEX];
                 Update_Touch_Notification = true;
             }
+            
+            #if defined(CYBLE_TOUCH_SLIDER_GESTURE_CHAR_HANDLE)
+            /* Gesture Notification Change, the gesture events only come to
+            us while the central wants them */
+            if(CYBLE_TOUCH_SLIDER_GESTURE_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE == wrReqParam->handleValPair.attrHandle)
+            {
+                Gesture_Notification = wrReqParam->handleValPair.value.val[CYBLE_TOUCH_SLIDER_GESTURE_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_INDEX];
+                Touch_Subscribe(TOUCH_CONSUMER_BLE, (Gesture_Notification != DISABLED) ? TOUCH_INTEREST_ALL : TOUCH_INTEREST_NONE);
+                Gesture_IsPending = false;
+                Update_Gesture_Notification = true;
+            }
+            #endif
+            
+            #if (CAPTURE_ENABLED == 1u) && defined(CYBLE_DIAGNOSTICS_CAPTURE_CHAR_HANDLE)
+            /* Capture Notification Change, see Capture.h */
+            if(CYBLE_DIAGNOSTICS_CAPTURE_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE == wrReqParam->handleValPair.attrHandle)
+            {
+                Capture_Notification = wrReqParam->handleValPair.value.val[CYBLE_DIAGNOSTICS_CAPTURE_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_INDEX];
+                Update_Capture_Notification = true;
+            }
+            #endif
+            
+            #if (PROFILER_ENABLED == 1u) && defined(CYBLE_DIAGNOSTICS_PROFILER_CHAR_HANDLE)
+            /* Profiler record selection, see Profiler.h */
+            if(CYBLE_DIAGNOSTICS_PROFILER_CHAR_HANDLE == wrReqParam->handleValPair.attrHandle)
+            {
+                Profiler_Select_ID = wrReqParam->handleValPair.value.val[0u];
+                Profiler_Select_State = PROFILER_STATE_ALL;
+                if(wrReqParam->handleValPair.value.len > 1u)
+                {
+                    Profiler_Select_State = wrReqParam->handleValPair.value.val[1u];
+                }
+                Update_Profiler_Record = true;
+            }
+            #endif
+            
+            #if (TRACE_ENABLED == 1u) && defined(CYBLE_DIAGNOSTICS_TRACE_CHAR_HANDLE)
+            /* Trace commands, see Trace.h */
+            if(CYBLE_DIAGNOSTICS_TRACE_CHAR_HANDLE == wrReqParam->handleValPair.attrHandle)
+            {
+                if(wrReqParam->handleValPair.value.val[0u] == TRACE_COMMAND_START)
+                {
+                    Trace_Start();
+                    Trace_Select_Index = 0u;
+                }
+                else
+                {
+                    Trace_Stop();
+                    Trace_Select_Index = 0u;
+                    if(wrReqParam->handleValPair.value.len > 2u)
+                    {
+                        Trace_Select_Index = wrReqParam->handleValPair.value.val[1u] |
+                                             ((uint16)wrReqParam->handleValPair.value.val[2u] << 8u);
+                    }
+                }
+                Update_Trace_Packet = true;
+            }
+            #endif
+            
+            #if (PROCESS_DEBUG_ENABLED == 1u) && defined(CYBLE_DIAGNOSTICS_TESTMUX_CHAR_HANDLE)
+            /* Test mux selections, see TestMux.h.  A short write leaves the
+            settings it does not reach as they are */
+            if(CYBLE_DIAGNOSTICS_TESTMUX_CHAR_HANDLE == wrReqParam->handleValPair.attrHandle)
+            {
+                uint8 i;
+                
+                for(i = 0u; i < TESTMUX_RECORD_LEN; i++)
+                {
+                    TestMux_Select[i] = (i < wrReqParam->handleValPair.value.len) ?
+                                        wrReqParam->handleValPair.value.val[i] : TESTMUX_UNCHANGED;
+                }
+                Update_TestMux_Record = true;
+            }
+            #endif
+            
+            #if defined(CYBLE_DIAGNOSTICS_POWER_CHAR_HANDLE)
+            /* Power statistics selection, see Sleep.h */
+            if(CYBLE_DIAGNOSTICS_POWER_CHAR_HANDLE == wrReqParam->handleValPair.attrHandle)
+            {
+                Power_Select_Stat = wrReqParam->handleValPair.value.val[0u];
+                Update_Power_Record = true;
+            }
+            #endif
 			
 			/* Send the response to the write request received. */
 			CyBle_GattsWriteRsp(cyBle_connHandle);
@@ -177,17 +345,54 @@ void Stack_Event_Handler(uint32 event, void *eventParam)
         case CYBLE_EVT_GATT_CONNECT_IND:
 			/* This flag is used in application to check connection status */
 			Device_Connected = true;
+            /* Service the connection on the fine tick */
+            mProcess_RequestFineTick(BLE_PROCESS);
 			break;
             
 	    case CYBLE_EVT_GATT_DISCONNECT_IND:
 			/* This event is generated at GATT disconnection */
 			Device_Connected = false;
-            
+            mProcess_ReleaseFineTick(BLE_PROCESS);
+            Drop_Subscriptions();
+
         default:
     	    break;
     }
 }
 
+/*******************************************************************************
+* Function Name: Drop_Subscriptions
+********************************************************************************
+*
+* Summary:
+*  Drops the gesture and capture notifications when the link goes down.  The
+*  gestures posted while no central is connected are not sent to the next
+*  one, it starts with the gestures after its own CCCD write.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void Drop_Subscriptions(void)
+{
+    #if defined(CYBLE_TOUCH_SLIDER_GESTURE_CHAR_HANDLE)
+    Gesture_Notification = DISABLED;
+    Touch_Subscribe(TOUCH_CONSUMER_BLE, TOUCH_INTEREST_NONE);
+    Gesture_IsPending = false;
+    Update_Gesture_Notification = true;
+    #endif
+
+    #if (CAPTURE_ENABLED == 1u) && defined(CYBLE_DIAGNOSTICS_CAPTURE_CHAR_HANDLE)
+    Capture_Notification = DISABLED;
+    Update_Capture_Notification = true;
+    #endif
+
+    return;
+}
+
 /*******************************************************************************
 * Function Name: BAS_Event_Handler
 ********************************************************************************
@@ -304,7 +509,7 @@ void Send_Touch_Over_BLE(void)
     if((TouchResult.Data_Ready == true) && Touch_Notification)
     {
         /* send touch data to host client */
-        Set32ByPtr(Touch_Packet, (uint8)TouchResult.CurrentCentroid);
+        Touch_Packet[0u] = TouchResult.CurrentCentroid;
         
         notificationHandle.attrHandle = CYBLE_TOUCH_SLIDER_CURRENT_CENTROID_CHAR_HANDLE;
         notificationHandle.value.val = Touch_Packet;
@@ -317,6 +522,83 @@ void Send_Touch_Over_BLE(void)
     }    
 }
 
+#if defined(CYBLE_TOUCH_SLIDER_GESTURE_CHAR_HANDLE)
+/*****************************************************************************
+* Function Name: Send_Gesture_Over_BLE
+******************************************************************************
+* Summary:
+* Sends every gesture event the touch process posted since the last run,
+*  oldest first, see Touch.h.  An event the stack has no room for is kept
+*  and goes out first on the next run.
+*
+* Parameters:
+* None
+*
+* Return:
+* None
+*
+*****************************************************************************/
+static void Send_Gesture_Over_BLE(void)
+{
+    uint8 Gesture_Packet[GESTURE_CHAR_DATA_LEN];
+    
+    while(Gesture_Notification &&
+          (Gesture_IsPending || Touch_TakeEvent(TOUCH_CONSUMER_BLE, &Gesture_Pending)))
+    {
+        Gesture_IsPending = true;
+        
+        Gesture_Packet[0u] = Gesture_Pending.Gesture;
+        Gesture_Packet[1u] = Gesture_Pending.Centroid;
+        Set16ByPtr(&Gesture_Packet[2u], (uint16)Gesture_Pending.Timestamp);
+        
+        notificationHandle.attrHandle = CYBLE_TOUCH_SLIDER_GESTURE_CHAR_HANDLE;
+        notificationHandle.value.val = Gesture_Packet;
+        notificationHandle.value.len = GESTURE_CHAR_DATA_LEN;
+        
+        if(CyBle_GattsNotification(cyBle_connHandle, &notificationHandle) != CYBLE_ERROR_OK)
+        {
+            break;
+        }
+        Gesture_IsPending = false;
+    }
+}
+#endif
+
+#if (CAPTURE_ENABLED == 1u) && defined(CYBLE_DIAGNOSTICS_CAPTURE_CHAR_HANDLE)
+/*****************************************************************************
+* Function Name: Send_Capture_Over_BLE
+******************************************************************************
+* Summary:
+* Sends the touch capture records waiting in the ring, oldest first, see
+*  Capture.h.  A record stays in the ring when the stack has no room for its
+*  notification and goes out on the next run.
+*
+* Parameters:
+* None
+*
+* Return:
+* None
+*
+*****************************************************************************/
+static void Send_Capture_Over_BLE(void)
+{
+    uint8 Capture_Packet[CAPTURE_RECORD_LEN];
+    
+    while(Capture_Notification && Capture_Peek(Capture_Packet))
+    {
+        notificationHandle.attrHandle = CYBLE_DIAGNOSTICS_CAPTURE_CHAR_HANDLE;
+        notificationHandle.value.val = Capture_Packet;
+        notificationHandle.value.len = CAPTURE_RECORD_LEN;
+        
+        if(CyBle_GattsNotification(cyBle_connHandle, &notificationHandle) != CYBLE_ERROR_OK)
+        {
+            break;
+        }
+        Capture_Drop();
+    }
+}
+#endif
+
 /*****************************************************************************
 * Function Name: Check_For_BLE_Data
 ******************************************************************************
@@ -345,6 +627,85 @@ void Check_For_BLE_Data(void)
         Update_Gatts_Attribute(CYBLE_TOUCH_SLIDER_CURRENT_CENTROID_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE, Gatt_Temp, CCC_DATA_LEN);
         Update_Touch_Notification = false;
     }
+    
+    #if defined(CYBLE_TOUCH_SLIDER_GESTURE_CHAR_HANDLE)
+    if(Update_Gesture_Notification)
+    {
+        Set16ByPtr(Gatt_Temp, Gesture_Notification);
+        Update_Gatts_Attribute(CYBLE_TOUCH_SLIDER_GESTURE_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE, Gatt_Temp, CCC_DATA_LEN);
+        Update_Gesture_Notification = false;
+    }
+    #endif
+    
+    #if (CAPTURE_ENABLED == 1u) && defined(CYBLE_DIAGNOSTICS_CAPTURE_CHAR_HANDLE)
+    if(Update_Capture_Notification)
+    {
+        Set16ByPtr(Gatt_Temp, Capture_Notification);
+        Update_Gatts_Attribute(CYBLE_DIAGNOSTICS_CAPTURE_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE, Gatt_Temp, CCC_DATA_LEN);
+        Update_Capture_Notification = false;
+    }
+    #endif
+    
+    #if (PROFILER_ENABLED == 1u) && defined(CYBLE_DIAGNOSTICS_PROFILER_CHAR_HANDLE)
+    if(Update_Profiler_Record)
+    {
+        uint8 Profiler_Packet[PROFILER_RECORD_LEN] = {0u};
+        
+        if(Profiler_Select_ID == PROFILER_SELECT_RESET)
+        {
+            Profiler_Reset();
+        }
+        
+        /* Load the selected record for the central to read.  An unknown
+        selection reads back as all zeros */
+        (void)Profiler_GetRecord(Profiler_Select_ID, Profiler_Select_State, Profiler_Packet);
+        Update_Gatts_Attribute(CYBLE_DIAGNOSTICS_PROFILER_CHAR_HANDLE, Profiler_Packet, PROFILER_RECORD_LEN);
+        Update_Profiler_Record = false;
+    }
+    #endif
+    
+    #if (TRACE_ENABLED == 1u) && defined(CYBLE_DIAGNOSTICS_TRACE_CHAR_HANDLE)
+    if(Update_Trace_Packet)
+    {
+        uint8 Trace_Packet[TRACE_PACKET_LEN];
+        
+        /* Load the selected records for the central to read */
+        (void)Trace_GetPacket(Trace_Select_Index, Trace_Packet);
+        Update_Gatts_Attribute(CYBLE_DIAGNOSTICS_TRACE_CHAR_HANDLE, Trace_Packet, TRACE_PACKET_LEN);
+        Update_Trace_Packet = false;
+    }
+    #endif
+    
+    #if (PROCESS_DEBUG_ENABLED == 1u) && defined(CYBLE_DIAGNOSTICS_TESTMUX_CHAR_HANDLE)
+    if(Update_TestMux_Record)
+    {
+        uint8 TestMux_Packet[TESTMUX_RECORD_LEN];
+        
+        /* Move the pins, then load what took for the central to read */
+        TestMux_Configure(TestMux_Select);
+        TestMux_GetRecord(TestMux_Packet);
+        Update_Gatts_Attribute(CYBLE_DIAGNOSTICS_TESTMUX_CHAR_HANDLE, TestMux_Packet, TESTMUX_RECORD_LEN);
+        Update_TestMux_Record = false;
+    }
+    #endif
+    
+    #if defined(CYBLE_DIAGNOSTICS_POWER_CHAR_HANDLE)
+    if(Update_Power_Record)
+    {
+        uint8 Power_Packet[SLEEP_STATS_RECORD_LEN];
+        
+        if(Power_Select_Stat == SLEEP_STATS_SELECT_RESET)
+        {
+            Sleep_ResetStats();
+            Power_Select_Stat = SLEEP_STAT_UPTIME;
+        }
+        
+        /* Load the selected statistics for the central to read */
+        (void)Sleep_GetStatsRecord(Power_Select_Stat, Power_Packet);
+        Update_Gatts_Attribute(CYBLE_DIAGNOSTICS_POWER_CHAR_HANDLE, Power_Packet, SLEEP_STATS_RECORD_LEN);
+        Update_Power_Record = false;
+    }
+    #endif
 }
 
 /*****************************************************************************
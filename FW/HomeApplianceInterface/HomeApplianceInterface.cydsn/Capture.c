@@ -0,0 +1,123 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         Capture.c
+********************************************************************************
+* Description:
+*  Records every CapSense scan for the host replay tool, see Capture.h.
+*
+********************************************************************************
+*/
+#include <string.h>
+#include "Capture.h"
+
+#if (CAPTURE_ENABLED == 1u)
+
+static uint8 Capture_Buffer[CAPTURE_RECORDS][CAPTURE_RECORD_LEN];
+/* Slot of the next record and records waiting for BLE */
+static uint8 Capture_Head;
+static uint8 Capture_Used;
+static uint8 Capture_Sequence;
+uint16 CaptureOverwritten;
+
+/*******************************************************************************
+* Function Name: Capture_Scan
+********************************************************************************
+*
+* Summary:
+*  Records the result of the scan that just finished.
+*
+* Parameters:
+*  uint8 Centroid: Slider centroid of the scan, NO_TOUCH for none.
+*  uint8 Gesture:  Gesture the scan made.
+*  uint8 Mode:     TOUCH_MODE_ the scan was made in.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Capture_Scan(uint8 Centroid, uint8 Gesture, uint8 Mode)
+{
+    uint8 i;
+    uint8 * record = Capture_Buffer[Capture_Head];
+
+    record[CAPTURE_OFFSET_MAGIC] = CAPTURE_MAGIC;
+    record[CAPTURE_OFFSET_SEQUENCE] = Capture_Sequence++;
+    Set32ByPtr(&record[CAPTURE_OFFSET_TIME], WatchdogTimer_GetCount());
+    for(i = 0u; i < CAPTURE_SENSORS; i++)
+    {
+        Set16ByPtr(&record[CAPTURE_OFFSET_RAW + (i * 2u)], CapSense_sensorRaw[i]);
+    }
+    record[CAPTURE_OFFSET_SENSOR_ON] = CapSense_sensorOnMask[0u];
+    record[CAPTURE_OFFSET_CENTROID] = Centroid;
+    record[CAPTURE_OFFSET_GESTURE] = Gesture;
+    record[CAPTURE_OFFSET_MODE] = Mode;
+
+    #if (PROCESS_UART_ENABLE == 1u)
+        DUART_SpiUartPutArray(record, CAPTURE_RECORD_LEN);
+    #endif
+
+    if(Capture_Used < CAPTURE_RECORDS)
+    {
+        Capture_Used++;
+    }
+    else if(CaptureOverwritten < 0xFFFFu)
+    {
+        CaptureOverwritten++;
+    }
+    Capture_Head = (Capture_Head + 1u) & CAPTURE_RECORD_MASK;
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Capture_Peek
+********************************************************************************
+*
+* Summary:
+*  Copies out the oldest record that has not been sent.
+*
+* Parameters:
+*  uint8 * Record: Receives CAPTURE_RECORD_LEN bytes.
+*
+* Return:
+*  TRUE if there was a record, Capture_Drop() it once it is sent.
+*
+*******************************************************************************/
+uint8 Capture_Peek(uint8 * Record)
+{
+    if(Capture_Used == 0u)
+    {
+        return FALSE;
+    }
+
+    memcpy(Record, Capture_Buffer[(Capture_Head - Capture_Used) & CAPTURE_RECORD_MASK], CAPTURE_RECORD_LEN);
+
+    return TRUE;
+}
+
+/*******************************************************************************
+* Function Name: Capture_Drop
+********************************************************************************
+*
+* Summary:
+*  Removes the oldest record, the one Capture_Peek() copied.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Capture_Drop(void)
+{
+    if(Capture_Used != 0u)
+    {
+        Capture_Used--;
+    }
+
+    return;
+}
+
+#endif
+/* [] END OF FILE */
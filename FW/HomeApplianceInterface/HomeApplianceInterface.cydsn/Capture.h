@@ -0,0 +1,67 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         Capture.h
+********************************************************************************
+* Description:
+*  Contains defines, function prototypes, and macros for the touch capture.
+*
+*  After every CapSense scan the touch process hands the scan result to
+*  Capture_Scan(), which makes a CAPTURE_RECORD_LEN byte record of it: the
+*  WDT clock, the raw counts, CapSense_sensorOnMask, the centroid and the
+*  gesture the firmware made of it.  With PROCESS_UART_ENABLE every record
+*  goes straight out of the UART.  The records also wait in a RAM ring of
+*  CAPTURE_RECORDS for the BLE process, which sends them as notifications of
+*  the capture characteristic once the central enables them, see BLE.c.
+*  When the ring is full the oldest record is dropped, the sequence number
+*  shows the host where.
+*
+*  The replay tool in the HostSim directory plays a capture back through the
+*  unmodified touch process and gesture engine, see TouchReplay.c.
+*
+********************************************************************************
+*/
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "main.h"
+
+/* Must be a power of 2 */
+#define CAPTURE_RECORDS                 (16u)
+#define CAPTURE_RECORD_MASK             (CAPTURE_RECORDS - 1u)
+
+#if ((CAPTURE_RECORDS & CAPTURE_RECORD_MASK) != 0u)
+    #error CAPTURE_RECORDS must be a power of 2
+#endif
+
+/* Record, little endian, one GATT notification:
+   [0]      CAPTURE_MAGIC, to find the records in a UART stream
+   [1]      Sequence, counts every scan
+   [2..5]   WatchdogTimer_GetCount() at the end of the scan
+   [6..15]  CapSense_sensorRaw[] of the 5 sensors
+   [16]     CapSense_sensorOnMask[0]
+   [17]     Slider centroid, NO_TOUCH for none
+   [18]     Gesture of the scan, NO_GESTURE for none
+   [19]     TOUCH_MODE_ of the scan */
+#define CAPTURE_MAGIC                   (0xCAu)
+#define CAPTURE_SENSORS                 (5u)
+#define CAPTURE_RECORD_LEN              (20u)
+
+#define CAPTURE_OFFSET_MAGIC            (0u)
+#define CAPTURE_OFFSET_SEQUENCE         (1u)
+#define CAPTURE_OFFSET_TIME             (2u)
+#define CAPTURE_OFFSET_RAW              (6u)
+#define CAPTURE_OFFSET_SENSOR_ON        (16u)
+#define CAPTURE_OFFSET_CENTROID         (17u)
+#define CAPTURE_OFFSET_GESTURE          (18u)
+#define CAPTURE_OFFSET_MODE             (19u)
+
+/* Function Prototypes */
+void Capture_Scan(uint8 Centroid, uint8 Gesture, uint8 Mode);
+uint8 Capture_Peek(uint8 * Record);
+void Capture_Drop(void);
+
+/* Records dropped from the full ring, saturated */
+extern uint16 CaptureOverwritten;
+
+#endif
+/* [] END OF FILE */
@@ -10,46 +10,228 @@
 
 #include "ErrorLog.h"
 
-uint8 ErrorLogArray[ERROR_LOG_SIZE];
+ERROR_RECORD ErrorLogArray[ERROR_LOG_RECORDS];
 
-ERROR_INDEX_TYPE ErrorIndex;
-ERROR_INDEX_TYPE ErrorCount;
+/* Slot of the next new record */
+uint8 ErrorIndex;
+/* Records in the log */
+uint8 ErrorCount;
+/* Records lost to newer ones, saturated */
+uint16 ErrorsOverwritten;
+/* Records changed since ErrorLog_TakeChanged() last took them, one bit per
+slot, how many there are and the time of the oldest change */
+static uint32 ErrorLog_Changed;
+uint8 ErrorsChanged;
+uint32 ErrorsChangedMs;
 
+/* Local Function Declarations */
+static void ErrorLog_MarkChanged(uint8 Slot, uint32 TimeMs);
+
+/*******************************************************************************
+* Function Name: Log_Error
+********************************************************************************
+*
+* Summary:
+*  Logs an error.  A repeat of one of the newest records only counts another
+*  occurrence of that record and moves its time.
+*
+* Parameters:
+*  uint8 ProcessID: Process ID, SYSTEM_PROCESS_ID or TESTMUX_PROCESS_ID.
+*  uint8 Error:     The PROCESSNAME_ERROR_ code.
+*
+* Return:
+*  None.
+*
+* Theory:
+*  The clock is read before interrupts are masked, so the critical section
+*  only covers the search of ERROR_LOG_COALESCE_DEPTH records and the update
+*  of one.  An interrupt that logs between the clock read and the update can
+*  leave the two records a few counts out of time order.
+*
+*******************************************************************************/
 void Log_Error(uint8 ProcessID, uint8 Error)
 {
+    uint8 interruptStatus;
+    uint8 i;
+    uint8 slot;
+    uint32 timeMs;
+    ERROR_RECORD * record;
+
     mDebugSet(System_DebugOutput, DEBUG_ERROR_LOGGED_MASK);
     mDebugSet(System_DebugOutput, DEBUG_ERROR_MASK);
-    
-    if(ErrorIndex < (ERROR_LOG_SIZE - 1u))
+
+    timeMs = (uint32)WatchdogTimer_GetClockMs();
+
+    interruptStatus = CyEnterCriticalSection();
+
+    /* Look for a repeat, newest first */
+    for(i = 1u; (i <= ERROR_LOG_COALESCE_DEPTH) && (i <= ErrorCount); i++)
+    {
+        record = &ErrorLogArray[(uint8)(ErrorIndex - i) & ERROR_LOG_MASK];
+        if((record->ProcessID == ProcessID) && (record->Error == Error))
+        {
+            if(record->Repeats < ERROR_LOG_REPEATS_MAX)
+            {
+                record->Repeats++;
+            }
+            record->TimeMs = timeMs;
+            ErrorLog_MarkChanged((uint8)(ErrorIndex - i) & ERROR_LOG_MASK, timeMs);
+
+            CyExitCriticalSection(interruptStatus);
+            mDebugClear(System_DebugOutput, DEBUG_ERROR_LOGGED_MASK);
+            return;
+        }
+    }
+
+    /* New record, over the oldest when the log is full */
+    slot = ErrorIndex;
+    ErrorIndex = (slot + 1u) & ERROR_LOG_MASK;
+    if(ErrorCount < ERROR_LOG_RECORDS)
     {
-        ErrorLogArray[ErrorIndex] = ProcessID;
-        ErrorIndex++;
-        ErrorLogArray[ErrorIndex] = Error;
-        ErrorIndex++;
-        
         ErrorCount++;
     }
-    
+    else if(ErrorsOverwritten < 0xFFFFu)
+    {
+        ErrorsOverwritten++;
+    }
+
+    record = &ErrorLogArray[slot];
+    record->ProcessID = ProcessID;
+    record->Error = Error;
+    record->Repeats = 0u;
+    record->TimeMs = timeMs;
+    ErrorLog_MarkChanged(slot, timeMs);
+
+    CyExitCriticalSection(interruptStatus);
+
     mDebugClear(System_DebugOutput, DEBUG_ERROR_LOGGED_MASK);
-    
+
     return;
 }
 
+/*******************************************************************************
+* Function Name: ErrorLog_Read
+********************************************************************************
+*
+* Summary:
+*  Copies a record out of the log.
+*
+* Parameters:
+*  uint8 Index:           0 for the oldest record, mErrorLog_Count() - 1 for
+*                         the newest.
+*  ERROR_RECORD * Record: Receives the record.
+*
+* Return:
+*  TRUE if Index holds a record.
+*
+* Theory:
+*  The copy is taken with interrupts masked, an interrupt cannot change the
+*  record half way.  The indexes move when errors are logged between two
+*  calls, read the log in one pass of the co-op loop.
+*
+*******************************************************************************/
+uint8 ErrorLog_Read(uint8 Index, ERROR_RECORD * Record)
+{
+    uint8 interruptStatus;
+    uint8 found = FALSE;
+
+    interruptStatus = CyEnterCriticalSection();
+    if(Index < ErrorCount)
+    {
+        *Record = ErrorLogArray[(uint8)((ErrorIndex - ErrorCount) + Index) & ERROR_LOG_MASK];
+        found = TRUE;
+    }
+    CyExitCriticalSection(interruptStatus);
+
+    return found;
+}
+
+/*******************************************************************************
+* Function Name: ErrorLog_TakeChanged
+********************************************************************************
+*
+* Summary:
+*  Copies out the records that changed since the last call, oldest first, and
+*  clears their changed marks.
+*
+* Parameters:
+*  ERROR_RECORD * Records: Receives up to Max records.
+*  uint8 Max:              Size of Records.
+*
+* Return:
+*  The number of records copied.  Changed records that did not fit stay
+*  marked for the next call.
+*
+* Theory:
+*  One pass over the log with interrupts masked, so a record cannot change
+*  between its copy and clearing its mark.  At ERROR_LOG_RECORDS records
+*  this is a few microseconds and only the co-op loop calls it.
+*
+*******************************************************************************/
+uint8 ErrorLog_TakeChanged(ERROR_RECORD * Records, uint8 Max)
+{
+    uint8 interruptStatus;
+    uint8 i;
+    uint8 slot;
+    uint8 taken = 0u;
+
+    interruptStatus = CyEnterCriticalSection();
+    slot = (uint8)(ErrorIndex - ErrorCount) & ERROR_LOG_MASK;
+    for(i = 0u; (i < ErrorCount) && (taken < Max); i++)
+    {
+        if((ErrorLog_Changed & ((uint32)1u << slot)) != 0u)
+        {
+            Records[taken] = ErrorLogArray[slot];
+            taken++;
+            ErrorLog_Changed &= ~((uint32)1u << slot);
+            ErrorsChanged--;
+        }
+        slot = (slot + 1u) & ERROR_LOG_MASK;
+    }
+    CyExitCriticalSection(interruptStatus);
+
+    return taken;
+}
+
 void ClearLog(void)
 {
-    ERROR_INDEX_TYPE i;
-    
-    for(i = 0; i < ERROR_LOG_SIZE; i++)
+    uint8 interruptStatus;
+    uint8 i;
+
+    interruptStatus = CyEnterCriticalSection();
+    for(i = 0; i < ERROR_LOG_RECORDS; i++)
     {
-        ErrorLogArray[i] = 0u;
+        ErrorLogArray[i].ProcessID = 0u;
+        ErrorLogArray[i].Error = 0u;
+        ErrorLogArray[i].Repeats = 0u;
+        ErrorLogArray[i].TimeMs = 0u;
     }
-    
+
     ErrorIndex = 0u;
     ErrorCount = 0u;
-    
+    ErrorsOverwritten = 0u;
+    ErrorLog_Changed = 0u;
+    ErrorsChanged = 0u;
+    CyExitCriticalSection(interruptStatus);
+
     mClearErrorPin();
-    
+
     return;
 }
 
+/* Mark a slot changed, call with interrupts masked.  A slot that is still
+marked when its record is overwritten stays counted once */
+static void ErrorLog_MarkChanged(uint8 Slot, uint32 TimeMs)
+{
+    if((ErrorLog_Changed & ((uint32)1u << Slot)) == 0u)
+    {
+        ErrorLog_Changed |= ((uint32)1u << Slot);
+        if(ErrorsChanged == 0u)
+        {
+            ErrorsChangedMs = TimeMs;
+        }
+        ErrorsChanged++;
+    }
+}
+
 /* [] END OF FILE */
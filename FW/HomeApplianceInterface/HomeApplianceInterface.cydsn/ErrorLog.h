@@ -5,27 +5,53 @@
 * Description:
 *  Contains defines, function prototypes, and macros for the error log.
 *
+*  The log is a ring of ERROR_LOG_RECORDS records.  When it is full the
+*  oldest record is overwritten, so the log always holds the newest errors.
+*  An error that matches one of the last ERROR_LOG_COALESCE_DEPTH records
+*  counts another occurrence of that record instead of taking a new one, so
+*  a repeating error cannot push the others out.
+*
+*  Log_Error() may be called from interrupts.  It only masks interrupts to
+*  update one record.
+*
+*  Every new or repeated record is marked changed until
+*  ErrorLog_TakeChanged() takes it, which is how the error store finds the
+*  records it has to save, see ErrorStore.h.
+*
 ********************************************************************************
 */
 
 #ifndef ERRORLOG_HEADER
 #define ERRORLOG_HEADER
-    
+
+#include <project.h>
+
+/* One error, 8 bytes.  Ahead of main.h, which includes ErrorStore.h */
+typedef struct
+{
+    uint8 ProcessID;
+    uint8 Error;
+    uint16 Repeats;             /* occurrences after the first, saturated */
+    uint32 TimeMs;              /* WatchdogTimer_GetClockMs() of the latest occurrence */
+} ERROR_RECORD;
+
 #include "main.h"
 
-#define MAX_NUMBER_OF_ERRORS    (128u)
-#define ERROR_LOG_SIZE          (MAX_NUMBER_OF_ERRORS * 2u)
+/* Must be a power of 2 no larger than 32, one bit of ErrorLog_Changed each */
+#define ERROR_LOG_RECORDS       (32u)
+#define ERROR_LOG_MASK          (ERROR_LOG_RECORDS - 1u)
+/* Newest records searched for a repeat of the same error */
+#define ERROR_LOG_COALESCE_DEPTH    (4u)
+#define ERROR_LOG_REPEATS_MAX       (0xFFFFu)
 
-#if (ERROR_LOG_SIZE <= 256u)
-    typedef uint8 ERROR_INDEX_TYPE;
-#elif (ERROR_LOG_SIZE <= 65536u)
-    typedef uint16 ERROR_INDEX_TYPE;
-#else
-    #error error log size too large
+#if ((ERROR_LOG_RECORDS & ERROR_LOG_MASK) != 0u) || (ERROR_LOG_RECORDS > 32u)
+    #error ERROR_LOG_RECORDS must be a power of 2 no larger than 32
 #endif
-    
+
 void Log_Error(uint8 ProcessID, uint8 Error);
 void ClearLog(void);
+uint8 ErrorLog_Read(uint8 Index, ERROR_RECORD * Record);
+uint8 ErrorLog_TakeChanged(ERROR_RECORD * Records, uint8 Max);
 
 #define mClearErrorPin()\
     do\
@@ -33,10 +59,16 @@ void ClearLog(void);
         mDebugClear(System_DebugOutput, DEBUG_ERROR_MASK);\
     }while(0)
 
-extern uint8 ErrorLogArray[ERROR_LOG_SIZE];
-extern ERROR_INDEX_TYPE ErrorIndex;
-extern ERROR_INDEX_TYPE ErrorCount;
-    
+/* Records in the log, oldest first from index 0 */
+#define mErrorLog_Count()       (ErrorCount)
+
+extern ERROR_RECORD ErrorLogArray[ERROR_LOG_RECORDS];
+extern uint8 ErrorIndex;
+extern uint8 ErrorCount;
+extern uint16 ErrorsOverwritten;
+extern uint8 ErrorsChanged;
+extern uint32 ErrorsChangedMs;
+
 #endif
 
 /* [] END OF FILE */
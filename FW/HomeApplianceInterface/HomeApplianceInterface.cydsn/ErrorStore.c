@@ -0,0 +1,265 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         ErrorStore.c
+********************************************************************************
+* Description:
+*  Saves the error log to flash in batches, see ErrorStore.h.
+*
+********************************************************************************
+*/
+#include "ErrorStore.h"
+
+#if (ERROR_STORE_ENABLED == 1u)
+
+/* Rows reserved for the store.  Declaring them keeps the linker from placing
+code there, and they are read through a volatile pointer because the
+compiler would otherwise fold the reads to the erased contents.  The host
+simulation provides its own flash model */
+#if !defined(ERROR_STORE_FLASH)
+    const volatile uint8 CY_ALIGN(CY_FLASH_SIZEOF_ROW) ErrorStore_Flash[ERROR_STORE_ROWS * CY_FLASH_SIZEOF_ROW] = {0u};
+    #define ERROR_STORE_FLASH           (ErrorStore_Flash)
+    #define ERROR_STORE_FIRST_ROW       ((((uint32)ErrorStore_Flash) - CY_FLASH_BASE) / CY_FLASH_SIZEOF_ROW)
+#endif
+
+ERROR_STORE_STATUS ErrorStore_Status;
+
+/* Row being written or read */
+static ERROR_STORE_ROW ErrorStore_Buffer;
+static uint32 ErrorStore_LastWriteMs;
+/* Rows loaded, for ErrorStore_Status.RecoveryReads */
+static uint8 ErrorStore_Reads;
+
+/* Local Function Declarations */
+static uint8 ErrorStore_LoadRow(uint8 Row, ERROR_STORE_ROW * Buffer);
+static uint8 ErrorStore_Sum(const uint8 * Data);
+static void ErrorStore_WriteRow(uint32 NowMs);
+
+/*******************************************************************************
+* Function Name: ErrorStore_Init
+********************************************************************************
+*
+* Summary:
+*  Finds the newest row so the store carries on after it, and counts this
+*  start up.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+* Theory:
+*  Rows are written in order of their sequence, so starting at row 0 the
+*  rows hold consecutive sequences up to the newest one.  After that come
+*  rows of the previous round, which are older, or erased or torn rows.  A
+*  binary search for the last row that continues the sequence of row 0 finds
+*  the newest.  Row 0 itself fails only if its write was torn after the store
+*  had wrapped, the newest row is then the last one, or if the store is
+*  empty.
+*
+*******************************************************************************/
+void ErrorStore_Init(void)
+{
+    uint8 low;
+    uint8 high;
+    uint8 middle;
+    uint8 newest = ERROR_STORE_ROWS;
+    uint32 first;
+
+    ErrorStore_Status.Sequence = 0u;
+    ErrorStore_Status.Boot = 1u;
+    ErrorStore_Status.Writes = 0u;
+    ErrorStore_Status.WriteErrors = 0u;
+    ErrorStore_Reads = 0u;
+
+    if(ErrorStore_LoadRow(0u, &ErrorStore_Buffer))
+    {
+        first = ErrorStore_Buffer.Sequence;
+        low = 0u;
+        high = ERROR_STORE_ROWS - 1u;
+        while(low < high)
+        {
+            middle = (low + high + 1u) >> 1u;
+            if(ErrorStore_LoadRow(middle, &ErrorStore_Buffer) &&
+               (ErrorStore_Buffer.Sequence == (first + middle)))
+            {
+                low = middle;
+            }
+            else
+            {
+                high = middle - 1u;
+            }
+        }
+        newest = low;
+    }
+    else if(ErrorStore_LoadRow(ERROR_STORE_ROWS - 1u, &ErrorStore_Buffer))
+    {
+        newest = ERROR_STORE_ROWS - 1u;
+    }
+
+    if((newest < ERROR_STORE_ROWS) && ErrorStore_LoadRow(newest, &ErrorStore_Buffer))
+    {
+        ErrorStore_Status.Sequence = ErrorStore_Buffer.Sequence;
+        ErrorStore_Status.Boot = ErrorStore_Buffer.Boot + 1u;
+    }
+    ErrorStore_Status.RecoveryReads = ErrorStore_Reads;
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: ErrorStore_Service
+********************************************************************************
+*
+* Summary:
+*  Writes one row of changed error records when a batch is ready and the
+*  radio is idle.  The co-op loop calls this once the processes are done.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void ErrorStore_Service(void)
+{
+    uint32 nowMs;
+
+    if(ErrorsChanged == 0u)
+    {
+        return;
+    }
+
+    nowMs = (uint32)WatchdogTimer_GetClockMs();
+
+    /* Wait for a full row unless the changes have waited long enough */
+    if((ErrorsChanged < ERROR_STORE_RECORDS_PER_ROW) &&
+       ((nowMs - ErrorsChangedMs) < ERROR_STORE_FLUSH_MS))
+    {
+        return;
+    }
+
+    /* Bound the wear when errors keep coming */
+    if((ErrorStore_Status.Writes != 0u) &&
+       ((nowMs - ErrorStore_LastWriteMs) < ERROR_STORE_MIN_INTERVAL_MS))
+    {
+        return;
+    }
+
+    if(!mBLE_IsRadioIdle())
+    {
+        return;
+    }
+
+    ErrorStore_WriteRow(nowMs);
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: ErrorStore_ReadRow
+********************************************************************************
+*
+* Summary:
+*  Copies a saved row out of the store.
+*
+* Parameters:
+*  uint8 Age:              0 for the newest row, 1 for the one before and so
+*                          on up to ERROR_STORE_ROWS - 1.
+*  ERROR_STORE_ROW * Row:  Receives the row.
+*
+* Return:
+*  TRUE if the row is valid.
+*
+*******************************************************************************/
+uint8 ErrorStore_ReadRow(uint8 Age, ERROR_STORE_ROW * Row)
+{
+    uint32 sequence;
+
+    if((Age >= ERROR_STORE_ROWS) || ((uint32)Age >= ErrorStore_Status.Sequence))
+    {
+        return FALSE;
+    }
+
+    sequence = ErrorStore_Status.Sequence - Age;
+    if(!ErrorStore_LoadRow((uint8)((sequence - 1u) & ERROR_STORE_ROW_MASK), Row))
+    {
+        return FALSE;
+    }
+
+    return (Row->Sequence == sequence) ? TRUE : FALSE;
+}
+
+/* Take the changed records and write them to the row after the newest */
+static void ErrorStore_WriteRow(uint32 NowMs)
+{
+    uint8 i;
+    uint32 sequence = ErrorStore_Status.Sequence + 1u;
+    ERROR_STORE_ROW * row = &ErrorStore_Buffer;
+
+    row->Sequence = sequence;
+    row->Boot = ErrorStore_Status.Boot;
+    row->Count = ErrorLog_TakeChanged(row->Record, ERROR_STORE_RECORDS_PER_ROW);
+    for(i = row->Count; i < ERROR_STORE_RECORDS_PER_ROW; i++)
+    {
+        row->Record[i].ProcessID = 0u;
+        row->Record[i].Error = 0u;
+        row->Record[i].Repeats = 0u;
+        row->Record[i].TimeMs = 0u;
+    }
+    row->Checksum = 0u;
+    row->Checksum = (uint8)(0u - ErrorStore_Sum((const uint8 *)row));
+
+    ErrorStore_LastWriteMs = NowMs;
+    if(CySysFlashWriteRow(ERROR_STORE_FIRST_ROW + ((sequence - 1u) & ERROR_STORE_ROW_MASK),
+                          (const uint8 *)row) == CY_SYS_FLASH_SUCCESS)
+    {
+        ErrorStore_Status.Sequence = sequence;
+        ErrorStore_Status.Writes++;
+    }
+    else
+    {
+        /* The records are lost from the store but the new error is logged
+        and saved with the next row */
+        ErrorStore_Status.WriteErrors++;
+        Log_Error(SYSTEM_PROCESS_ID, SYSTEM_ERROR_FLASH_WRITE);
+    }
+}
+
+/* Copy a row to RAM, TRUE if it holds a complete row for its place */
+static uint8 ErrorStore_LoadRow(uint8 Row, ERROR_STORE_ROW * Buffer)
+{
+    uint16 i;
+    const volatile uint8 * flash = &ERROR_STORE_FLASH[(uint32)Row * CY_FLASH_SIZEOF_ROW];
+    uint8 * data = (uint8 *)Buffer;
+
+    ErrorStore_Reads++;
+
+    for(i = 0u; i < CY_FLASH_SIZEOF_ROW; i++)
+    {
+        data[i] = flash[i];
+    }
+
+    return ((Buffer->Sequence != 0u) &&
+            (((Buffer->Sequence - 1u) & ERROR_STORE_ROW_MASK) == Row) &&
+            (Buffer->Count <= ERROR_STORE_RECORDS_PER_ROW) &&
+            (ErrorStore_Sum(data) == 0u)) ? TRUE : FALSE;
+}
+
+/* 8 bit sum of a row */
+static uint8 ErrorStore_Sum(const uint8 * Data)
+{
+    uint16 i;
+    uint8 sum = 0u;
+
+    for(i = 0u; i < CY_FLASH_SIZEOF_ROW; i++)
+    {
+        sum += Data[i];
+    }
+
+    return sum;
+}
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,73 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         ErrorStore.h
+********************************************************************************
+* Description:
+*  Contains defines, function prototypes, and macros for the error store,
+*  which saves the error log to flash so it survives a reset.
+*
+*  The store is a log of ERROR_STORE_ROWS flash rows written round robin, so
+*  every row wears at the same rate.  A row holds a header and up to
+*  ERROR_STORE_RECORDS_PER_ROW records that had changed in the RAM log, see
+*  ErrorLog_TakeChanged().  A record that repeats after it was saved is saved
+*  again, the newest copy has the total count.  Rows are numbered by a
+*  sequence that runs over every row ever written, so row
+*  (Sequence - 1) % ERROR_STORE_ROWS holds Sequence and a torn row fails its
+*  checksum.  At start up a binary search over the row sequences finds the
+*  newest row, reading log2(ERROR_STORE_ROWS) + 1 rows.
+*
+*  A row write stalls the CPU for milliseconds, so rows are only written
+*  from the co-op loop when the processes are done and the radio is idle,
+*  see mBLE_IsRadioIdle(), and only when a full row of records has changed
+*  or the oldest change is ERROR_STORE_FLUSH_MS old.  Rows are at least
+*  ERROR_STORE_MIN_INTERVAL_MS apart however fast errors come.
+*
+********************************************************************************
+*/
+#ifndef ERRORSTORE_H
+#define ERRORSTORE_H
+
+#include "main.h"
+
+/* Must be a power of 2 */
+#define ERROR_STORE_ROWS                (8u)
+#define ERROR_STORE_ROW_MASK            (ERROR_STORE_ROWS - 1u)
+#define ERROR_STORE_FLUSH_MS            (60000u)
+#define ERROR_STORE_MIN_INTERVAL_MS     (10000u)
+
+/* Row header, 8 bytes, the rest of the row is records */
+#define ERROR_STORE_HEADER_SIZE         (8u)
+#define ERROR_STORE_RECORDS_PER_ROW     ((CY_FLASH_SIZEOF_ROW - ERROR_STORE_HEADER_SIZE) / 8u)
+
+#if ((ERROR_STORE_ROWS & ERROR_STORE_ROW_MASK) != 0u)
+    #error ERROR_STORE_ROWS must be a power of 2
+#endif
+
+/* One flash row */
+typedef struct
+{
+    uint32 Sequence;            /* rows ever written up to this one, 0 in an erased row */
+    uint16 Boot;                /* start up the records were logged in, 1 for the first */
+    uint8 Count;                /* records used */
+    uint8 Checksum;             /* the bytes of the row sum to 0 */
+    ERROR_RECORD Record[ERROR_STORE_RECORDS_PER_ROW];
+} ERROR_STORE_ROW;
+
+typedef struct
+{
+    uint32 Sequence;            /* newest row, 0 while the store is empty */
+    uint16 Boot;                /* this start up */
+    uint16 Writes;              /* rows written since start up */
+    uint16 WriteErrors;
+    uint8 RecoveryReads;        /* rows read to find the newest at start up */
+} ERROR_STORE_STATUS;
+
+/* Function Prototypes */
+void ErrorStore_Init(void);
+void ErrorStore_Service(void);
+uint8 ErrorStore_ReadRow(uint8 Age, ERROR_STORE_ROW * Row);
+
+extern ERROR_STORE_STATUS ErrorStore_Status;
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,170 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         Event.c
+********************************************************************************
+* Description:
+*  Single producer, single consumer event rings between the interrupts and
+*  the co-op loop, see Event.h.
+*
+********************************************************************************
+*/
+#include "Event.h"
+
+EVENT_RING Event_Ring[NUMBER_OF_EVENT_SOURCES];
+
+/* Newest event routed from each source */
+EVENT Event_Last[NUMBER_OF_EVENT_SOURCES];
+
+/* Process that owns each source.  Event_Route() queues the owner for every
+event, PROCESS_NONE leaves the source to the co-op loop itself */
+static const uint8 Event_Owner[NUMBER_OF_EVENT_SOURCES] =
+{
+    /* v------------- ADD YOUR SOURCE HERE -------------v */
+    [EVENT_SOURCE_COOP_TICK]    = PROCESS_NONE,
+    [EVENT_SOURCE_CSD_SCAN]     = TOUCH_PROCESS,
+    [EVENT_SOURCE_BLE]          = BLE_PROCESS,
+    [EVENT_SOURCE_ONESHOT]      = PROCESS_NONE,
+    /* ^------------- ADD YOUR SOURCE HERE -------------^ */
+};
+
+/*******************************************************************************
+* Function Name: Event_Post
+********************************************************************************
+*
+* Summary:
+*  Adds an event to the ring of its source.  Only the interrupt that owns the
+*  source may call this.  The record is written before Head moves, so the
+*  co-op loop never sees a partly written event.
+*
+* Parameters:
+*  uint8 Source:   EVENT_SOURCE_ of the calling interrupt.
+*  uint16 Payload: Source specific data.
+*
+* Return:
+*  TRUE, or FALSE if the ring was full and the event was dropped.
+*
+*******************************************************************************/
+uint8 Event_Post(uint8 Source, uint16 Payload)
+{
+    EVENT_RING * ring = &Event_Ring[Source];
+    uint8 head = ring->Head;
+    EVENT * event;
+
+    if((uint8)(head - ring->Tail) >= EVENT_RING_SIZE)
+    {
+        if(ring->Dropped < 0xFFFFu)
+        {
+            ring->Dropped++;
+        }
+        return FALSE;
+    }
+
+    event = &ring->Events[head & EVENT_RING_MASK];
+    event->Timestamp = WatchdogTimer_GetTimestamp();
+    event->Payload = Payload;
+    event->Source = Source;
+
+    /* Publish the event */
+    ring->Head = head + 1u;
+
+    return TRUE;
+}
+
+/*******************************************************************************
+* Function Name: Event_Take
+********************************************************************************
+*
+* Summary:
+*  Takes the oldest event of a source.  Only the co-op loop may call this.
+*
+* Parameters:
+*  uint8 Source:  EVENT_SOURCE_ to take from.
+*  EVENT * Event: Output, the event.
+*
+* Return:
+*  TRUE if an event was taken, FALSE if the ring was empty.
+*
+*******************************************************************************/
+uint8 Event_Take(uint8 Source, EVENT * Event)
+{
+    EVENT_RING * ring = &Event_Ring[Source];
+    uint8 tail = ring->Tail;
+
+    if(tail == ring->Head)
+    {
+        return FALSE;
+    }
+
+    *Event = ring->Events[tail & EVENT_RING_MASK];
+
+    /* Hand the slot back to the interrupt */
+    ring->Tail = tail + 1u;
+
+    return TRUE;
+}
+
+/*******************************************************************************
+* Function Name: Event_IsAnyPending
+********************************************************************************
+*
+* Summary:
+*  Checks every source for events the co-op loop has not taken yet.  The
+*  system must not sleep while this is TRUE.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  TRUE if any source has a pending event.
+*
+*******************************************************************************/
+uint8 Event_IsAnyPending(void)
+{
+    uint8 source;
+
+    for(source = 0u; source < NUMBER_OF_EVENT_SOURCES; source++)
+    {
+        if(mEvent_IsPending(source))
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*******************************************************************************
+* Function Name: Event_Route
+********************************************************************************
+*
+* Summary:
+*  Takes every pending event of the sources that have an owner, queues the
+*  owner and keeps the newest event of each source for it, see
+*  mEvent_GetLast().
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Event_Route(void)
+{
+    uint8 source;
+
+    for(source = 0u; source < NUMBER_OF_EVENT_SOURCES; source++)
+    {
+        if(Event_Owner[source] != PROCESS_NONE)
+        {
+            while(Event_Take(source, &Event_Last[source]))
+            {
+                mProcess_Queue(Event_Owner[source]);
+            }
+        }
+    }
+
+    return;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,76 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         Event.h
+********************************************************************************
+* Description:
+*  Contains defines, function prototypes, and macros for the interrupt event
+*  rings.  Interrupts post small event records (source, timestamp, payload)
+*  and the co-op loop takes them and routes each one to the process that owns
+*  its source.
+*
+*  Every source has its own ring with exactly one producer, its interrupt,
+*  and one consumer, the co-op loop.  The producer only writes Head and the
+*  consumer only writes Tail, so neither side has to disable interrupts and
+*  two events of the same source never collapse into one.  Sharing a ring
+*  between two interrupts would break this, give the new interrupt its own
+*  source instead.
+*
+********************************************************************************
+*/
+#ifndef EVENT_H
+#define EVENT_H
+
+#include "main.h"
+
+/* Event sources, one per posting interrupt */
+/* v------------- ADD YOUR SOURCE HERE -------------v */
+#define EVENT_SOURCE_COOP_TICK          (0u)    /* WatchdogTimer_Isr, payload: ms in the interval */
+#define EVENT_SOURCE_CSD_SCAN           (1u)    /* CapSense_ISR, end of scan */
+#define EVENT_SOURCE_BLE                (2u)    /* BLE_Bless_Isr, the stack has events to process */
+#define EVENT_SOURCE_ONESHOT            (3u)    /* WatchdogTimer_Isr, WDT counter 1 alarm */
+#define NUMBER_OF_EVENT_SOURCES         (4u)
+/* ^------------- ADD YOUR SOURCE HERE -------------^ */
+
+/* Events each ring holds.  Must be a power of 2 no larger than 128 so the free
+running 8 bit indexes wrap cleanly */
+#define EVENT_RING_SIZE                 (4u)
+#define EVENT_RING_MASK                 (EVENT_RING_SIZE - 1u)
+
+#if ((EVENT_RING_SIZE & EVENT_RING_MASK) != 0u) || (EVENT_RING_SIZE > 128u)
+    #error EVENT_RING_SIZE must be a power of 2 no larger than 128
+#endif
+
+typedef struct
+{
+    uint32 Timestamp;                   /* System timestamp when the event was posted */
+    uint16 Payload;                     /* Source specific */
+    uint8 Source;                       /* EVENT_SOURCE_ */
+} EVENT;
+
+/* Head and Tail run freely, the ring holds Head - Tail events */
+typedef struct
+{
+    EVENT Events[EVENT_RING_SIZE];
+    volatile uint8 Head;                /* Written by the interrupt only */
+    volatile uint8 Tail;                /* Written by the co-op loop only */
+    uint16 Dropped;                     /* Events lost to a full ring, written by the interrupt */
+} EVENT_RING;
+
+extern EVENT_RING Event_Ring[NUMBER_OF_EVENT_SOURCES];
+extern EVENT Event_Last[NUMBER_OF_EVENT_SOURCES];
+
+/* Function Prototypes */
+uint8 Event_Post(uint8 Source, uint16 Payload);
+uint8 Event_Take(uint8 Source, EVENT * Event);
+uint8 Event_IsAnyPending(void);
+void Event_Route(void);
+
+/* Macros */
+/* Non zero if the source has events the co-op loop has not taken yet */
+#define mEvent_IsPending(SOURCE)        (Event_Ring[SOURCE].Head != Event_Ring[SOURCE].Tail)
+
+/* The newest event Event_Route() handed to the owner of the source */
+#define mEvent_GetLast(SOURCE)          (Event_Last[SOURCE])
+
+#endif
+/* [] END OF FILE */
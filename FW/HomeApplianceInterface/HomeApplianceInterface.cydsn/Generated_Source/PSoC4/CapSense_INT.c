@@ -105,8 +105,8 @@ CY_ISR(CapSense_ISR)
 	
 	/*  Place your Interrupt code here. */
     /* `#START CapSense_ISR_EXIT` */
-    /* Set flag indicating we woke up from a CSD scan */
-    WakeupSource |= CSD_SCAN;
+    /* Tell the co-op loop we woke up from a CSD scan */
+    Event_Post(EVENT_SOURCE_CSD_SCAN, 0u);
     /* `#END` */
 }
 
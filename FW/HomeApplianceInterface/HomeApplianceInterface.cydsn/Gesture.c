@@ -0,0 +1,501 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         Gesture.c
+********************************************************************************
+* Description:
+*  Table driven slider gesture engine, see Gesture.h.
+*
+********************************************************************************
+*/
+#include "Gesture.h"
+
+/* Milliseconds from clock counts are a shift */
+#if ((WATCHDOG_COUNTS_PER_MS & (WATCHDOG_COUNTS_PER_MS - 1u)) != 0u)
+    #error WATCHDOG_COUNTS_PER_MS must be a power of 2
+#endif
+
+/***************************************
+*    TUNABLE GESTURE PARAMETERS        *
+****************************************/
+/* Checked in order, the first rule that matches wins, so the stricter of two
+overlapping rules goes first.  Distances are centroid counts, MaxMs is
+exclusive and a MaxDistance of 0xFF is no limit */
+#define GESTURE_RULES                   (8u)
+static const GESTURE_RULE Gesture_Rules[GESTURE_RULES] =
+{
+    /* Gesture                      Trigger                   MinMs  MaxMs  MinDist MaxDist Direction                After        AfterMs MinSpeed */
+    { LONG_PRESS_GESTURE,           GESTURE_TRIGGER_HOLD,     800u,    0u,    0u,    8u, GESTURE_DIRECTION_ANY,   NO_GESTURE,    0u,    0u },
+    { SLIDE_GESTURE,                GESTURE_TRIGGER_SLIDE,    400u,    0u,    4u,    8u, GESTURE_DIRECTION_ANY,   NO_GESTURE,    0u,    0u },
+    { DOUBLE_TAP_GESTURE,           GESTURE_TRIGGER_RELEASE,    0u,  400u,    0u,   14u, GESTURE_DIRECTION_ANY,   TAP_GESTURE, 300u,    0u },
+    { TAP_GESTURE,                  GESTURE_TRIGGER_RELEASE,    0u,  500u,    0u,   14u, GESTURE_DIRECTION_ANY,   NO_GESTURE,    0u,    0u },
+    { SWIPE_LEFT_LONG_GESTURE,      GESTURE_TRIGGER_RELEASE,    0u,  500u,   61u, 0xFFu, GESTURE_DIRECTION_LEFT,  NO_GESTURE,    0u,    0u },
+    { SWIPE_RIGHT_LONG_GESTURE,     GESTURE_TRIGGER_RELEASE,    0u,  500u,   61u, 0xFFu, GESTURE_DIRECTION_RIGHT, NO_GESTURE,    0u,    0u },
+    { SWIPE_LEFT_GESTURE,           GESTURE_TRIGGER_RELEASE,    0u,  500u,   31u, 0xFFu, GESTURE_DIRECTION_LEFT,  NO_GESTURE,    0u,    0u },
+    { SWIPE_RIGHT_GESTURE,          GESTURE_TRIGGER_RELEASE,    0u,  500u,   31u, 0xFFu, GESTURE_DIRECTION_RIGHT, NO_GESTURE,    0u,    0u },
+};
+
+static const GESTURE_CONFIG Gesture_Config =
+{
+    10u,                        /* LargeObjectScans */
+    1u,                         /* FilterShift */
+    15u,                        /* TurnBack */
+};
+
+/* Centroids the median is taken over */
+#define GESTURE_MEDIAN                  (3u)
+
+/* The touch being followed */
+typedef struct
+{
+    uint32 DownCounts;          /* clock at touch down */
+    uint32 PreviousUpCounts;    /* clock at the lift off of the touch before */
+    uint16 Armed;               /* slide rules that have seen the touch hold still */
+    uint16 Fired;               /* hold and slide rules that fired */
+    uint8 Touching;
+    uint8 Large;                /* a large object until the slider is released */
+    uint8 LargeScans;
+    uint8 Start;                /* centroid at touch down */
+    uint8 Last;                 /* latest centroid */
+    uint8 Excursion;            /* furthest from Start so far */
+    uint8 SlideFrom;            /* centroid of the last slide */
+    uint8 Previous;             /* release gesture of the touch before */
+    uint8 Raw[GESTURE_MEDIAN];  /* latest centroids, unfiltered */
+    uint8 RawCount;
+    uint16 Filtered;            /* IIR output, GESTURE_FILTER_FRACTION fraction bits */
+    GESTURE_SAMPLE Samples[GESTURE_SAMPLES];
+    uint8 SampleHead;           /* slot of the next sample */
+    uint8 SampleCount;
+} GESTURE_TRACK;
+
+static GESTURE_TRACK Gesture_Track;
+
+#if (GESTURE_RULES > GESTURE_RULES_MAX)
+    #error Gesture_Rules has more than GESTURE_RULES_MAX rules
+#endif
+
+/* Local Function Declarations */
+static uint16 Gesture_Ms(uint32 Counts);
+static uint8 Gesture_Distance(uint8 From, uint8 To);
+static uint8 Gesture_Direction(uint8 From, uint8 To);
+static uint8 Gesture_Filter(uint8 Centroid);
+static uint8 Gesture_Median3(uint8 A, uint8 B, uint8 C);
+static void Gesture_AddSample(uint16 Ms, uint8 Centroid);
+static void Gesture_Fit(int32 * Slope, int32 * Spread);
+static uint8 Gesture_CheckHeld(uint16 HeldMs);
+static uint8 Gesture_CheckRelease(uint16 HeldMs);
+
+/*******************************************************************************
+* Function Name: Gesture_Init
+********************************************************************************
+*
+* Summary:
+*  Forgets any touch in progress.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Gesture_Init(void)
+{
+    Gesture_Track.Touching = FALSE;
+    Gesture_Track.Large = FALSE;
+    Gesture_Track.LargeScans = 0u;
+    Gesture_Track.Previous = NO_GESTURE;
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Gesture_Update
+********************************************************************************
+*
+* Summary:
+*  Follows the touch with the result of one scan.
+*
+* Parameters:
+*  uint8 SensorOnMask: CapSense_sensorOnMask[0].
+*  uint8 Centroid:     Slider centroid, NO_TOUCH for none, unfiltered.
+*  uint32 NowCounts:   WatchdogTimer_GetCount() at the scan.
+*
+* Return:
+*  The gesture of this scan, NO_GESTURE for none.  LARGE_OBJECT is returned
+*  every scan from when every slider sensor has been on for
+*  LargeObjectScans scans until the slider is released, and cancels the
+*  touch.
+*
+* Theory:
+*  A scan that has slider sensors on but no centroid keeps the touch as it
+*  was, the touch only lifts off when no slider sensor is on.
+*
+*******************************************************************************/
+uint8 Gesture_Update(uint8 SensorOnMask, uint8 Centroid, uint32 NowCounts)
+{
+    uint8 gesture = NO_GESTURE;
+    uint8 distance;
+    uint16 ms;
+    uint8 slider = SensorOnMask & SLIDER_MASK;
+    GESTURE_TRACK * track = &Gesture_Track;
+
+    /* Large object rejection, every slider sensor on for a while */
+    if(slider == SLIDER_MASK)
+    {
+        if(track->LargeScans < Gesture_Config.LargeObjectScans)
+        {
+            track->LargeScans++;
+        }
+        if(track->LargeScans >= Gesture_Config.LargeObjectScans)
+        {
+            track->Large = TRUE;
+            track->Touching = FALSE;
+        }
+    }
+    else
+    {
+        track->LargeScans = 0u;
+    }
+
+    if(slider == 0u)
+    {
+        track->Large = FALSE;
+    }
+
+    if(track->Large)
+    {
+        return LARGE_OBJECT;
+    }
+
+    if((slider != 0u) && (Centroid != NO_TOUCH))
+    {
+        if(!track->Touching)
+        {
+            track->Touching = TRUE;
+            track->DownCounts = NowCounts;
+            track->Excursion = 0u;
+            track->Armed = 0u;
+            track->Fired = 0u;
+            track->RawCount = 0u;
+            track->SampleCount = 0u;
+        }
+        track->Last = Gesture_Filter(Centroid);
+        if(track->SampleCount == 0u)
+        {
+            track->Start = track->Last;
+        }
+
+        ms = Gesture_Ms(NowCounts - track->DownCounts);
+        Gesture_AddSample(ms, track->Last);
+
+        distance = Gesture_Distance(track->Start, track->Last);
+        if(distance > track->Excursion)
+        {
+            track->Excursion = distance;
+        }
+
+        gesture = Gesture_CheckHeld(ms);
+    }
+    else if((slider == 0u) && track->Touching)
+    {
+        track->Touching = FALSE;
+
+        /* A touch that held or slid is done with */
+        if(track->Fired == 0u)
+        {
+            gesture = Gesture_CheckRelease(Gesture_Ms(NowCounts - track->DownCounts));
+        }
+        track->Previous = gesture;
+        track->PreviousUpCounts = NowCounts;
+    }
+
+    return gesture;
+}
+
+/*******************************************************************************
+* Function Name: Gesture_IsTouching
+********************************************************************************
+*
+* Summary:
+*  Tells if a touch is being followed, from the scan that saw it come down to
+*  the scan that saw it lift off.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  TRUE while touching.
+*
+*******************************************************************************/
+uint8 Gesture_IsTouching(void)
+{
+    return Gesture_Track.Touching;
+}
+
+/* Milliseconds in a span of clock counts, saturated */
+static uint16 Gesture_Ms(uint32 Counts)
+{
+    uint32 ms = Counts / WATCHDOG_COUNTS_PER_MS;
+
+    return (ms > 0xFFFFu) ? 0xFFFFu : (uint16)ms;
+}
+
+static uint8 Gesture_Distance(uint8 From, uint8 To)
+{
+    return (To > From) ? (To - From) : (From - To);
+}
+
+static uint8 Gesture_Direction(uint8 From, uint8 To)
+{
+    if(To > From)
+    {
+        return GESTURE_DIRECTION_RIGHT;
+    }
+
+    return (To < From) ? GESTURE_DIRECTION_LEFT : GESTURE_DIRECTION_ANY;
+}
+
+/* Hold and slide rules while touching, the first that fires wins */
+static uint8 Gesture_CheckHeld(uint16 HeldMs)
+{
+    uint8 i;
+    uint16 bit;
+    const GESTURE_RULE * rule;
+    GESTURE_TRACK * track = &Gesture_Track;
+
+    for(i = 0u; i < GESTURE_RULES; i++)
+    {
+        rule = &Gesture_Rules[i];
+        bit = (uint16)1u << i;
+
+        if((rule->Trigger == GESTURE_TRIGGER_RELEASE) || (HeldMs < rule->MinMs))
+        {
+            continue;
+        }
+
+        if(rule->Trigger == GESTURE_TRIGGER_HOLD)
+        {
+            if(((track->Fired & bit) == 0u) && (track->Excursion <= rule->MaxDistance))
+            {
+                track->Fired |= bit;
+                return rule->Gesture;
+            }
+        }
+        else
+        {
+            /* Arm on the first scan past MinMs if the touch held still */
+            if((track->Armed & bit) == 0u)
+            {
+                if(track->Excursion <= rule->MaxDistance)
+                {
+                    track->Armed |= bit;
+                    track->SlideFrom = track->Last;
+                }
+            }
+            else if((Gesture_Distance(track->SlideFrom, track->Last) >= rule->MinDistance) &&
+                    ((rule->Direction == GESTURE_DIRECTION_ANY) ||
+                     (rule->Direction == Gesture_Direction(track->SlideFrom, track->Last))))
+            {
+                track->Fired |= bit;
+                track->SlideFrom = track->Last;
+                return rule->Gesture;
+            }
+        }
+    }
+
+    return NO_GESTURE;
+}
+
+/* Release rules at lift off, the first that matches wins */
+static uint8 Gesture_CheckRelease(uint16 HeldMs)
+{
+    uint8 i;
+    uint8 distance;
+    uint8 direction;
+    uint16 gapMs;
+    int32 slope;
+    int32 spread;
+    uint32 speed;
+    uint32 time;
+    const GESTURE_RULE * rule;
+    GESTURE_TRACK * track = &Gesture_Track;
+
+    distance = Gesture_Distance(track->Start, track->Last);
+    direction = Gesture_Direction(track->Start, track->Last);
+    gapMs = Gesture_Ms(track->DownCounts - track->PreviousUpCounts);
+
+    /* A touch that turned back has no direction, nor does one whose fitted
+    line disagrees with where it ended up */
+    if((track->Excursion - distance) > Gesture_Config.TurnBack)
+    {
+        direction = GESTURE_DIRECTION_ANY;
+    }
+
+    /* The speed is slope / spread centroid counts per ms */
+    Gesture_Fit(&slope, &spread);
+    if(spread > 0)
+    {
+        if(((slope > 0) && (direction != GESTURE_DIRECTION_RIGHT)) ||
+           ((slope < 0) && (direction != GESTURE_DIRECTION_LEFT)))
+        {
+            direction = GESTURE_DIRECTION_ANY;
+        }
+        speed = (uint32)((slope < 0) ? -slope : slope);
+        time = (uint32)spread;
+    }
+    else
+    {
+        /* Too short to fit, from touch down to lift off */
+        speed = distance;
+        time = HeldMs;
+    }
+
+    for(i = 0u; i < GESTURE_RULES; i++)
+    {
+        rule = &Gesture_Rules[i];
+
+        if((rule->Trigger != GESTURE_TRIGGER_RELEASE) ||
+           (HeldMs < rule->MinMs) ||
+           ((rule->MaxMs != 0u) && (HeldMs >= rule->MaxMs)) ||
+           (distance < rule->MinDistance) ||
+           (distance > rule->MaxDistance))
+        {
+            continue;
+        }
+
+        if((rule->Direction != GESTURE_DIRECTION_ANY) && (rule->Direction != direction))
+        {
+            continue;
+        }
+
+        if((rule->After != NO_GESTURE) &&
+           ((track->Previous != rule->After) || (gapMs > rule->AfterMs)))
+        {
+            continue;
+        }
+
+        /* speed / time >= MinSpeed / 1000, multiplied out */
+        if(((uint64)speed * 1000u) < ((uint64)rule->MinSpeed * time))
+        {
+            continue;
+        }
+
+        return rule->Gesture;
+    }
+
+    return NO_GESTURE;
+}
+
+/* Median of 3 then IIR, the first centroid of a touch goes straight through */
+static uint8 Gesture_Filter(uint8 Centroid)
+{
+    GESTURE_TRACK * track = &Gesture_Track;
+    uint8 median = Centroid;
+    int16 step;
+
+    track->Raw[0u] = track->Raw[1u];
+    track->Raw[1u] = track->Raw[2u];
+    track->Raw[2u] = Centroid;
+    if(track->RawCount < GESTURE_MEDIAN)
+    {
+        track->RawCount++;
+    }
+    else
+    {
+        median = Gesture_Median3(track->Raw[0u], track->Raw[1u], track->Raw[2u]);
+    }
+
+    if(track->RawCount == 1u)
+    {
+        track->Filtered = (uint16)median << GESTURE_FILTER_FRACTION;
+    }
+    else
+    {
+        step = (int16)(((uint16)median << GESTURE_FILTER_FRACTION) - track->Filtered);
+        track->Filtered = (uint16)((int16)track->Filtered + (step >> Gesture_Config.FilterShift));
+    }
+
+    /* Round to the nearest count */
+    return (uint8)((track->Filtered + (1u << (GESTURE_FILTER_FRACTION - 1u))) >> GESTURE_FILTER_FRACTION);
+}
+
+static uint8 Gesture_Median3(uint8 A, uint8 B, uint8 C)
+{
+    uint8 swap;
+
+    if(A > B)
+    {
+        swap = A;
+        A = B;
+        B = swap;
+    }
+    if(C < B)
+    {
+        B = (C > A) ? C : A;
+    }
+
+    return B;
+}
+
+/* Write a sample to the head of the ring, the oldest goes when it is full */
+static void Gesture_AddSample(uint16 Ms, uint8 Centroid)
+{
+    GESTURE_TRACK * track = &Gesture_Track;
+
+    track->Samples[track->SampleHead].Ms = Ms;
+    track->Samples[track->SampleHead].Centroid = Centroid;
+    track->SampleHead = (track->SampleHead + 1u) & GESTURE_SAMPLE_MASK;
+    if(track->SampleCount < GESTURE_SAMPLES)
+    {
+        track->SampleCount++;
+    }
+}
+
+/*******************************************************************************
+* Least squares line through the samples of the touch.  The slope is
+*  Slope / Spread centroid counts per ms, with
+*   Slope  = n * Sum(t * x) - Sum(t) * Sum(x)
+*   Spread = n * Sum(t * t) - Sum(t) * Sum(t)
+*  and Spread is 0 when the samples do not span any time.  The times are from
+*  the oldest sample, saturated to GESTURE_SAMPLE_MS_MAX, which keeps every
+*  sum in 32 bits.
+*******************************************************************************/
+static void Gesture_Fit(int32 * Slope, int32 * Spread)
+{
+    GESTURE_TRACK * track = &Gesture_Track;
+    const GESTURE_SAMPLE * sample;
+    uint8 i;
+    uint8 slot;
+    int32 n = track->SampleCount;
+    int32 t;
+    int32 x;
+    int32 sumT = 0;
+    int32 sumX = 0;
+    int32 sumTT = 0;
+    int32 sumTX = 0;
+    uint16 oldestMs;
+
+    slot = (track->SampleHead - track->SampleCount) & GESTURE_SAMPLE_MASK;
+    oldestMs = track->Samples[slot].Ms;
+
+    for(i = 0u; i < track->SampleCount; i++)
+    {
+        sample = &track->Samples[(slot + i) & GESTURE_SAMPLE_MASK];
+        t = sample->Ms - oldestMs;
+        if(t > (int32)GESTURE_SAMPLE_MS_MAX)
+        {
+            t = GESTURE_SAMPLE_MS_MAX;
+        }
+        x = sample->Centroid;
+
+        sumT += t;
+        sumX += x;
+        sumTT += t * t;
+        sumTX += t * x;
+    }
+
+    *Slope = (n * sumTX) - (sumT * sumX);
+    *Spread = (n * sumTT) - (sumT * sumT);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,103 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         Gesture.h
+********************************************************************************
+* Description:
+*  Contains defines, function prototypes, and macros for the slider gesture
+*  engine.
+*
+*  The touch process feeds the engine one sample per scan, see
+*  Gesture_Update().  The engine follows the touch from touch down to lift
+*  off and checks the rules of Gesture_Rules[] (Gesture.c) in order, the
+*  first rule that matches is the gesture.  A rule fires:
+*   - GESTURE_TRIGGER_RELEASE: at lift off, on the time held, the distance
+*     and direction from touch down to lift off and the speed, optionally
+*     only right after another gesture (double tap).
+*   - GESTURE_TRIGGER_HOLD: once per touch, while a touch has stayed within
+*     MaxDistance of where it came down for MinMs (long press).
+*   - GESTURE_TRIGGER_SLIDE: once a touch has stayed still for MinMs, every
+*     time it has moved MinDistance since the last slide, so the position
+*     can set a level (press and slide dimming).
+*  A touch that fired a hold or slide gesture does not also fire a release
+*  gesture.  Moving the thresholds or adding a gesture is an edit of the
+*  table, the engine does not change.
+*
+*  Every centroid goes through a median of 3, which drops a single noisy
+*  sample, and an IIR low pass before the engine uses it.  The filtered
+*  centroids of the last GESTURE_SAMPLES scans of the touch are kept with
+*  their times, and at lift off the direction and speed are the least
+*  squares slope over them, so a swipe that reverses or jitters at lift off
+*  is not taken for one in the other direction.  A touch that ends more than
+*  TurnBack short of the furthest it went has no direction at all.
+*
+*  Times come from the WDT clock (WatchdogTimer_GetCount()) and are compared
+*  in milliseconds, the conversion is a shift.  Speeds are compared by cross
+*  multiplying, so the engine has no divisions.  Every scan checks each rule
+*  at most once and lift off fits the line through GESTURE_SAMPLES samples,
+*  the RAM is the one GESTURE_TRACK.
+*
+********************************************************************************
+*/
+#ifndef GESTURE_H
+#define GESTURE_H
+
+#include "main.h"
+
+/* Rule triggers */
+#define GESTURE_TRIGGER_RELEASE         (0u)
+#define GESTURE_TRIGGER_HOLD            (1u)
+#define GESTURE_TRIGGER_SLIDE           (2u)
+
+/* Rule directions, the centroid grows to the right */
+#define GESTURE_DIRECTION_ANY           (0u)
+#define GESTURE_DIRECTION_LEFT          (1u)
+#define GESTURE_DIRECTION_RIGHT         (2u)
+
+/* Up to 16 rules, one bit each for the rules that fired during a touch */
+#define GESTURE_RULES_MAX               (16u)
+
+/* Samples of the touch the velocity is fitted to, a power of 2.  16 is the
+last 150 ms of a touch at the active scan period */
+#define GESTURE_SAMPLES                 (16u)
+#define GESTURE_SAMPLE_MASK             (GESTURE_SAMPLES - 1u)
+/* Sample times are saturated so the sums of the fit fit 32 bits */
+#define GESTURE_SAMPLE_MS_MAX           (1023u)
+/* Fraction bits of the filtered centroid */
+#define GESTURE_FILTER_FRACTION         (4u)
+
+typedef struct
+{
+    uint8 Gesture;              /* GESTURE CODE reported, see Touch.h */
+    uint8 Trigger;              /* GESTURE_TRIGGER_ */
+    uint16 MinMs;               /* time held */
+    uint16 MaxMs;               /* 0 for no limit */
+    uint8 MinDistance;          /* centroid counts, a slide step for GESTURE_TRIGGER_SLIDE */
+    uint8 MaxDistance;          /* how still a hold or slide has to start */
+    uint8 Direction;            /* GESTURE_DIRECTION_ */
+    uint8 After;                /* gesture that must come just before, NO_GESTURE for any */
+    uint16 AfterMs;             /* most time from the lift off of After to this touch down */
+    uint16 MinSpeed;            /* centroid counts per second at lift off, 0 for any */
+} GESTURE_RULE;
+
+/* Tunables that are not per rule */
+typedef struct
+{
+    uint8 LargeObjectScans;     /* scans with every slider sensor on before a large object */
+    uint8 FilterShift;          /* IIR weight of a new centroid is 1 / 2^FilterShift, 0 for no filter */
+    uint8 TurnBack;             /* centroid counts a touch may end short of its furthest point and keep its direction */
+} GESTURE_CONFIG;
+
+/* A filtered centroid of the touch */
+typedef struct
+{
+    uint16 Ms;                  /* since touch down, saturated */
+    uint8 Centroid;
+} GESTURE_SAMPLE;
+
+/* Function Prototypes */
+void Gesture_Init(void);
+uint8 Gesture_Update(uint8 SensorOnMask, uint8 Centroid, uint32 NowCounts);
+uint8 Gesture_IsTouching(void);
+
+#endif
+/* [] END OF FILE */
@@ -14,50 +14,50 @@
 #include "LED.h"
 #include "BLE.h"
 
-#if (PROCESS_DEBUG_ENABLED == 1u)
+#if (DEBUG_POINTERS_ENABLED == 1u)
     uint8 * LED_DebugOutput;
 #endif
 
-uint8 LED_Enable = LED_ENABLE_INIT;
-uint16 LED_Timer_Count = LED_PROCESS_PERIOD_INIT;
-uint16 LED_Period = LED_PROCESS_PERIOD_INIT;
-T_LED_STATE s_LED_State = S_LED_STATE_INIT;
-
-uint8 LED_SleepCountInit = 0u;
-uint8 LED_SleepCounter8;
-uint16 LED_SleepCounter16;
-
 /* used for testing CSD slider */
 uint16 SliderPosition;
 uint8 EDA_Result;
 
 /* Variables used for updating LEDs based on Touch Gestures */
 static uint8 Gesture;
-static uint32 LED_Timer;
+static TOUCH_EVENT LED_Event;
 
 /* Initialize the Process */
 void LED_Process_Init(void)
 {
-    #if (PROCESS_DEBUG_ENABLED == 1u)
+    #if (DEBUG_POINTERS_ENABLED == 1u)
         if(TestMux_Register(LED_PROCESS_ID, &LED_DebugOutput)  == TESTMUX_FAIL)
         {
             Log_Error(LED_PROCESS_ID, LED_ERROR_FAILED_TO_REGISTER_TESTMUX);
         }
     #endif
     
+    #if (LED_UPDATE_SOURCE == UPDATE_FROM_TOUCH)
+    /* The touch process queues us when it has a gesture.  The process timer
+    only runs while the LEDs are on, to turn them off again */
+    Touch_Subscribe(TOUCH_CONSUMER_LED, TOUCH_INTEREST_ALL);
+    mProcess_SetPeriod(LED_PROCESS, LED_ON_TIME_MS);
+    mProcess_SetTimer(LED_PROCESS, LED_ON_TIME_MS);
+    mProcess_Disable(LED_PROCESS);
+    #else
     /* Run the LED process everytime through the loop */
-    LED_Period = 1;
-    LED_Timer_Count = 1;
-    mLED_EnableProcess();
-    mLED_SetNextState(LED_STATE_1);
+    mProcess_SetPeriod(LED_PROCESS, SYSTEM_TICK_TIME_MS);
+    mProcess_SetTimer(LED_PROCESS, SYSTEM_TICK_TIME_MS);
+    mProcess_Enable(LED_PROCESS);
+    #endif
+    mProcess_SetNextState(LED_PROCESS, LED_STATE_1);
     
     /* Turn off RGB LED */
     BLUE_P3_7_Write(1);
     GREEN_P3_6_Write(1);
     RED_P2_6_Write(1);
     
-    //mLED_DisallowSleep();
-    //mLED_DisallowAltActive();
+    //mProcess_DisallowSleep(LED_PROCESS);
+    //mProcess_DisallowDeepSleep(LED_PROCESS);
     return;
 }
 
@@ -97,27 +97,47 @@ void LED_Process(void)
     
     #elif (LED_UPDATE_SOURCE == UPDATE_FROM_TOUCH)
     
-    /* Update LEDs based on Touch Gesture */
-    Gesture = GetGesture();
+    /* Update LEDs based on Touch Gesture.  One gesture per run, the oldest
+    one we have not shown, and every gesture queues us.  Gestures that came
+    faster than we ran show one after the other in the order they were made,
+    so a new gesture waits behind the ones before it */
+    Gesture = NO_GESTURE;
+    if(Touch_TakeEvent(TOUCH_CONSUMER_LED, &LED_Event))
+    {
+        Gesture = LED_Event.Gesture;
+        RED_P2_6_Write(LED_OFF);
+        GREEN_P3_6_Write(LED_OFF);
+        BLUE_P3_7_Write(LED_OFF);
+    }
     switch(Gesture)
     {
         case(TAP_GESTURE):
             BLUE_P3_7_Write(LED_ON); 
-            LED_Timer = LED_ON_TIME_MS;
+        break;
+        case(DOUBLE_TAP_GESTURE):
+            BLUE_P3_7_Write(LED_ON);
+            GREEN_P3_6_Write(LED_ON);
+        break;
+        case(LONG_PRESS_GESTURE):
+            BLUE_P3_7_Write(LED_ON);
+            RED_P2_6_Write(LED_ON);
+        break;
+        case(SLIDE_GESTURE):
+            RED_P2_6_Write(LED_ON);
+            GREEN_P3_6_Write(LED_ON);
         break;
         case(SWIPE_LEFT_GESTURE):
+        case(SWIPE_LEFT_LONG_GESTURE):
             GREEN_P3_6_Write(LED_ON);
-            LED_Timer = LED_ON_TIME_MS;
         break;
         case(SWIPE_RIGHT_GESTURE):
+        case(SWIPE_RIGHT_LONG_GESTURE):
             RED_P2_6_Write(LED_ON);
-            LED_Timer = LED_ON_TIME_MS;
         break;
         case(LARGE_OBJECT):
             RED_P2_6_Write(LED_ON);
             GREEN_P3_6_Write(LED_ON);
             BLUE_P3_7_Write(LED_ON); 
-            LED_Timer = LED_ON_TIME_MS;
         break;
         case(NO_GESTURE):
             
@@ -127,19 +147,20 @@ void LED_Process(void)
             Gesture = NO_GESTURE;
         break;
     }
-    /* If Timer is running, decrement timer by the current tick period */
-    if(LED_Timer)
+    if(Gesture != NO_GESTURE)
     {
-        LED_Timer -= SYSTEM_TICK_TIME_MS;
+        /* (Re)start the on time, we run again when it expires */
+        mProcess_SetTimer(LED_PROCESS, LED_ON_TIME_MS);
+        mProcess_Enable(LED_PROCESS);
     }
-    /* If Timer Expires, turn off LEDs */
-    if(LED_Timer <= SYSTEM_TICK_TIME_MS)
+    else
     {
+        /* On time expired, turn off LEDs and stop the timer until the next
+        gesture is detected */
         RED_P2_6_Write(LED_OFF);
         GREEN_P3_6_Write(LED_OFF);
         BLUE_P3_7_Write(LED_OFF);
-        /* Set Timer to 0 until next gesture is detected */
-        LED_Timer = 0;
+        mProcess_Disable(LED_PROCESS);
     }
       
     #elif (LED_UPDATE_SOURCE == UPDATE_FROM_EDA)   
@@ -182,7 +203,7 @@ void LED_Process(void)
     
     #endif    
         
-    mLED_DeQueue();
+    mProcess_DeQueue(LED_PROCESS);
     
     mDebugClear(LED_DebugOutput, LED_DEBUG_ENTER_SM);
     
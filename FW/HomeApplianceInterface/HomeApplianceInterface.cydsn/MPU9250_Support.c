@@ -78,9 +78,18 @@ unsigned long  MPU9250_I2C_Read(unsigned char Address, unsigned char RegisterAdd
     return status;
 }
 
+/* Milliseconds since start up from the WDT monotonic clock, for the
+Invensense driver.  Returns 0, or 1 for a NULL count */
 int get_clock_ms(unsigned long *count)
 {
-    return *count;
+    if(count == NULL)
+    {
+        return 1;
+    }
+    
+    *count = (unsigned long)WatchdogTimer_GetClockMs();
+    
+    return 0;
 }
 
 void eMPL_send_quat(long *quat)
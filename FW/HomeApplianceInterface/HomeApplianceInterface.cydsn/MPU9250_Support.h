@@ -21,8 +21,7 @@
 unsigned long  MPU9250_I2C_Write(unsigned char Address, unsigned char RegisterAddr, unsigned char RegisterLen, unsigned char *RegisterValue);
 unsigned long  MPU9250_I2C_Read(unsigned char Address, unsigned char RegisterAddr, unsigned char RegisterLen, unsigned char *RegisterValue);
 
-/* System tick integration */
-/* KLMZ TODO: Make this a real function */
+/* System clock integration, see WatchdogTimer_GetClockMs() */
 int get_clock_ms(unsigned long *count);
 
 #define BUF_SIZE        (256)
@@ -0,0 +1,185 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         OneShot.c
+********************************************************************************
+* Description:
+*  One-shot timer service on WDT counter 1, see OneShot.h.
+*
+********************************************************************************
+*/
+#include "OneShot.h"
+
+/* Low 32 bits of the clock, see WatchdogTimer_GetClock(), at which the
+one-shot of each process is due */
+static uint32 OneShot_Due[NUMBER_OF_PROCESSES];
+/* Running one-shots, and the ones that expired since their owner took them */
+static QueueType OneShot_Running;
+static QueueType OneShot_Expired;
+
+/* Local Function Declarations */
+static void OneShot_Arm(void);
+
+/*******************************************************************************
+* Function Name: OneShot_Start
+********************************************************************************
+*
+* Summary:
+*  (Re)starts the one-shot of a process so the process is queued Us
+*  microseconds from now, rounded up to whole WDT counts.
+*
+* Parameters:
+*  uint8 Process: Process handle.
+*  uint32 Us:     Microseconds from now, at most ONESHOT_MAX_US.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void OneShot_Start(uint8 Process, uint32 Us)
+{
+    uint32 counts;
+
+    if(Us > ONESHOT_MAX_US)
+    {
+        Us = ONESHOT_MAX_US;
+    }
+
+    counts = ((Us * WATCHDOG_COUNTS_PER_MS) + 999u) / 1000u;
+    if(counts < ONESHOT_MIN_COUNTS)
+    {
+        counts = ONESHOT_MIN_COUNTS;
+    }
+
+    OneShot_Due[Process] = WatchdogTimer_GetCount() + counts;
+    mQueue_Set(OneShot_Running, Process);
+    mQueue_Clear(OneShot_Expired, Process);
+    OneShot_Arm();
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: OneShot_Stop
+********************************************************************************
+*
+* Summary:
+*  Stops the one-shot of a process.  Stopping a stopped one-shot does nothing.
+*
+* Parameters:
+*  uint8 Process: Process handle.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void OneShot_Stop(uint8 Process)
+{
+    if(mQueue_IsSet(OneShot_Running, Process))
+    {
+        mQueue_Clear(OneShot_Running, Process);
+        OneShot_Arm();
+    }
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: OneShot_TakeExpired
+********************************************************************************
+*
+* Summary:
+*  Returns and clears the expired flag of the one-shot of a process.  A
+*  process queued for more than one reason uses this to find out if its
+*  one-shot is one of them.
+*
+* Parameters:
+*  uint8 Process: Process handle.
+*
+* Return:
+*  TRUE if the one-shot expired since the last call.
+*
+*******************************************************************************/
+uint8 OneShot_TakeExpired(uint8 Process)
+{
+    if(mQueue_IsSet(OneShot_Expired, Process))
+    {
+        mQueue_Clear(OneShot_Expired, Process);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/*******************************************************************************
+* Function Name: OneShot_Service
+********************************************************************************
+*
+* Summary:
+*  Queues the owners of the one-shots that are due and arms counter 1 for the
+*  next one.  The co-op loop calls this for EVENT_SOURCE_ONESHOT.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void OneShot_Service(void)
+{
+    uint8 i;
+    uint32 now = WatchdogTimer_GetCount();
+
+    for(i = 0u; i < NUMBER_OF_PROCESSES; i++)
+    {
+        if(mQueue_IsSet(OneShot_Running, i) && ((int32)(OneShot_Due[i] - now) <= 0))
+        {
+            mQueue_Clear(OneShot_Running, i);
+            mQueue_Set(OneShot_Expired, i);
+            mProcess_Queue(i);
+        }
+    }
+
+    OneShot_Arm();
+
+    return;
+}
+
+/* Point the counter 1 match at the earliest running one-shot, or stop the
+counter if none is running */
+static void OneShot_Arm(void)
+{
+    uint8 i;
+    uint8 running = FALSE;
+    int32 remaining;
+    uint32 earliest = 0xFFFFFFFFu;
+    uint32 now = WatchdogTimer_GetCount();
+
+    for(i = 0u; i < NUMBER_OF_PROCESSES; i++)
+    {
+        if(mQueue_IsSet(OneShot_Running, i))
+        {
+            running = TRUE;
+            remaining = (int32)(OneShot_Due[i] - now);
+            if(remaining <= 0)
+            {
+                remaining = 0;
+            }
+            if((uint32)remaining < earliest)
+            {
+                earliest = (uint32)remaining;
+            }
+        }
+    }
+
+    if(running)
+    {
+        WatchdogTimer_SetAlarm(earliest);
+    }
+    else
+    {
+        WatchdogTimer_StopAlarm();
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,41 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         OneShot.h
+********************************************************************************
+* Description:
+*  Contains defines, function prototypes, and macros for the one-shot timer
+*  service.
+*
+*  A process can ask to be queued a number of microseconds from now, finer
+*  than the system tick and without holding the fine tick.  Every process has
+*  one one-shot, starting it again moves it.  The one-shots share WDT counter
+*  1, which runs from the LFCLK in every power mode including deep sleep, so
+*  a process waiting on a one-shot does not keep the system awake.  The
+*  resolution is one WDT count (1000 / WATCHDOG_COUNTS_PER_MS us) and the
+*  shortest wait is a few counts, see ONESHOT_MIN_COUNTS.  Waits longer than
+*  ONESHOT_MAX_US belong on the process timer.
+*
+*  The counter 1 match posts EVENT_SOURCE_ONESHOT, the co-op loop calls
+*  OneShot_Service() for it and the due owners are queued.
+*
+********************************************************************************
+*/
+#ifndef ONESHOT_H
+#define ONESHOT_H
+
+#include "main.h"
+
+/* A new WDT match takes up to 3 LFCLK cycles to take effect, shorter waits
+are stretched to this */
+#define ONESHOT_MIN_COUNTS              (4u)
+/* Longest wait, the range of the 16 bit counter 1 match */
+#define ONESHOT_MAX_US                  (mWatchdogTimer_CountsToUs(65535u))
+
+/* Function Prototypes */
+void OneShot_Start(uint8 Process, uint32 Us);
+void OneShot_Stop(uint8 Process);
+uint8 OneShot_TakeExpired(uint8 Process);
+void OneShot_Service(void);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,357 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         Process.c
+********************************************************************************
+* Description:
+*  Process control block table and the scheduler functions the co-op loop
+*  runs over it: the next deadline for tickless sleep and the choice of the
+*  next process to dispatch.  The process timers are in the timer wheel, see
+*  Timer.h.
+*
+********************************************************************************
+*/
+#include "Process.h"
+
+/* Process control blocks indexed by priority, see main.h.  Processes that are
+not listed here (Sleep) leave their entry empty and disabled */
+PROCESS_CONTROL_BLOCK Process_Table[NUMBER_OF_PROCESSES] =
+{
+    /* v------------- ADD YOUR PROCESS HERE -------------v */
+    [BATT_PROCESS]  = {Batt_Process,  TIMER_INIT(BATT_PROCESS,  BATT_PROCESS_PERIOD_INIT),  0u, S_BATT_STATE_INIT,  BATT_FLAGS_INIT,  BATT_PROCESS_ID},
+    [BLE_PROCESS]   = {BLE_Process,   TIMER_INIT(BLE_PROCESS,   BLE_PROCESS_PERIOD_INIT),   0u, S_BLE_STATE_INIT,   BLE_FLAGS_INIT,   BLE_PROCESS_ID},
+    [TOUCH_PROCESS] = {Touch_Process, TIMER_INIT(TOUCH_PROCESS, TOUCH_PROCESS_PERIOD_INIT), 0u, S_TOUCH_STATE_INIT, TOUCH_FLAGS_INIT, TOUCH_PROCESS_ID},
+    [LED_PROCESS]   = {LED_Process,   TIMER_INIT(LED_PROCESS,   LED_PROCESS_PERIOD_INIT),   0u, S_LED_STATE_INIT,   LED_FLAGS_INIT,   LED_PROCESS_ID},
+    /* ^------------- ADD YOUR PROCESS HERE -------------^ */
+};
+
+/* Initialization that the processes need to run only once after a reset
+event, in this order */
+static const PROCESS_FUNCTION Process_Init[] =
+{
+    /* v------------- ADD YOUR PROCESS HERE -------------v */
+    Batt_Process_Init,
+    BLE_Process_Init,
+    LED_Process_Init,
+    Touch_Process_Init,
+    /* ^------------- ADD YOUR PROCESS HERE -------------^ */
+};
+
+PROCESS_TICK_STATS Process_TickStats;
+
+#if (SCHEDULER_ROUND_ROBIN == 1u)
+/* Priority of the process that ran last */
+static uint8 Process_LastPriority = NUMBER_OF_PROCESSES_MAX - 1u;
+#endif
+
+/* Local Function Declarations */
+static uint8 Queue_FindFrom(uint8 Priority);
+
+/*******************************************************************************
+* Function Name: Process_InitAll
+********************************************************************************
+*
+* Summary:
+*  Starts the process timers and runs the initialization function of every
+*  process.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Process_InitAll(void)
+{
+    uint8 i;
+    PROCESS_CONTROL_BLOCK * pcb = Process_Table;
+
+    /* Start the timers of the enabled processes, the initialization
+    functions can still change them */
+    for(i = 0u; i < NUMBER_OF_PROCESSES; i++, pcb++)
+    {
+        if((pcb->Flags & (PROCESS_FLAG_ENABLED | PROCESS_FLAGS_NO_TIMER)) == PROCESS_FLAG_ENABLED)
+        {
+            Timer_Start(&pcb->Timer, pcb->Timer.Period);
+        }
+    }
+
+    for(i = 0u; i < (sizeof(Process_Init) / sizeof(Process_Init[0])); i++)
+    {
+        Process_Init[i]();
+    }
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Process_QueueOnWakeup
+********************************************************************************
+*
+* Summary:
+*  Queues the enabled processes that run every time the system wakes up,
+*  whatever the wakeup source was.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Process_QueueOnWakeup(void)
+{
+    uint8 i;
+
+    for(i = 0u; i < NUMBER_OF_PROCESSES; i++)
+    {
+        if((Process_Table[i].Flags & (PROCESS_FLAG_ENABLED | PROCESS_FLAG_EVERY_WAKEUP)) ==
+            (PROCESS_FLAG_ENABLED | PROCESS_FLAG_EVERY_WAKEUP))
+        {
+            mQueue_Set(QUEUE_NAME, i);
+        }
+    }
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Process_TimeUntilDue
+********************************************************************************
+*
+* Summary:
+*  Returns how many milliseconds the system can sleep before a process needs
+*  to run.  Processes waiting for the next tick need the very next one, the
+*  others wait for a timer.
+*
+* Parameters:
+*  uint16 MaxMs: Upper limit of the result.
+*
+* Return:
+*  Milliseconds until the earliest process deadline, at most MaxMs.  1 means
+*  the next tick, whatever its length.
+*
+*******************************************************************************/
+uint16 Process_TimeUntilDue(uint16 MaxMs)
+{
+    if(!mQueue_IsEmpty(NEXTTICK_NAME))
+    {
+        return 1u;
+    }
+
+    return Timer_TimeUntilNext(MaxMs);
+}
+
+/*******************************************************************************
+* Function Name: Process_GetNext
+********************************************************************************
+*
+* Summary:
+*  Picks the queued process to dispatch next.  With round robin disabled this
+*  is the highest priority queued process.  With it enabled the search starts
+*  just below the process that ran last, wrapping around to the top once every
+*  lower priority process has had its turn.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  Priority of the process, PROCESS_NONE if the queue is empty.
+*
+*******************************************************************************/
+uint8 Process_GetNext(void)
+{
+    #if (SCHEDULER_ROUND_ROBIN == 1u)
+    uint8 Priority;
+
+    Priority = Queue_FindFrom(Process_LastPriority + 1u);
+    if(Priority == PROCESS_NONE)
+    {
+        Priority = Queue_FindFrom(0u);
+    }
+    if(Priority != PROCESS_NONE)
+    {
+        Process_LastPriority = Priority;
+    }
+
+    return Priority;
+    #else
+    return Queue_FindFrom(0u);
+    #endif
+}
+
+/*******************************************************************************
+* Function Name: Process_CheckOverrun
+********************************************************************************
+*
+* Summary:
+*  Tick accounting, called when the co-op loop takes a new tick and before
+*  the tick queues any process.  The loop only stops dispatching early when a
+*  tick arrives, so processes still queued at this point ran out of time: the
+*  tick overran.  The processes left queued and the length of the overrun in
+*  ticks go into Process_TickStats.  Each overrun and each batch of missed
+*  ticks is also logged once.
+*
+* Parameters:
+*  uint16 MissedTicks: Ticks missed since the last call, see
+*                      WatchdogTimer_TakeMissedTicks().
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Process_CheckOverrun(uint16 MissedTicks)
+{
+    uint8 word;
+
+    if(!mQueue_IsEmpty(QUEUE_NAME))
+    {
+        if(Process_TickStats.Overruns < 0xFFFFu)
+        {
+            Process_TickStats.Overruns++;
+        }
+        if(Process_TickStats.OverrunTicks < 0xFFFFu)
+        {
+            Process_TickStats.OverrunTicks++;
+        }
+        if(Process_TickStats.OverrunTicks > Process_TickStats.LongestOverrun)
+        {
+            Process_TickStats.LongestOverrun = Process_TickStats.OverrunTicks;
+        }
+        for(word = 0u; word < QUEUE_WORDS; word++)
+        {
+            Process_TickStats.LastPending[word] = QUEUE_NAME[word];
+            Process_TickStats.PendingHistory[word] |= QUEUE_NAME[word];
+        }
+
+        /* Log the start of the overrun only, not every tick of it */
+        if(Process_TickStats.OverrunTicks == 1u)
+        {
+            Log_Error(SYSTEM_PROCESS_ID, SYSTEM_ERROR_TICK_OVERRUN);
+        }
+    }
+    else
+    {
+        Process_TickStats.OverrunTicks = 0u;
+    }
+
+    if(MissedTicks != 0u)
+    {
+        if(MissedTicks > (0xFFFFu - Process_TickStats.MissedTicks))
+        {
+            Process_TickStats.MissedTicks = 0xFFFFu;
+        }
+        else
+        {
+            Process_TickStats.MissedTicks += MissedTicks;
+        }
+        Log_Error(SYSTEM_PROCESS_ID, SYSTEM_ERROR_MISSED_TICK);
+    }
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Queue_FindFrom
+********************************************************************************
+*
+* Summary:
+*  Finds the highest priority queued process at or below Priority.  Lower bits
+*  are higher priorities, so this is the lowest set bit of the queue from
+*  Priority on.
+*
+* Parameters:
+*  uint8 Priority: Highest priority to consider.
+*
+* Return:
+*  Priority of the process, PROCESS_NONE if there is none.
+*
+*******************************************************************************/
+static uint8 Queue_FindFrom(uint8 Priority)
+{
+    uint8 word;
+    QueueWord bits;
+
+    if(Priority >= NUMBER_OF_PROCESSES_MAX)
+    {
+        return PROCESS_NONE;
+    }
+
+    word = mQueue_Word(Priority);
+    /* Mask off the higher priorities of the first word */
+    bits = QUEUE_NAME[word] & (QueueWord)~(mQueue_Bit(Priority) - 1u);
+
+    while(bits == 0u)
+    {
+        word++;
+        if(word >= QUEUE_WORDS)
+        {
+            return PROCESS_NONE;
+        }
+        bits = QUEUE_NAME[word];
+    }
+
+    return (uint8)((word * QUEUE_WORD_BITS) + GetLowestSetBit(bits));
+}
+
+#if (QUEUE_WORDS > 1u)
+/*******************************************************************************
+* Function Name: Queue_IsEmpty
+********************************************************************************
+*
+* Summary:
+*  Checks a multi-word queue bitmap for set bits.  Use mQueue_IsEmpty().
+*
+* Parameters:
+*  QueueWord Queue[]: Queue bitmap.
+*
+* Return:
+*  Non zero if no bit is set.
+*
+*******************************************************************************/
+uint8 Queue_IsEmpty(const QueueWord Queue[])
+{
+    uint8 word;
+
+    for(word = 0u; word < QUEUE_WORDS; word++)
+    {
+        if(Queue[word] != 0u)
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/*******************************************************************************
+* Function Name: Queue_MoveAll
+********************************************************************************
+*
+* Summary:
+*  Moves every bit of a multi-word queue bitmap into another one and clears
+*  the source.  Use mQueue_MoveAll().
+*
+* Parameters:
+*  QueueWord Destination[]: Queue bitmap the bits are added to.
+*  QueueWord Source[]:      Queue bitmap the bits are taken from.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Queue_MoveAll(QueueWord Destination[], QueueWord Source[])
+{
+    uint8 word;
+
+    for(word = 0u; word < QUEUE_WORDS; word++)
+    {
+        Destination[word] |= Source[word];
+        Source[word] = 0u;
+    }
+
+    return;
+}
+#endif
+
+/* [] END OF FILE */
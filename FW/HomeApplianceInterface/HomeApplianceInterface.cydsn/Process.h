@@ -0,0 +1,243 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         Process.h
+********************************************************************************
+* Description:
+*  Contains the process control block table used by the co-op loop and the
+*  macros processes use to control their own scheduling.
+*
+*  Every process owns one entry of Process_Table, at the index of its
+*  priority (see main.h).  The process header defines a handle for it:
+*
+*      #define BATT_PROCESS                 (BATT_PROCESS_PRIORITY)
+*
+*  and the state machine passes that handle to the mProcess_ macros, e.g.
+*  mProcess_SetNextState(BATT_PROCESS, BATT_STATE_START).  A process can also
+*  be written as a protothread, see Protothread.h.
+*
+********************************************************************************
+*/
+#ifndef PROCESS_H
+#define PROCESS_H
+
+#include "main.h"
+
+typedef void (* PROCESS_FUNCTION)(void);
+
+/* Process control block.  Ordered largest member first to keep the padding
+to the end, 32 bytes per process */
+typedef struct
+{
+    PROCESS_FUNCTION Function;          /* Process state machine */
+    TIMER Timer;                        /* Queues the process every period, see Timer.h */
+    uint16 Repeat_Count;                /* Used by mProcess_ExecuteThisStateXTimes() */
+    uint8 State;                        /* Next state of the state machine, or resume
+                                           point of a protothread, see Protothread.h */
+    uint8 Flags;                        /* PROCESS_FLAG_ bits */
+    uint8 ID;                           /* Process ID, see main.h */
+} PROCESS_CONTROL_BLOCK;
+
+/* Process flags */
+#define PROCESS_FLAG_ENABLED                (0x01u)
+/* Queued every time the system wakes up instead of by the process timer */
+#define PROCESS_FLAG_EVERY_WAKEUP           (0x02u)
+/* mProcess_ExecuteThisStateXTimes() is counting repeats */
+#define PROCESS_FLAG_REPEATING              (0x04u)
+/* Queued only by the interrupt events it owns (see Event.c) and by other
+processes, never by its timer.  The period only sets the priority */
+#define PROCESS_FLAG_EVENT_DRIVEN           (0x08u)
+/* Processes without a running process timer */
+#define PROCESS_FLAGS_NO_TIMER              (PROCESS_FLAG_EVERY_WAKEUP | PROCESS_FLAG_EVENT_DRIVEN)
+
+/* Returned by Process_GetNext() when no process is queued */
+#define PROCESS_NONE                        (0xFFu)
+
+/* Co-op loop tick accounting, see Process_CheckOverrun().  The counters
+saturate at 0xFFFF */
+typedef struct
+{
+    uint16 Overruns;                    /* Ticks that arrived with processes still queued */
+    uint16 MissedTicks;                 /* Ticks that arrived before the loop took the last one */
+    uint16 OverrunTicks;                /* Length in ticks of the current overrun, 0 if none */
+    uint16 LongestOverrun;              /* Longest overrun in ticks */
+    QueueType LastPending;              /* Processes left queued by the latest overrun */
+    QueueType PendingHistory;           /* Every process ever left queued by an overrun */
+} PROCESS_TICK_STATS;
+
+extern PROCESS_CONTROL_BLOCK Process_Table[NUMBER_OF_PROCESSES];
+extern PROCESS_TICK_STATS Process_TickStats;
+
+/* Function Prototypes */
+void Process_InitAll(void);
+void Process_QueueOnWakeup(void);
+uint16 Process_TimeUntilDue(uint16 MaxMs);
+uint8 Process_GetNext(void);
+void Process_CheckOverrun(uint16 MissedTicks);
+#if (QUEUE_WORDS > 1u)
+uint8 Queue_IsEmpty(const QueueWord Queue[]);
+void Queue_MoveAll(QueueWord Destination[], QueueWord Source[]);
+#endif
+
+/* Macros */
+/* Enables the process timer, a stopped timer starts a full period from now.
+A disabled process still runs when it is queued directly, see mProcess_Queue() */
+#define mProcess_Enable(PROCESS)\
+    do\
+    {\
+        Process_Table[PROCESS].Flags |= PROCESS_FLAG_ENABLED;\
+        if(((Process_Table[PROCESS].Flags & PROCESS_FLAGS_NO_TIMER) == 0u) &&\
+            !mTimer_IsRunning(&Process_Table[PROCESS].Timer))\
+        {\
+            Timer_Start(&Process_Table[PROCESS].Timer, Process_Table[PROCESS].Timer.Period);\
+        }\
+    } while(0)
+
+/* Disables and stops the process timer */
+#define mProcess_Disable(PROCESS)\
+    do\
+    {\
+        Process_Table[PROCESS].Flags &= (uint8)~PROCESS_FLAG_ENABLED;\
+        Timer_Stop(&Process_Table[PROCESS].Timer);\
+    } while(0)
+
+/* Change how often in milliseconds the process runs, starting with the next
+period */
+#define mProcess_SetPeriod(PROCESS, MS)\
+    do\
+    {\
+        mTimer_SetPeriod(&Process_Table[PROCESS].Timer, MS);\
+    } while(0)
+
+/* Restart the process timer so the process is queued MS milliseconds from now
+and then every period.  This starts the timer of a disabled process too */
+#define mProcess_SetTimer(PROCESS, MS)\
+    do\
+    {\
+        Timer_Start(&Process_Table[PROCESS].Timer, MS);\
+    } while(0)
+
+/* The state the process will run in next */
+#define mProcess_GetState(PROCESS)          (Process_Table[PROCESS].State)
+
+/* On the next run through the co-op loop, go to the destination next state */
+#define mProcess_SetNextState(PROCESS, DESTINATION_STATE)\
+    do\
+    {\
+        Process_Table[PROCESS].State = (uint8)(DESTINATION_STATE);\
+    } while(0)
+
+/* Queue the process to run in this pass of the co-op loop */
+#define mProcess_Queue(PROCESS)             mQueue_Set(QUEUE_NAME, PROCESS)
+
+/* the do nothing macro */
+#define mProcess_Continue(PROCESS)\
+    do\
+    {\
+    } while(0)
+
+#define mProcess_ExecuteOnNextCoOp(PROCESS) mProcess_Continue(PROCESS)
+#define mProcess_RepeatOnNextCoOp(PROCESS)  mProcess_Continue(PROCESS)
+
+#define mProcess_ExecuteStateOnNextCoOp(PROCESS, DESTINATION_STATE)\
+    do\
+    {\
+        mProcess_SetNextState(PROCESS, DESTINATION_STATE);\
+        mProcess_ExecuteOnNextCoOp(PROCESS);\
+    } while(0)
+
+/* De-Queue and on the next tick, go to the destination state */
+#define mProcess_NextTick(PROCESS)\
+    do\
+    {\
+        mQueue_Set(NEXTTICK_NAME, PROCESS);\
+        mProcess_DeQueue(PROCESS);\
+    } while(0)
+
+#define mProcess_ExecuteOnNextTick(PROCESS) mProcess_NextTick(PROCESS)
+#define mProcess_RepeatOnNextTick(PROCESS)  mProcess_NextTick(PROCESS)
+
+#define mProcess_ExecuteStateOnNextTick(PROCESS, DESTINATION_STATE)\
+    do\
+    {\
+        mProcess_SetNextState(PROCESS, DESTINATION_STATE);\
+        mProcess_ExecuteOnNextTick(PROCESS);\
+    } while(0)
+
+/* De-queue the process and when the process timer expires,
+go to the destination state */
+#define mProcess_DeQueue(PROCESS)           mQueue_Clear(QUEUE_NAME, PROCESS)
+
+#define mProcess_ExecuteOnNextPeriod(PROCESS)   mProcess_DeQueue(PROCESS)
+#define mProcess_RepeatOnNextPeriod(PROCESS)    mProcess_DeQueue(PROCESS)
+
+#define mProcess_ExecuteStateOnNextPeriod(PROCESS, DESTINATION_STATE)\
+    do\
+    {\
+        mProcess_SetNextState(PROCESS, DESTINATION_STATE);\
+        mProcess_ExecuteOnNextPeriod(PROCESS);\
+    } while(0)
+
+/* The mProcess_ExecuteThisStateXTimes() macro will repeat the same state
+Multiple times through the co-op loop until the desired number of repeats has been reached.
+The maximum number of state repeats is 65535 and the minimum is 1.
+REPEAT_ACTION and DESTINATION_ACTION name one of the actions above without the
+mProcess_ prefix, e.g. RepeatOnNextTick.
+When the number of repeats has been met, it will move on to the next state */
+#define mProcess_ExecuteThisStateXTimes(PROCESS, REPEAT, REPEAT_ACTION, DESTINATION_STATE, DESTINATION_ACTION)\
+    do\
+    {\
+        if((Process_Table[PROCESS].Flags & PROCESS_FLAG_REPEATING) == 0u)\
+        {\
+            Process_Table[PROCESS].Repeat_Count = (REPEAT) - 1u;\
+            Process_Table[PROCESS].Flags |= PROCESS_FLAG_REPEATING;\
+        }\
+        if(Process_Table[PROCESS].Repeat_Count == 0u)\
+        {\
+            mProcess_SetNextState(PROCESS, DESTINATION_STATE);\
+            mProcess_##DESTINATION_ACTION(PROCESS);\
+            Process_Table[PROCESS].Flags &= (uint8)~PROCESS_FLAG_REPEATING;\
+        }\
+        else\
+        {\
+            Process_Table[PROCESS].Repeat_Count--;\
+            mProcess_##REPEAT_ACTION(PROCESS);\
+        }\
+    } while(0)
+
+/* The mProcess_SleepProcess() macro will sleep the process for the
+desired number of milliseconds, preventing any execution of the process
+until the time has been reached.  When the desired time has elapsed,
+the state machine will execute the destination state.  This macro
+temporarily overrides the process timer and sets it to the desired
+time.  The process timer will return to its original period when
+the sleep period has ended */
+#define mProcess_SleepProcess(PROCESS, MS, DESTINATION_STATE)\
+    do\
+    {\
+        mProcess_SetNextState(PROCESS, DESTINATION_STATE);\
+        mProcess_SetTimer(PROCESS, MS);\
+        mProcess_DeQueue(PROCESS);\
+    } while(0)
+
+/* This process is OK with the device going to sleep */
+#define mProcess_AllowSleep(PROCESS)        mQueue_Clear(DISABLE_SLEEP_NAME, PROCESS)
+
+/* This process will block the device from going to sleep, but allow alt active */
+#define mProcess_DisallowSleep(PROCESS)     mQueue_Set(DISABLE_SLEEP_NAME, PROCESS)
+
+/* This process is OK with the device going to deep sleep */
+#define mProcess_AllowDeepSleep(PROCESS)    mQueue_Clear(DISABLE_DEEPSLEEP_NAME, PROCESS)
+
+/* This process will block the device from going to deep sleep */
+#define mProcess_DisallowDeepSleep(PROCESS) mQueue_Set(DISABLE_DEEPSLEEP_NAME, PROCESS)
+
+/* This process needs the fine system tick, e.g. while it tracks a touch.
+The system ticks at SYSTEM_TICK_TIME_MS while any process holds a request
+and at SYSTEM_TICK_COARSE_MS otherwise, see ADAPTIVE_TICK_ENABLED */
+#define mProcess_RequestFineTick(PROCESS)   mQueue_Set(FINETICK_NAME, PROCESS)
+
+/* This process is OK with the coarse system tick */
+#define mProcess_ReleaseFineTick(PROCESS)   mQueue_Clear(FINETICK_NAME, PROCESS)
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,185 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         Profiler.c
+********************************************************************************
+* Description:
+*  Execution time profiler.  Keeps min/max/mean statistics of every process
+*  dispatch, per process and per state, in a fixed RAM table that can be read
+*  over BLE (see BLE.c) or from the host simulation build.
+*
+********************************************************************************
+*/
+#include <string.h>
+#include "Profiler.h"
+
+PROFILER_ENTRY Profiler_Table[NUMBER_OF_PROCESSES];
+
+/* Local Function Declarations */
+static void Profiler_Update(PROFILER_STATS * Stats, uint32 Cycles);
+
+/*******************************************************************************
+* Function Name: Profiler_Init
+********************************************************************************
+*
+* Summary:
+*  Starts SysTick as a free running timer and clears the statistics.  The
+*  SysTick interrupt is not used.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Profiler_Init(void)
+{
+    #if (PROFILER_ENABLED == 1u)
+    CySysTickInit();
+    CySysTickSetReload(PROFILER_TIMER_MASK);
+    CySysTickClear();
+    CySysTickEnable();
+    CySysTickDisableInterrupt();
+
+    Profiler_Reset();
+    #endif
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Profiler_Reset
+********************************************************************************
+*
+* Summary:
+*  Clears the statistics of all processes.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Profiler_Reset(void)
+{
+    memset(Profiler_Table, 0, sizeof(Profiler_Table));
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Profiler_Record
+********************************************************************************
+*
+* Summary:
+*  Adds the time since the start of the sample to the statistics of the
+*  process and of the state it ran.  Use mProfiler_Start() and
+*  mProfiler_Stop().
+*
+* Parameters:
+*  uint8 ProcessID:                 ID of the process that ran.
+*  const PROFILER_SAMPLE * Sample:  Start times and state of the dispatch.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Profiler_Record(uint8 ProcessID, const PROFILER_SAMPLE * Sample)
+{
+    /* SysTick counts down */
+    uint32 cycles = (Sample->Start - mProfiler_ReadTimer()) & PROFILER_TIMER_MASK;
+    uint32 us = mProfiler_ReadClockUs() - Sample->StartUs;
+
+    /* SysTick may have wrapped or stopped, take the clock */
+    if((ProcessID == SLEEP_PROCESS_ID) || (us >= PROFILER_SYSTICK_SPAN_US))
+    {
+        cycles = (us < (0xFFFFFFFFu / PROFILER_CYCLES_PER_US)) ? (us * PROFILER_CYCLES_PER_US) : 0xFFFFFFFFu;
+    }
+
+    if(ProcessID < NUMBER_OF_PROCESSES)
+    {
+        Profiler_Update(&Profiler_Table[ProcessID].Process, cycles);
+
+        if(Sample->State < PROFILER_STATES_MAX)
+        {
+            Profiler_Update(&Profiler_Table[ProcessID].State[Sample->State], cycles);
+        }
+    }
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Profiler_GetRecord
+********************************************************************************
+*
+* Summary:
+*  Serializes the statistics of a process or one of its states into the GATT
+*  record format, see PROFILER_RECORD_LEN.
+*
+* Parameters:
+*  uint8 ProcessID: ID of the process.
+*  uint8 State:     State, or PROFILER_STATE_ALL for the whole process.
+*  uint8 Record[]:  Output, PROFILER_RECORD_LEN bytes.
+*
+* Return:
+*  Number of bytes written, 0 if the process or state has no statistics.
+*
+*******************************************************************************/
+uint8 Profiler_GetRecord(uint8 ProcessID, uint8 State, uint8 Record[])
+{
+    const PROFILER_STATS * stats;
+
+    if(ProcessID >= NUMBER_OF_PROCESSES)
+    {
+        return 0u;
+    }
+
+    if(State == PROFILER_STATE_ALL)
+    {
+        stats = &Profiler_Table[ProcessID].Process;
+    }
+    else if(State < PROFILER_STATES_MAX)
+    {
+        stats = &Profiler_Table[ProcessID].State[State];
+    }
+    else
+    {
+        return 0u;
+    }
+
+    Record[0u] = ProcessID;
+    Record[1u] = State;
+    Set16ByPtr(&Record[2u], stats->Count);
+    Set32ByPtr(&Record[4u], stats->Min);
+    Set32ByPtr(&Record[8u], stats->Max);
+    Set32ByPtr(&Record[12u], stats->Sum);
+
+    return PROFILER_RECORD_LEN;
+}
+
+/* Add one measurement to a statistics entry */
+static void Profiler_Update(PROFILER_STATS * Stats, uint32 Cycles)
+{
+    if((Stats->Count == 0u) || (Cycles < Stats->Min))
+    {
+        Stats->Min = Cycles;
+    }
+    if(Cycles > Stats->Max)
+    {
+        Stats->Max = Cycles;
+    }
+
+    /* Halve the sum and the count instead of overflowing, the mean stays
+    the same and newer measurements get more weight */
+    if((Stats->Count == 0xFFFFu) || (Stats->Sum > (0xFFFFFFFFu - Cycles)))
+    {
+        Stats->Sum >>= 1u;
+        Stats->Count >>= 1u;
+    }
+    Stats->Sum += Cycles;
+    Stats->Count++;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,114 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         Profiler.h
+********************************************************************************
+* Description:
+*  Contains defines, function prototypes, and macros for the execution time
+*  profiler.  The co-op loop timestamps every process dispatch and the
+*  profiler keeps min/max/mean statistics per process and per state.
+*
+********************************************************************************
+*/
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "main.h"
+
+/* The profiler runs the Cortex-M0 SysTick as a free running down counter
+clocked by SYSCLK.  It wraps every 2^24 cycles (0.7 s at 24 MHz) and stops in
+deep sleep, so each dispatch is also timed with the WDT monotonic clock (see
+WatchdogTimer_GetClock()).  Dispatches longer than half the SysTick range, and
+the sleep, which may enter deep sleep, are recorded from the clock instead,
+still in SYSCLK cycles but only to the 31.25 us resolution of the clock */
+#define PROFILER_TIMER_MASK             (CY_SYS_SYST_RVR_CNT_MASK)
+#define PROFILER_CYCLES_PER_US          (CYDEV_BCLK__SYSCLK__HZ / 1000000u)
+#define PROFILER_SYSTICK_SPAN_US        ((PROFILER_TIMER_MASK / PROFILER_CYCLES_PER_US) / 2u)
+#define mProfiler_ReadTimer()           (CySysTickGetValue())
+#define mProfiler_ReadClockUs()         ((uint32)WatchdogTimer_GetClockUs())
+
+/* Per state statistics are kept for states 0 to PROFILER_STATES_MAX - 1,
+higher states only count towards the process statistics.  The waits of a
+protothread process are its states, see Protothread.h */
+#define PROFILER_STATES_MAX             (8u)
+
+/* Selects the statistics of the whole process instead of one state */
+#define PROFILER_STATE_ALL              (0xFFu)
+
+/* GATT record, little endian:
+   [0]      Process ID
+   [1]      State, PROFILER_STATE_ALL for the whole process
+   [2..3]   Count
+   [4..7]   Min cycles
+   [8..11]  Max cycles
+   [12..15] Sum of cycles, mean = Sum / Count */
+#define PROFILER_RECORD_LEN             (16u)
+
+/* The BLE diagnostics service has a PROFILER_RECORD_LEN byte profiler
+characteristic.  The client writes {Process ID, State} to select the record it
+reads next, writing PROFILER_SELECT_RESET as the process ID clears the table */
+#define PROFILER_SELECT_RESET           (0xFFu)
+
+/* Execution time statistics in SYSCLK cycles.  The mean is Sum / Count, the
+division is left to whoever reads the table */
+typedef struct
+{
+    uint32 Min;
+    uint32 Max;
+    uint32 Sum;
+    uint16 Count;
+} PROFILER_STATS;
+
+typedef struct
+{
+    PROFILER_STATS Process;
+    PROFILER_STATS State[PROFILER_STATES_MAX];
+} PROFILER_ENTRY;
+
+/* Start time and state of the dispatch being measured */
+typedef struct
+{
+    uint32 Start;                       /* SysTick */
+    uint32 StartUs;                     /* Monotonic clock, low 32 bits */
+    uint8 State;
+} PROFILER_SAMPLE;
+
+/* Indexed by process ID */
+extern PROFILER_ENTRY Profiler_Table[NUMBER_OF_PROCESSES];
+
+/* Function Prototypes */
+void Profiler_Init(void);
+void Profiler_Reset(void);
+void Profiler_Record(uint8 ProcessID, const PROFILER_SAMPLE * Sample);
+uint8 Profiler_GetRecord(uint8 ProcessID, uint8 State, uint8 Record[]);
+
+/* Macros */
+#if (PROFILER_ENABLED == 1u)
+/* Call right before dispatching a process, with the state it will run */
+#define mProfiler_Start(SAMPLE, STATE)\
+    do\
+    {\
+        (SAMPLE).State = (STATE);\
+        (SAMPLE).StartUs = mProfiler_ReadClockUs();\
+        (SAMPLE).Start = mProfiler_ReadTimer();\
+    } while(0)
+
+/* Call right after the process returns */
+#define mProfiler_Stop(SAMPLE, PROCESS_ID)\
+    do\
+    {\
+        Profiler_Record((PROCESS_ID), &(SAMPLE));\
+    } while(0)
+#else
+#define mProfiler_Start(SAMPLE, STATE)\
+    do\
+    {\
+    } while(0)
+
+#define mProfiler_Stop(SAMPLE, PROCESS_ID)\
+    do\
+    {\
+    } while(0)
+#endif
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,166 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         Protothread.h
+********************************************************************************
+* Description:
+*  Protothread macros.  A process can be written as straight line code that
+*  waits in the middle instead of as a hand written state machine:
+*
+*      static void Batt_Thread(void)
+*      {
+*          PT_BEGIN(BATT_PROCESS);
+*          Batt_SwitchControl_P0_3_Write(1);
+*          PT_SLEEP_US(BATT_PROCESS, BATT_SETTLING_US);
+*          PT_LOCK(BATT_PROCESS, ADC_Mutex);
+*          ...
+*          PT_END(BATT_PROCESS);
+*      }
+*
+*  A wait returns from the function and the next dispatch resumes right
+*  after it.  The resume point is kept in the State of the process control
+*  block, so a thread costs no more RAM than a state machine.  The waits of a
+*  thread are numbered 1, 2, 3... in source order from __COUNTER__, so the
+*  profiler keeps statistics for each stretch of the thread between two waits
+*  like it does for each state of a state machine.  There is no stack: local
+*  variables do not keep their values across a wait, use static variables for
+*  that.  One thread per function, at most PT_WAITS_MAX waits, and no switch
+*  statement around a wait.
+*
+*  The waits map onto the scheduling macros of Process.h.  The thread returns
+*  from its function, so keep the debug pin handling of the process in a
+*  wrapper around it.
+*
+********************************************************************************
+*/
+#ifndef PROTOTHREAD_H
+#define PROTOTHREAD_H
+
+#include "main.h"
+
+/* Resume point of a thread that has not started, the initial State of a
+protothread process */
+#define PT_STATE_INIT                   (0u)
+
+/* Logged with the process ID if the resume point is corrupt, the same code
+as the X_ERROR_DEFAULT_STATE of the processes */
+#define PT_ERROR_DEFAULT_STATE          (0u)
+
+/* Resume points are the 8 bit State */
+#define PT_WAITS_MAX                    (254u)
+
+/* Start of the thread body.  PT_COUNTER_BASE numbers the waits of the thread
+from 1, whatever else in the file used __COUNTER__ before it */
+#define PT_BEGIN(PROCESS)\
+    enum { PT_COUNTER_BASE = __COUNTER__ };\
+    switch(mProcess_GetState(PROCESS))\
+    {\
+        case PT_STATE_INIT:
+
+/* End of the thread body.  The thread is done until the process timer
+queues it again, then it starts over from PT_BEGIN() */
+#define PT_END(PROCESS)\
+        mProcess_ExecuteStateOnNextPeriod(PROCESS, PT_STATE_INIT);\
+        return;\
+    default:\
+        Log_Error(Process_Table[PROCESS].ID, PT_ERROR_DEFAULT_STATE);\
+        mProcess_ExecuteStateOnNextPeriod(PROCESS, PT_STATE_INIT);\
+        mProcess_Disable(PROCESS);\
+        return;\
+    }
+
+/* Leave the thread and resume here the next time it runs.  COUNTER is
+expanded once as an argument, so the state set and the case label agree */
+#define mPT_Suspend(PROCESS)            mPT_SuspendAt(PROCESS, __COUNTER__)
+#define mPT_SuspendAt(PROCESS, COUNTER)\
+    mProcess_SetNextState(PROCESS, (COUNTER) - PT_COUNTER_BASE);\
+    return;\
+    case ((COUNTER) - PT_COUNTER_BASE):
+
+/* End the thread early, it starts over on the next period */
+#define PT_EXIT(PROCESS)\
+    do\
+    {\
+        mProcess_ExecuteStateOnNextPeriod(PROCESS, PT_STATE_INIT);\
+        return;\
+    } while(0)
+
+/* Let the other processes run and continue in this pass of the co-op loop */
+#define PT_YIELD(PROCESS)\
+    do\
+    {\
+        mPT_Suspend(PROCESS);\
+    } while(0)
+
+/* Continue on the next system tick */
+#define PT_YIELD_TICK(PROCESS)\
+    do\
+    {\
+        mProcess_NextTick(PROCESS);\
+        mPT_Suspend(PROCESS);\
+    } while(0)
+
+/* Wait until CONDITION is true, checking it on every pass of the co-op loop.
+The system does not sleep while the thread polls */
+#define PT_WAIT_UNTIL(PROCESS, CONDITION)\
+    do\
+    {\
+        mPT_Suspend(PROCESS);\
+        if(!(CONDITION))\
+        {\
+            return;\
+        }\
+    } while(0)
+
+/* Wait until CONDITION is true without running.  The condition is checked
+again only when something queues the process: an interrupt event it owns, a
+timer, a mutex release or another process */
+#define PT_BLOCK_UNTIL(PROCESS, CONDITION)\
+    do\
+    {\
+        mPT_Suspend(PROCESS);\
+        if(!(CONDITION))\
+        {\
+            mProcess_DeQueue(PROCESS);\
+            return;\
+        }\
+    } while(0)
+
+/* Sleep for MS milliseconds, rounded up to the system tick.  Like
+mProcess_SleepProcess() this restarts the process timer, the period starts
+over when the sleep ends */
+#define PT_SLEEP_MS(PROCESS, MS)\
+    do\
+    {\
+        (void)Timer_TakeExpired(&Process_Table[PROCESS].Timer);\
+        mProcess_SetTimer(PROCESS, MS);\
+        mProcess_DeQueue(PROCESS);\
+        PT_BLOCK_UNTIL(PROCESS, Timer_TakeExpired(&Process_Table[PROCESS].Timer) != 0u);\
+    } while(0)
+
+/* Sleep for US microseconds on the one-shot timer of the process, see
+OneShot.h.  Finer than the system tick and the process timer keeps running */
+#define PT_SLEEP_US(PROCESS, US)\
+    do\
+    {\
+        OneShot_Start(PROCESS, US);\
+        mProcess_DeQueue(PROCESS);\
+        PT_BLOCK_UNTIL(PROCESS, OneShot_TakeExpired(PROCESS));\
+    } while(0)
+
+/* Take MUTEX, waiting in its FIFO without running if another process owns
+it.  See Mutex_Lock() */
+#define PT_LOCK(PROCESS, MUTEX)\
+    do\
+    {\
+        PT_BLOCK_UNTIL(PROCESS, Mutex_Lock(&(MUTEX), PROCESS));\
+    } while(0)
+
+/* Release MUTEX, the first waiter gets it */
+#define PT_UNLOCK(PROCESS, MUTEX)\
+    do\
+    {\
+        Mutex_Release(&(MUTEX));\
+    } while(0)
+
+#endif
+/* [] END OF FILE */
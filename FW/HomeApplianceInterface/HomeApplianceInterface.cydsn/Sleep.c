@@ -4,30 +4,353 @@
 ********************************************************************************
 * Description:
 *  The sleep process is responsible for changing the chip level power mode.
-*  All power mode changes are done from within this process.
+*  All power mode changes are done from within this process.  The mode is
+*  the one with the lowest expected charge for the time until the next
+*  wakeup, out of the modes BLESS and the processes allow, see Sleep.h.
 *
 ********************************************************************************
 */
+#include <string.h>
 #include "Sleep.h"
 
-#if (PROCESS_DEBUG_ENABLED == 1u)
+#if (DEBUG_POINTERS_ENABLED == 1u)
     uint8 * Sleep_DebugOutput;
 #endif
 
+/* Time kept as whole milliseconds plus the WDT0 counts of a partial one */
+typedef struct
+{
+    uint32 Ms;
+    uint32 Counts;
+} SLEEP_TIME;
+
+/* Power statistics, see SLEEP_STAT_ in Sleep.h */
+static struct
+{
+    SLEEP_TIME Uptime;
+    SLEEP_TIME Residency[NUMBER_OF_SLEEP_MODES];
+    uint32 Wakeups[NUMBER_OF_EVENT_SOURCES + 1u];
+    uint32 LastCount;                   /* WDT0 count the uptime was last updated at */
+} Sleep_Stats;
+
+/* Local Function Declarations */
+static void Sleep_AddTime(SLEEP_TIME * Time, uint32 Counts);
+static void Sleep_UpdateUptime(void);
+
 void Sleep_Init(void)
 {
-    #if (PROCESS_DEBUG_ENABLED == 1u)
+    #if (DEBUG_POINTERS_ENABLED == 1u)
     if(TestMux_Register(SLEEP_PROCESS_ID, &Sleep_DebugOutput)  == TESTMUX_FAIL)
     {
         Log_Error(SLEEP_PROCESS_ID, SLEEP_ERROR_FAILED_TO_REGISTER_TESTMUX);
     }
     #endif
+    
+    Sleep_ResetStats();
+}
+
+/* Power mode costs, see Sleep.h */
+const SLEEP_MODE_COST Sleep_ModeCost[NUMBER_OF_SLEEP_MODES] =
+{
+    [SLEEP_MODE_NONE]       = {0u,                       0u,                       SLEEP_COST_NONE_UA},
+    [SLEEP_MODE_SLEEP]      = {SLEEP_COST_SLEEP_PC,      SLEEP_COST_SLEEP_US,      SLEEP_COST_SLEEP_UA},
+    [SLEEP_MODE_SLEEP_ECO]  = {SLEEP_COST_SLEEP_ECO_PC,  SLEEP_COST_SLEEP_ECO_US,  SLEEP_COST_SLEEP_ECO_UA},
+    [SLEEP_MODE_DEEP_SLEEP] = {SLEEP_COST_DEEP_SLEEP_PC, SLEEP_COST_DEEP_SLEEP_US, SLEEP_COST_DEEP_SLEEP_UA},
+};
+
+/* Modes the hardware and the processes allow right now */
+static uint8 Sleep_AllowedModes(CYBLE_BLESS_STATE_T BleMode)
+{
+    uint8 allowed = mSleep_ModeBit(SLEEP_MODE_NONE);
+    
+    if(mQueue_IsEmpty(DISABLE_SLEEP_NAME))
+    {
+        allowed |= mSleep_ModeBit(SLEEP_MODE_SLEEP);
+    }
+    
+    if(mQueue_IsEmpty(DISABLE_DEEPSLEEP_NAME))
+    {
+        /* Deep sleep keeps the BLE connection only if BLESS sleeps too */
+        if((BleMode == CYBLE_BLESS_STATE_DEEPSLEEP) || (BleMode == CYBLE_BLESS_STATE_ECO_ON))
+        {
+            allowed |= mSleep_ModeBit(SLEEP_MODE_DEEP_SLEEP);
+        }
+        /* Otherwise BLESS keeps the ECO running and the system can use it in
+        place of the IMO */
+        else
+        {
+            allowed |= mSleep_ModeBit(SLEEP_MODE_SLEEP_ECO);
+        }
+    }
+    
+    return allowed;
+}
+
+/*******************************************************************************
+* Function Name: Sleep_EstimateGap
+********************************************************************************
+*
+* Summary:
+*  Estimates how long the system will sleep: until the WDT match, or sooner if
+*  BLESS is awake, a CapSense scan is running or the ADC is converting.
+*
+* Parameters:
+*  CYBLE_BLESS_STATE_T BleMode: Current BLESS state.
+*
+* Return:
+*  Expected time until the next wakeup in us, at most SLEEP_GAP_MAX_US.
+*
+*******************************************************************************/
+uint32 Sleep_EstimateGap(CYBLE_BLESS_STATE_T BleMode)
+{
+    uint32 gap = WatchdogTimer_GetTimeToWakeup();
+    
+    if((BleMode != CYBLE_BLESS_STATE_DEEPSLEEP) && (gap > SLEEP_BLE_WAKEUP_US))
+    {
+        gap = SLEEP_BLE_WAKEUP_US;
+    }
+    
+    #if(Capsense__DISABLED == 0u)
+    if(CapSense_IsBusy() && (gap > SLEEP_CSD_SCAN_US))
+    {
+        gap = SLEEP_CSD_SCAN_US;
+    }
+    #endif
+    
+    /* The ADC is locked from the start to the end of a conversion */
+    if(mMutex_IsLocked(&ADC_Mutex) && (gap > SLEEP_ADC_CONVERSION_US))
+    {
+        gap = SLEEP_ADC_CONVERSION_US;
+    }
+    
+    if(gap > SLEEP_GAP_MAX_US)
+    {
+        gap = SLEEP_GAP_MAX_US;
+    }
+    
+    return gap;
+}
+
+/*******************************************************************************
+* Function Name: Sleep_SelectMode
+********************************************************************************
+*
+* Summary:
+*  Picks the allowed power mode that spends the least charge over the gap:
+*  its transition charge plus its current for the rest of the gap.  A mode
+*  whose latency is longer than the gap would wake us late and is skipped.
+*  Deep sleep for a very short gap costs more in the transition than it
+*  saves, a long gap in a shallow mode wastes current.
+*
+* Parameters:
+*  uint32 GapUs:       Expected time until the next wakeup, at most
+*                      SLEEP_GAP_MAX_US.
+*  uint8 AllowedModes: mSleep_ModeBit() of every mode that may be used.
+*
+* Return:
+*  SLEEP_MODE_ to enter, SLEEP_MODE_NONE if no sleep mode pays off.
+*
+*******************************************************************************/
+uint8 Sleep_SelectMode(uint32 GapUs, uint8 AllowedModes)
+{
+    uint8 mode;
+    uint8 best = SLEEP_MODE_NONE;
+    uint32 charge;
+    uint32 bestCharge = Sleep_ModeCost[SLEEP_MODE_NONE].Current_uA * GapUs;
+    
+    for(mode = SLEEP_MODE_NONE + 1u; mode < NUMBER_OF_SLEEP_MODES; mode++)
+    {
+        if(((AllowedModes & mSleep_ModeBit(mode)) != 0u) &&
+            (Sleep_ModeCost[mode].Latency_us <= GapUs))
+        {
+            /* uA * us = pC */
+            charge = Sleep_ModeCost[mode].Transition_pC +
+                     (Sleep_ModeCost[mode].Current_uA * (GapUs - Sleep_ModeCost[mode].Latency_us));
+            if(charge <= bestCharge)
+            {
+                best = mode;
+                bestCharge = charge;
+            }
+        }
+    }
+    
+    return best;
+}
+
+/*******************************************************************************
+* Function Name: Sleep_AddResidency
+********************************************************************************
+*
+* Summary:
+*  Adds the time from Start until now to a power mode.
+*
+* Parameters:
+*  uint8 Mode:   SLEEP_MODE_ the time was spent in.
+*  uint32 Start: WatchdogTimer_GetCount() when the mode was entered.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Sleep_AddResidency(uint8 Mode, uint32 Start)
+{
+    Sleep_AddTime(&Sleep_Stats.Residency[Mode], WatchdogTimer_GetCount() - Start);
+    Sleep_UpdateUptime();
+}
+
+/*******************************************************************************
+* Function Name: Sleep_CountWakeup
+********************************************************************************
+*
+* Summary:
+*  Counts a wakeup against every event source that has an event pending, or
+*  as other if none has.  Call with interrupts enabled after the wakeup, so
+*  the interrupts that woke us have run.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Sleep_CountWakeup(void)
+{
+    uint8 source;
+    uint8 found = FALSE;
+    
+    for(source = 0u; source < NUMBER_OF_EVENT_SOURCES; source++)
+    {
+        if(mEvent_IsPending(source))
+        {
+            Sleep_Stats.Wakeups[source]++;
+            found = TRUE;
+        }
+    }
+    
+    if(!found)
+    {
+        Sleep_Stats.Wakeups[NUMBER_OF_EVENT_SOURCES]++;
+    }
+}
+
+/*******************************************************************************
+* Function Name: Sleep_ResetStats
+********************************************************************************
+*
+* Summary:
+*  Clears the power statistics, the uptime starts over from now.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Sleep_ResetStats(void)
+{
+    memset(&Sleep_Stats, 0, sizeof(Sleep_Stats));
+    Sleep_Stats.LastCount = WatchdogTimer_GetCount();
+}
+
+/*******************************************************************************
+* Function Name: Sleep_GetStat
+********************************************************************************
+*
+* Summary:
+*  Returns one power statistic.
+*
+* Parameters:
+*  uint8 Stat: SLEEP_STAT_ of the statistic.
+*
+* Return:
+*  Time in ms or number of wakeups, 0 for an unknown statistic.
+*
+*******************************************************************************/
+uint32 Sleep_GetStat(uint8 Stat)
+{
+    uint8 mode;
+    uint32 asleep = 0u;
+    
+    if(Stat < SLEEP_STAT_RESIDENCY)
+    {
+        Sleep_UpdateUptime();
+        if(Stat == SLEEP_STAT_UPTIME)
+        {
+            return Sleep_Stats.Uptime.Ms;
+        }
+        
+        for(mode = 0u; mode < NUMBER_OF_SLEEP_MODES; mode++)
+        {
+            asleep += Sleep_Stats.Residency[mode].Ms;
+        }
+        
+        return (Sleep_Stats.Uptime.Ms > asleep) ? (Sleep_Stats.Uptime.Ms - asleep) : 0u;
+    }
+    
+    if(Stat < SLEEP_STAT_WAKEUPS)
+    {
+        return Sleep_Stats.Residency[Stat - SLEEP_STAT_RESIDENCY].Ms;
+    }
+    
+    if(Stat < NUMBER_OF_SLEEP_STATS)
+    {
+        return Sleep_Stats.Wakeups[Stat - SLEEP_STAT_WAKEUPS];
+    }
+    
+    return 0u;
+}
+
+/*******************************************************************************
+* Function Name: Sleep_GetStatsRecord
+********************************************************************************
+*
+* Summary:
+*  Serializes up to SLEEP_STATS_PER_RECORD statistics into the GATT record
+*  format, see SLEEP_STATS_RECORD_LEN.
+*
+* Parameters:
+*  uint8 First:    SLEEP_STAT_ of the first statistic.
+*  uint8 Record[]: Output, SLEEP_STATS_RECORD_LEN bytes.
+*
+* Return:
+*  Number of statistics in the record, 0 if First is unknown.
+*
+*******************************************************************************/
+uint8 Sleep_GetStatsRecord(uint8 First, uint8 Record[])
+{
+    uint8 i;
+    uint8 count = 0u;
+    
+    memset(Record, 0, SLEEP_STATS_RECORD_LEN);
+    
+    if(First < NUMBER_OF_SLEEP_STATS)
+    {
+        count = NUMBER_OF_SLEEP_STATS - First;
+        if(count > SLEEP_STATS_PER_RECORD)
+        {
+            count = SLEEP_STATS_PER_RECORD;
+        }
+    }
+    
+    Record[0u] = First;
+    Record[1u] = count;
+    for(i = 0u; i < count; i++)
+    {
+        Set32ByPtr(&Record[4u + (i * 4u)], Sleep_GetStat(First + i));
+    }
+    
+    return count;
 }
 
 void Sleep_Process(void)
 {
     CYBLE_BLESS_STATE_T bleMode;
     uint8 interruptStatus;
+    uint8 mode;
+    uint8 slept = FALSE;
+    uint32 start;
     
     #if (PROCESS_DEBUG_ENABLED == 1u)
         uint8 CYDATA TextMuxHardwareRestore;
@@ -77,25 +400,25 @@ void Sleep_Process(void)
     /* Also check if our system tick or touch interrupts have fired and set
      * there respective flags.  If so we cannot go to sleep because we must
      * return to the coop loop and let the associated processes run. */
-    if(WakeupSource == 0)
+    if(!Event_IsAnyPending() && (bleMode != CYBLE_BLESS_STATE_EVENT_CLOSE))
     {   
-        if((bleMode == CYBLE_BLESS_STATE_DEEPSLEEP || bleMode == CYBLE_BLESS_STATE_ECO_ON) &&
-            DisableDeepSleep_Flags == 0u)
-        {
-            mDebugSet(Sleep_DebugOutput, SLEEP_DEBUG_DEEP_SLEEP);
-			/* Enter Deep Sleep */
-            CySysPmDeepSleep();
-            mDebugClear(Sleep_DebugOutput, SLEEP_DEBUG_DEEP_SLEEP);
-        }   
-        /* The else condition signifies that the system cannot enter Deep Sleep.  
-         */
-        else if((bleMode != CYBLE_BLESS_STATE_EVENT_CLOSE))
+        /* Pick the cheapest mode for the time we expect to sleep */
+        mode = Sleep_SelectMode(Sleep_EstimateGap(bleMode), Sleep_AllowedModes(bleMode));
+        start = WatchdogTimer_GetCount();
+        
+        switch(mode)
         {
-            /* The BLE block cannot enter deep sleep, but the rest of the system
-             * is ready for deep sleep.  Therefore we switch to a the ECO clock
-             * for the system and sleep the processor */          
-            if(DisableDeepSleep_Flags == 0)
-            {
+            case SLEEP_MODE_DEEP_SLEEP:
+                mDebugSet(Sleep_DebugOutput, SLEEP_DEBUG_DEEP_SLEEP);
+    			/* Enter Deep Sleep */
+                CySysPmDeepSleep();
+                mDebugClear(Sleep_DebugOutput, SLEEP_DEBUG_DEEP_SLEEP);
+            break;
+            
+            case SLEEP_MODE_SLEEP_ECO:
+                /* The BLE block cannot enter deep sleep, but the rest of the system
+                 * is ready for deep sleep.  Therefore we switch to a the ECO clock
+                 * for the system and sleep the processor */          
                 /* change HF clock source from IMO to ECO, as IMO is not required and can be stopped to save power */
                 CySysClkWriteHfclkDirect(CY_SYS_CLK_HFCLK_ECO); 
                 /* stop IMO for reducing power consumption */
@@ -103,46 +426,55 @@ void Sleep_Process(void)
                 /* put the CPU to sleep */
                 mDebugSet(Sleep_DebugOutput, SLEEP_DEBUG_SLEEP_NO_IMO);
                 CySysPmSleep();
-                mDebugSet(Sleep_DebugOutput, SLEEP_DEBUG_SLEEP_NO_IMO);
+                mDebugClear(Sleep_DebugOutput, SLEEP_DEBUG_SLEEP_NO_IMO);
                 /* starts execution after waking up, start IMO */
                 CySysClkImoStart();
                 /* change HF clock source back to IMO */
                 CySysClkWriteHfclkDirect(CY_SYS_CLK_HFCLK_IMO);    
-            }
+            break;
             
-            /* The BLE block cannot enter deep sleep and the system requires
-             * the IMO for hardware peripheral functionality.  We can sleep the
-             * CPU. */
-            else if(DisableSleep_Flags == 0)
-            {   
+            case SLEEP_MODE_SLEEP:
+                /* The system requires the IMO for hardware peripheral
+                 * functionality, or the gap is too short for the deeper
+                 * modes.  We can sleep the CPU. */
                 mDebugSet(Sleep_DebugOutput, SLEEP_DEBUG_SLEEP);
                 CySysPmSleep();
                 mDebugClear(Sleep_DebugOutput, SLEEP_DEBUG_SLEEP);
-            }
-            else
-            {
+            break;
+            
+            default:
                 /* Sleep has been disabled, we are currently processing
-                 * data that requires the CPU and peripherals be kept on.  We must
-                 * simply wait for the next system tick before proceeding */
-                
-                /* TODO This case needs to be evaluated.  Due to BLE processing we
-                   may have to exit this loop sooner than the next tick. The best
-                   way to solve this in the system would be to have the BLE interrupt 
-				   set a flag in the WakeupSource variable */
-                
-                /* Exit Critical section - Global interrupts are enabled again */
-                CyExitCriticalSection(interruptStatus);
-                
-                /* wait for the next system tick note that the BLE interrupt
-                   will not break us out of this loop */
-                while(WakeupSource == 0){}
-            }
-        }  
+                 * data that requires the peripherals be kept on.  Halt only
+                 * the CPU until an interrupt posts an event, the BLESS
+                 * interrupt included (EVENT_SOURCE_BLE).  Interrupts stay
+                 * masked around the WFI, a pending interrupt still ends it,
+                 * so an event posted between the check and the WFI is not
+                 * missed.  The interrupt is served when we unmask, and an
+                 * interrupt without an event puts us straight back to WFI */
+                mDebugSet(Sleep_DebugOutput, SLEEP_DEBUG_WFI_IDLE);
+                while(!Event_IsAnyPending())
+                {
+                    CY_PM_WFI;
+                    CyExitCriticalSection(interruptStatus);
+                    interruptStatus = CyEnterCriticalSection();
+                }
+                mDebugClear(Sleep_DebugOutput, SLEEP_DEBUG_WFI_IDLE);
+            break;
+        }
+        
+        Sleep_AddResidency(mode, start);
+        slept = TRUE;
     }
     
     /* Exit Critical section - Global interrupts are enabled again */
     CyExitCriticalSection(interruptStatus);
     
+    /* The interrupts that woke us have posted their events by now */
+    if(slept)
+    {
+        Sleep_CountWakeup();
+    }
+    
     #if (PROCESS_DEBUG_ENABLED == 1u)
         HardwareDebugMuxSelect_Control = TextMuxHardwareRestore;
         FirmwareDebugOutput0_Control = TextMuxFirmware0Restore;
@@ -151,6 +483,23 @@ void Sleep_Process(void)
 
 }
 
+/* Add WDT0 counts to a time */
+static void Sleep_AddTime(SLEEP_TIME * Time, uint32 Counts)
+{
+    Counts += Time->Counts;
+    Time->Ms += Counts / WATCHDOG_COUNTS_PER_MS;
+    Time->Counts = Counts % WATCHDOG_COUNTS_PER_MS;
+}
 
-/* [] END OF FILE */
+/* Bring the uptime up to now.  The WDT0 count wraps after 36 hours, BLE
+reads and the residency updates keep the gaps far shorter */
+static void Sleep_UpdateUptime(void)
+{
+    uint32 now = WatchdogTimer_GetCount();
+    
+    Sleep_AddTime(&Sleep_Stats.Uptime, now - Sleep_Stats.LastCount);
+    Sleep_Stats.LastCount = now;
+}
 
+
+/* [] END OF FILE */
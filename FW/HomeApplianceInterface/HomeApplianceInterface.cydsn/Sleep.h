@@ -24,14 +24,89 @@
 #define SLEEP_DEBUG_DEEP_SLEEP                        (0x02)
 #define SLEEP_DEBUG_SLEEP                             (0x04)
 #define SLEEP_DEBUG_SLEEP_NO_IMO                      (0x08)
-#define SLEEP_DEBUG_5                                 (0x10)
+#define SLEEP_DEBUG_WFI_IDLE                          (0x10)
 #define SLEEP_DEBUG_6                                 (0x20)
 #define SLEEP_DEBUG_7                                 (0x40)
 #define SLEEP_DEBUG_8                                 (0x80)    
     
+/* Power modes Sleep_Process() chooses from, shallowest first */
+#define SLEEP_MODE_NONE                               (0u)    /* WFI idle until an event, peripherals stay on */
+#define SLEEP_MODE_SLEEP                              (1u)    /* CPU sleep */
+#define SLEEP_MODE_SLEEP_ECO                          (2u)    /* CPU sleep, IMO off, HFCLK from the ECO */
+#define SLEEP_MODE_DEEP_SLEEP                         (3u)
+#define NUMBER_OF_SLEEP_MODES                         (4u)
+
+/* Bit of a mode in the AllowedModes mask of Sleep_SelectMode() */
+#define mSleep_ModeBit(MODE)                          ((uint8)(1u << (MODE)))
+
+/* Cost of each power mode.  The current is what the device draws in the
+mode, the transition charge and latency cover entering and leaving it,
+including the clocks that have to be restarted.  The values are rough
+estimates, measure them on the board and tune them here.  The WFI idle of
+SLEEP_MODE_NONE halts the CPU like sleep does */
+#define SLEEP_COST_NONE_UA                            (1300u)
+#define SLEEP_COST_SLEEP_UA                           (1300u)
+#define SLEEP_COST_SLEEP_PC                           (0u)
+#define SLEEP_COST_SLEEP_US                           (1u)
+#define SLEEP_COST_SLEEP_ECO_UA                       (700u)
+#define SLEEP_COST_SLEEP_ECO_PC                       (25000u)
+#define SLEEP_COST_SLEEP_ECO_US                       (10u)
+#define SLEEP_COST_DEEP_SLEEP_UA                      (2u)
+#define SLEEP_COST_DEEP_SLEEP_PC                      (120000u)
+#define SLEEP_COST_DEEP_SLEEP_US                      (50u)
+
+/* How soon the hardware wakes us up when it is busy.  BLESS not in deep sleep
+is about to start or is in a connection event, a CapSense scan or an ADC
+conversion ends with an interrupt or a poll */
+#define SLEEP_BLE_WAKEUP_US                           (1500u)
+#define SLEEP_CSD_SCAN_US                             (500u)
+#define SLEEP_ADC_CONVERSION_US                       (100u)
+/* Longer gaps all choose the same mode, the limit keeps the charge in 32 bits */
+#define SLEEP_GAP_MAX_US                              (1000000u)
+
+typedef struct
+{
+    uint32 Transition_pC;               /* Charge to enter and leave the mode */
+    uint16 Latency_us;                  /* Time to enter and leave, shorter gaps cannot use the mode */
+    uint16 Current_uA;                  /* Current drawn in the mode */
+} SLEEP_MODE_COST;
+
+extern const SLEEP_MODE_COST Sleep_ModeCost[NUMBER_OF_SLEEP_MODES];
+
+/* Power statistics since start up or the last Sleep_ResetStats().  Time in
+each mode is in ms, SLEEP_MODE_NONE is the time spent in the WFI idle.  Active
+time is what is left of the uptime.  A wakeup counts towards every event
+source pending when we wake, one with no event pending is counted as other */
+#define SLEEP_STAT_UPTIME                             (0u)
+#define SLEEP_STAT_ACTIVE                             (1u)
+#define SLEEP_STAT_RESIDENCY                          (2u)    /* + SLEEP_MODE_ */
+#define SLEEP_STAT_WAKEUPS                            (SLEEP_STAT_RESIDENCY + NUMBER_OF_SLEEP_MODES)    /* + EVENT_SOURCE_ */
+#define SLEEP_STAT_WAKEUPS_OTHER                      (SLEEP_STAT_WAKEUPS + NUMBER_OF_EVENT_SOURCES)
+#define NUMBER_OF_SLEEP_STATS                         (SLEEP_STAT_WAKEUPS_OTHER + 1u)
+
+/* GATT record, little endian:
+   [0]      First statistic, SLEEP_STAT_
+   [1]      Number of statistics in the record
+   [2..3]   Reserved
+   [4..19]  Up to SLEEP_STATS_PER_RECORD statistics, uint32 each */
+#define SLEEP_STATS_RECORD_LEN                        (20u)
+#define SLEEP_STATS_PER_RECORD                        (4u)
+
+/* The BLE diagnostics service has a SLEEP_STATS_RECORD_LEN byte power
+characteristic.  The client writes the first statistic of the record it reads
+next, writing SLEEP_STATS_SELECT_RESET clears the statistics */
+#define SLEEP_STATS_SELECT_RESET                      (0xFFu)
+
 /* Function Prototypes */
 void Sleep_Init(void);
 void Sleep_Process(void);
+uint32 Sleep_EstimateGap(CYBLE_BLESS_STATE_T BleMode);
+uint8 Sleep_SelectMode(uint32 GapUs, uint8 AllowedModes);
+void Sleep_AddResidency(uint8 Mode, uint32 Start);
+void Sleep_CountWakeup(void);
+void Sleep_ResetStats(void);
+uint32 Sleep_GetStat(uint8 Stat);
+uint8 Sleep_GetStatsRecord(uint8 First, uint8 Record[]);
 
 #endif
 
@@ -8,7 +8,7 @@
 *
 ********************************************************************************
 */
-#include "SystemUtils.h"
+#include "main.h"
 
 void Set16ByPtr(uint8 ptr[], uint16 value)
 {
@@ -24,4 +24,136 @@ void Set32ByPtr(uint8 ptr[], uint32 value)
     ptr[3u] = (uint8) (value >> 24u);
 }
 
+/* Returns the index of the least significant set bit of a non-zero value.
+The Cortex-M0 has no count leading zeros instruction, so the lowest set bit is
+isolated and hashed to its index with a de Bruijn multiply and table lookup.
+This takes the same time for every value */
+uint8 GetLowestSetBit(uint32 value)
+{
+    static const uint8 DeBruijnBitIndex[32u] =
+    {
+        0u,  1u,  28u, 2u,  29u, 14u, 24u, 3u,  30u, 22u, 20u, 15u, 25u, 17u, 4u,  8u,
+        31u, 27u, 13u, 23u, 21u, 19u, 16u, 7u,  26u, 12u, 18u, 6u,  11u, 5u,  10u, 9u
+    };
+    
+    return DeBruijnBitIndex[((value & (0u - value)) * 0x077CB531u) >> 27u];
+}
+
+/*******************************************************************************
+* Function Name: Mutex_Lock
+********************************************************************************
+*
+* Summary:
+*  Takes the mutex for a process.  If another process owns it, the process
+*  joins the waiter FIFO and should dequeue itself.  Mutex_Release() queues
+*  it again once the mutex is its own, and the next call returns TRUE.  If the
+*  FIFO is full the process retries on the next tick instead.
+*
+* Parameters:
+*  MUTEX * Mutex: The mutex.
+*  uint8 Process: Handle of the calling process.
+*
+* Return:
+*  TRUE if the process owns the mutex.
+*
+*******************************************************************************/
+uint8 Mutex_Lock(MUTEX * Mutex, uint8 Process)
+{
+    uint8 i;
+
+    if(Mutex->Owner == Process)
+    {
+        return TRUE;
+    }
+
+    if(Mutex->Owner == MUTEX_NO_OWNER)
+    {
+        Mutex->Owner = Process;
+        Mutex->LockTime = (uint32)WatchdogTimer_GetClockMs();
+        if(Mutex->Locks < 0xFFFFu)
+        {
+            Mutex->Locks++;
+        }
+        return TRUE;
+    }
+
+    /* A process queued by its timer while it waits is already in the FIFO */
+    for(i = 0u; i < Mutex->WaitCount; i++)
+    {
+        if(Mutex->Waiters[(Mutex->WaitHead + i) % MUTEX_WAITERS_MAX] == Process)
+        {
+            return FALSE;
+        }
+    }
+
+    if(Mutex->Contentions < 0xFFFFu)
+    {
+        Mutex->Contentions++;
+    }
+
+    if(Mutex->WaitCount < MUTEX_WAITERS_MAX)
+    {
+        Mutex->Waiters[(Mutex->WaitHead + Mutex->WaitCount) % MUTEX_WAITERS_MAX] = Process;
+        Mutex->WaitCount++;
+    }
+    else
+    {
+        Log_Error(SYSTEM_PROCESS_ID, SYSTEM_ERROR_MUTEX_WAITERS_FULL);
+        mProcess_NextTick(Process);
+    }
+
+    return FALSE;
+}
+
+/*******************************************************************************
+* Function Name: Mutex_Release
+********************************************************************************
+*
+* Summary:
+*  Releases the mutex.  If processes are waiting the first one becomes the
+*  owner and is queued, so the mutex is never up for grabs in between.
+*
+* Parameters:
+*  MUTEX * Mutex: The mutex, owned by the calling process.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Mutex_Release(MUTEX * Mutex)
+{
+    uint32 now = (uint32)WatchdogTimer_GetClockMs();
+    uint32 held = now - Mutex->LockTime;
+
+    if(Mutex->Owner == MUTEX_NO_OWNER)
+    {
+        return;
+    }
+
+    Mutex->HoldTotal += held;
+    if(held > Mutex->HoldMax)
+    {
+        Mutex->HoldMax = (held > 0xFFFFu) ? 0xFFFFu : (uint16)held;
+    }
+
+    if(Mutex->WaitCount != 0u)
+    {
+        Mutex->Owner = Mutex->Waiters[Mutex->WaitHead];
+        Mutex->WaitHead = (Mutex->WaitHead + 1u) % MUTEX_WAITERS_MAX;
+        Mutex->WaitCount--;
+        Mutex->LockTime = now;
+        if(Mutex->Locks < 0xFFFFu)
+        {
+            Mutex->Locks++;
+        }
+        mProcess_Queue(Mutex->Owner);
+    }
+    else
+    {
+        Mutex->Owner = MUTEX_NO_OWNER;
+    }
+
+    return;
+}
+
 /* [] END OF FILE */
@@ -19,17 +19,39 @@
     
 /* Hardware Mutex Type define */
 /***************************************
-*         MUTEX STATES                 *
+*         MUTEX                        *
 ****************************************/
-typedef enum _MUTEX_STATE
+/* A process that finds the mutex taken waits in a FIFO instead of polling.
+Mutex_Release() hands the mutex straight to the first waiter and queues it.
+The FIFO needs one entry per process that shares the mutex */
+#define MUTEX_WAITERS_MAX       (4u)
+/* MUTEX.Owner of an unlocked mutex */
+#define MUTEX_NO_OWNER          (0xFFu)
+
+typedef struct
 {
-    UNLOCKED = 0u,
-    LOCKED
-}MUTEX;
+    uint32 LockTime;                    /* Clock in ms when the owner took the mutex */
+    uint32 HoldTotal;                   /* Sum of the hold times in ms */
+    uint16 HoldMax;                     /* Longest hold time in ms */
+    uint16 Locks;                       /* Times the mutex was taken */
+    uint16 Contentions;                 /* Lock attempts that found the mutex taken */
+    uint8 Owner;                        /* Process handle of the owner, MUTEX_NO_OWNER if unlocked */
+    uint8 WaitHead;                     /* Oldest waiter in Waiters */
+    uint8 WaitCount;
+    uint8 Waiters[MUTEX_WAITERS_MAX];   /* Process handles in lock order */
+} MUTEX;
+
+/* Static initializer for an unlocked mutex */
+#define MUTEX_INIT              {0u, 0u, 0u, 0u, 0u, MUTEX_NO_OWNER, 0u, 0u, {0u}}
+
+#define mMutex_IsLocked(MUTEX_PTR)      ((MUTEX_PTR)->Owner != MUTEX_NO_OWNER)
     
 /* Function Prototypes */
 void Set16ByPtr(uint8 ptr[], uint16 value);
 void Set32ByPtr(uint8 ptr[], uint32 value);    
+uint8 GetLowestSetBit(uint32 value);
+uint8 Mutex_Lock(MUTEX * Mutex, uint8 Process);
+void Mutex_Release(MUTEX * Mutex);
  
 #endif
 /* [] END OF FILE */
@@ -14,7 +14,7 @@
 
 #include "TestMux.h"
 
-#if (PROCESS_DEBUG_ENABLED == 1u)
+#if (DEBUG_POINTERS_ENABLED == 1u)
     
 /* define the array of pointers to pointers.  These pointers will point to each 
 individual processes pointers after the processes register their piointer with the
@@ -22,25 +22,20 @@ testmux.  These pointer arrays will then be used to manipulate what each process
 debug pointer points to.  Each processes debug pointer can either point to a 
 "dead end" variable, or to a specific location defined in the testmux.h header file.
 This special location is usually a control register */
-#if (NUMBER_OF_PROCESSES_MAX == 32u)
-    uint8 ** aDebugPointer[NUMBER_OF_PROCESSES_MAX+1] = {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, \
-                                                        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, \
-                                                        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, \
-                                                        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL};
-#endif
+uint8 ** aDebugPointer[NUMBER_OF_PROCESSES_MAX+1] = {NULL};
 
-#if (NUMBER_OF_PROCESSES_MAX == 16u)
-    uint8 ** aDebugPointer[NUMBER_OF_PROCESSES_MAX+1] = {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, \
-                                                        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL};
-#endif
+/* The dead end locations for all processes we dont care about, one per
+process so TestMux_GetProcessID() can tell them apart */
+static uint8 DeadEnd[NUMBER_OF_PROCESSES_MAX+1];
+uint8 TestMuxTest = 0;
 
-#if (NUMBER_OF_PROCESSES_MAX == 8u)
-    uint8 ** aDebugPointer[NUMBER_OF_PROCESSES_MAX+1] = {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL};
-#endif
+/* Processes selected to the firmware debug outputs */
+static uint8 OutputProcessID[TESTMUX_OUTPUTS] = {TESTMUX_NO_PROCESS, TESTMUX_NO_PROCESS};
 
-/* The dead end location for all processes we dont care about */
-uint8 DeadEnd;
-uint8 TestMuxTest = 0;
+/* Local Function Declarations */
+static uint8 * TestMux_Output(uint8 Output);
+static uint8 TestMux_SelectProcess(uint8 Output, uint8 ProcessID);
+static void TestMux_Release(uint8 Output);
 
 void TestMux_Init(void)
 {
@@ -61,7 +56,7 @@ uint8 TestMux_Register(uint8 ProcessID, uint8 * * DebugPointer)
         return TESTMUX_FAIL;
     }
     
-    *DebugPointer = &DeadEnd;
+    *DebugPointer = &DeadEnd[ProcessID];
     aDebugPointer[ProcessID] = DebugPointer;
     
     return TESTMUX_SUCCESS;
@@ -69,100 +64,208 @@ uint8 TestMux_Register(uint8 ProcessID, uint8 * * DebugPointer)
 
 uint8 TestMux_SelectProcess0(uint8 ProcessID)
 {
-    static uint8 PreviousProcessID = 255u;
-    
-    if((ProcessID >= NUMBER_OF_PROCESSES_MAX) && (ProcessID != SYSTEM_PROCESS_ID))
+    return TestMux_SelectProcess(0u, ProcessID);
+}
+
+uint8 TestMux_SelectProcess1(uint8 ProcessID)
+{
+    return TestMux_SelectProcess(1u, ProcessID);
+}
+
+uint8 TestMux_SelectSignal0(uint8 Channel)
+{
+    if(Channel >= MAX_HARDWARE_MUX_CHANNELS)
     {
-        Log_Error(TESTMUX_PROCESS_ID, TESTMUX_ERROR_PROCESS_ID_OUT_OF_RANGE);
+        Log_Error(TESTMUX_PROCESS_ID, TESTMUX_ERROR_HARDWARE_CHANNEL_OUT_OF_RANGE);
         return TESTMUX_FAIL;
     }
     
-    if(aDebugPointer[ProcessID] == NULL)
-    {
-        Log_Error(TESTMUX_PROCESS_ID, TESTMUX_ERROR_PROCESS_ID_NOT_REGISTERED);
-        return TESTMUX_FAIL;
-    }
+    HardwareDebugMuxSelect_Control &= ~HARDWARE0_CHANNEL_MASK;
     
-    if(*aDebugPointer[ProcessID] != &DeadEnd)
-    {
-        Log_Error(TESTMUX_PROCESS_ID, TESTMUX_ERROR_PROCESS_ID_ALREADY_ASSIGNED);
-        return TESTMUX_FAIL;
-    }
+    HardwareDebugMuxSelect_Control |= Channel;
     
-    if(PreviousProcessID != 255u)
+    return TESTMUX_SUCCESS;
+}
+
+uint8 TestMux_SelectSignal1(uint8 Channel)
+{
+    if(Channel >= MAX_HARDWARE_MUX_CHANNELS)
     {
-        *aDebugPointer[PreviousProcessID] = &DeadEnd;
+        Log_Error(TESTMUX_PROCESS_ID, TESTMUX_ERROR_HARDWARE_CHANNEL_OUT_OF_RANGE);
+        return TESTMUX_FAIL;
     }
     
-    *aDebugPointer[ProcessID] = (uint8*)&DEBUG_OUTPUT0;
+    HardwareDebugMuxSelect_Control &= ~HARDWARE1_CHANNEL_MASK;
     
-    PreviousProcessID = ProcessID;
+    HardwareDebugMuxSelect_Control |= (Channel << 4u);
     
     return TESTMUX_SUCCESS;
 }
 
-uint8 TestMux_SelectProcess1(uint8 ProcessID)
+/*******************************************************************************
+* Function Name: TestMux_GetProcessID
+********************************************************************************
+*
+* Summary:
+*  Finds the process a debug pointer belongs to, for the trace.
+*
+* Parameters:
+*  const uint8 * DebugOutput: The value of a registered debug pointer.
+*
+* Return:
+*  The process ID, SYSTEM_PROCESS_ID for the system, or
+*  TESTMUX_UNKNOWN_PROCESS_ID.
+*
+*******************************************************************************/
+uint8 TestMux_GetProcessID(const uint8 * DebugOutput)
 {
-    static uint8 PreviousProcessID = 255u;
-    
-    if((ProcessID >= NUMBER_OF_PROCESSES_MAX) && (ProcessID != SYSTEM_PROCESS_ID))
+    if(DebugOutput == (const uint8*)&DEBUG_OUTPUT0)
     {
-        Log_Error(TESTMUX_PROCESS_ID, TESTMUX_ERROR_PROCESS_ID_OUT_OF_RANGE);
-        return TESTMUX_FAIL;
+        return OutputProcessID[0u];
     }
     
-    if(aDebugPointer[ProcessID] == NULL)
+    if(DebugOutput == (const uint8*)&DEBUG_OUTPUT1)
     {
-        Log_Error(TESTMUX_PROCESS_ID, TESTMUX_ERROR_PROCESS_ID_NOT_REGISTERED);
-        return TESTMUX_FAIL;
+        return OutputProcessID[1u];
     }
     
-    if(*aDebugPointer[ProcessID] != &DeadEnd)
+    if((DebugOutput >= &DeadEnd[0]) && (DebugOutput <= &DeadEnd[NUMBER_OF_PROCESSES_MAX]))
     {
-        Log_Error(TESTMUX_PROCESS_ID, TESTMUX_ERROR_PROCESS_ID_ALREADY_ASSIGNED);
-        return TESTMUX_FAIL;
+        return (uint8)(DebugOutput - &DeadEnd[0]);
     }
     
-    if(PreviousProcessID != 255u)
+    return TESTMUX_UNKNOWN_PROCESS_ID;
+}
+
+/*******************************************************************************
+* Function Name: TestMux_Configure
+********************************************************************************
+*
+* Summary:
+*  Applies a test mux record written over BLE, see TESTMUX_RECORD_LEN.
+*
+* Parameters:
+*  const uint8 * Record: TESTMUX_RECORD_LEN bytes, TESTMUX_UNCHANGED leaves a
+*                        setting as it is.
+*
+* Return:
+*  None.  A setting that fails is logged and left as it was, read the
+*  record back to see what took.
+*
+*******************************************************************************/
+void TestMux_Configure(const uint8 * Record)
+{
+    if(Record[0u] != TESTMUX_UNCHANGED)
     {
-        *aDebugPointer[PreviousProcessID] = &DeadEnd;
+        (void)TestMux_SelectProcess0(Record[0u]);
+    }
+    if(Record[1u] != TESTMUX_UNCHANGED)
+    {
+        (void)TestMux_SelectProcess1(Record[1u]);
+    }
+    if(Record[2u] != TESTMUX_UNCHANGED)
+    {
+        (void)TestMux_SelectSignal0(Record[2u]);
+    }
+    if(Record[3u] != TESTMUX_UNCHANGED)
+    {
+        (void)TestMux_SelectSignal1(Record[3u]);
     }
-    
-    *aDebugPointer[ProcessID] = (uint8*)&DEBUG_OUTPUT1;
-    
-    PreviousProcessID = ProcessID;
-    
-    return TESTMUX_SUCCESS;
 }
 
-uint8 TestMux_SelectSignal0(uint8 Channel)
+/*******************************************************************************
+* Function Name: TestMux_GetRecord
+********************************************************************************
+*
+* Summary:
+*  Fills a test mux record with the current selections.
+*
+* Parameters:
+*  uint8 * Record: Receives TESTMUX_RECORD_LEN bytes.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void TestMux_GetRecord(uint8 * Record)
 {
-    if(Channel >= MAX_HARDWARE_MUX_CHANNELS)
+    Record[0u] = OutputProcessID[0u];
+    Record[1u] = OutputProcessID[1u];
+    Record[2u] = HardwareDebugMuxSelect_Control & HARDWARE0_CHANNEL_MASK;
+    Record[3u] = (HardwareDebugMuxSelect_Control & HARDWARE1_CHANNEL_MASK) >> 4u;
+}
+
+/* Control register of a firmware debug output */
+static uint8 * TestMux_Output(uint8 Output)
+{
+    return (Output == 0u) ? (uint8*)&DEBUG_OUTPUT0 : (uint8*)&DEBUG_OUTPUT1;
+}
+
+/* Point a process at a firmware debug output.  A process can only be on one
+output, selecting it to the other one moves it.  TESTMUX_NO_PROCESS leaves the
+output unused */
+static uint8 TestMux_SelectProcess(uint8 Output, uint8 ProcessID)
+{
+    uint8 interruptStatus;
+    uint8 * output = TestMux_Output(Output);
+    
+    if(ProcessID != TESTMUX_NO_PROCESS)
     {
-        Log_Error(TESTMUX_PROCESS_ID, TESTMUX_ERROR_HARDWARE_CHANNEL_OUT_OF_RANGE);
-        return TESTMUX_FAIL;
+        if((ProcessID >= NUMBER_OF_PROCESSES_MAX) && (ProcessID != SYSTEM_PROCESS_ID))
+        {
+            Log_Error(TESTMUX_PROCESS_ID, TESTMUX_ERROR_PROCESS_ID_OUT_OF_RANGE);
+            return TESTMUX_FAIL;
+        }
+        
+        if(aDebugPointer[ProcessID] == NULL)
+        {
+            Log_Error(TESTMUX_PROCESS_ID, TESTMUX_ERROR_PROCESS_ID_NOT_REGISTERED);
+            return TESTMUX_FAIL;
+        }
     }
     
-    HardwareDebugMuxSelect_Control &= ~HARDWARE0_CHANNEL_MASK;
+    if(OutputProcessID[Output] == ProcessID)
+    {
+        return TESTMUX_SUCCESS;
+    }
     
-    HardwareDebugMuxSelect_Control |= Channel;
+    /* Interrupts write through the debug pointers too */
+    interruptStatus = CyEnterCriticalSection();
+    
+    TestMux_Release(Output);
+    if(ProcessID != TESTMUX_NO_PROCESS)
+    {
+        if(OutputProcessID[Output ^ 1u] == ProcessID)
+        {
+            TestMux_Release(Output ^ 1u);
+        }
+        
+        /* The output starts with the bits the process has set */
+        *output = DeadEnd[ProcessID];
+        *aDebugPointer[ProcessID] = output;
+        OutputProcessID[Output] = ProcessID;
+    }
+    
+    CyExitCriticalSection(interruptStatus);
     
     return TESTMUX_SUCCESS;
 }
 
-uint8 TestMux_SelectSignal1(uint8 Channel)
+/* Point the process on an output back at its dead end, with the bits it has
+set, and clear the output.  Call with interrupts masked */
+static void TestMux_Release(uint8 Output)
 {
-    if(Channel >= MAX_HARDWARE_MUX_CHANNELS)
+    uint8 ProcessID = OutputProcessID[Output];
+    uint8 * output = TestMux_Output(Output);
+    
+    if(ProcessID != TESTMUX_NO_PROCESS)
     {
-        Log_Error(TESTMUX_PROCESS_ID, TESTMUX_ERROR_HARDWARE_CHANNEL_OUT_OF_RANGE);
-        return TESTMUX_FAIL;
+        DeadEnd[ProcessID] = *output;
+        *aDebugPointer[ProcessID] = &DeadEnd[ProcessID];
+        OutputProcessID[Output] = TESTMUX_NO_PROCESS;
     }
     
-    HardwareDebugMuxSelect_Control &= ~HARDWARE1_CHANNEL_MASK;
-    
-    HardwareDebugMuxSelect_Control |= (Channel << 4u);
-    
-    return TESTMUX_SUCCESS;
+    *output = 0u;
 }
 
 #endif
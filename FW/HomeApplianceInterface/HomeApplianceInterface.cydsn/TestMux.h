@@ -5,6 +5,13 @@
 * Description:
 *  Contains defines, function prototypes, and macros for the Test Mux.
 *
+*  Every process registers its debug pointer, which the mDebug macros write
+*  its debug mask through.  A process selected to a firmware debug output
+*  points at that output's control register, every other process at its own
+*  byte in the test mux, so the trace can still tell whose mask it is.
+*  Selecting another process to an output releases the one that was on it,
+*  and the bits each of them has set move along with it.
+*
 ********************************************************************************
 */
 
@@ -20,12 +27,33 @@
 #define TESTMUX_SUCCESS             (0u)
 #define TESTMUX_FAIL                (0xFFu)
 
+/* Firmware debug outputs, DEBUG_OUTPUT0 and DEBUG_OUTPUT1 */
+#define TESTMUX_OUTPUTS             (2u)
+/* Process ID that leaves a firmware debug output unused, and that
+TestMux_GetProcessID() returns for a pointer the test mux did not hand out */
+#define TESTMUX_NO_PROCESS          (0xFFu)
+#define TESTMUX_UNKNOWN_PROCESS_ID  (TESTMUX_NO_PROCESS)
+
+/* GATT record of the test mux selections:
+   [0]  Process on DEBUG_OUTPUT0, TESTMUX_NO_PROCESS for none
+   [1]  Process on DEBUG_OUTPUT1
+   [2]  Hardware channel of debug output 0
+   [3]  Hardware channel of debug output 1
+   The BLE diagnostics service has a test mux characteristic when the pins
+   are enabled, see BLE.c.  The client writes a record, TESTMUX_UNCHANGED
+   leaving a setting as it is, and reads back the selections that took */
+#define TESTMUX_RECORD_LEN          (4u)
+#define TESTMUX_UNCHANGED           (0xFEu)
+
 void TestMux_Init(void);
 uint8 TestMux_Register(uint8 ProcessID, uint8 * * DebugPointer);
 uint8 TestMux_SelectProcess0(uint8 ProcessID);
 uint8 TestMux_SelectProcess1(uint8 ProcessID);
 uint8 TestMux_SelectSignal0(uint8 Channel);
 uint8 TestMux_SelectSignal1(uint8 Channel);
+uint8 TestMux_GetProcessID(const uint8 * DebugOutput);
+void TestMux_Configure(const uint8 * Record);
+void TestMux_GetRecord(uint8 * Record);
 
 /* Error definitions */
 #define TESTMUX_ERROR_PROCESS_ID_OUT_OF_RANGE           (0u)
@@ -57,12 +85,28 @@ uint8 TestMux_SelectSignal1(uint8 Channel);
 #define HARDWARE_CHANNEL15                              (0x0F)
     
 /* macros */
-#if (PROCESS_DEBUG_ENABLED == 1u)
+/* Every set and clear is also recorded to the trace, see Trace.h.  Toggle
+records the state it leaves and pulse records both edges */
+#if (TRACE_ENABLED == 1u)
+    #define mDebugTrace(DEBUG_VARIABLE, DEBUG_MASK, EDGE) \
+        do\
+        {\
+            Trace_Record(DEBUG_VARIABLE, DEBUG_MASK, EDGE);\
+        } while(0)
+#else
+    #define mDebugTrace(DEBUG_VARIABLE, DEBUG_MASK, EDGE) \
+        do\
+        {\
+        } while(0)
+#endif
+
+#if (DEBUG_POINTERS_ENABLED == 1u)
     #define mDebugSet(DEBUG_VARIABLE, DEBUG_MASK) \
         do\
         {\
             * DEBUG_VARIABLE |= DEBUG_MASK;\
             TEST_MUX_TEST |= DEBUG_MASK;\
+            mDebugTrace(DEBUG_VARIABLE, DEBUG_MASK, TRACE_EDGE_SET);\
         } while(0)
 #else
     #define mDebugSet(DEBUG_VARIABLE, DEBUG_MASK) \
@@ -71,12 +115,13 @@ uint8 TestMux_SelectSignal1(uint8 Channel);
         } while(0)
 #endif
 
-#if (PROCESS_DEBUG_ENABLED == 1u)
+#if (DEBUG_POINTERS_ENABLED == 1u)
     #define mDebugClear(DEBUG_VARIABLE, DEBUG_MASK) \
         do\
         {\
             * DEBUG_VARIABLE &= ~DEBUG_MASK;\
             TEST_MUX_TEST &= ~DEBUG_MASK;\
+            mDebugTrace(DEBUG_VARIABLE, DEBUG_MASK, TRACE_EDGE_CLEAR);\
         } while(0)
 #else
     #define mDebugClear(DEBUG_VARIABLE, DEBUG_MASK) \
@@ -85,11 +130,13 @@ uint8 TestMux_SelectSignal1(uint8 Channel);
         } while(0)
 #endif
 
-#if (PROCESS_DEBUG_ENABLED == 1u)
+#if (DEBUG_POINTERS_ENABLED == 1u)
     #define mDebugToggle(DEBUG_VARIABLE, DEBUG_MASK) \
         do\
         {\
             * DEBUG_VARIABLE ^= DEBUG_MASK;\
+            mDebugTrace(DEBUG_VARIABLE, DEBUG_MASK,\
+                        ((* DEBUG_VARIABLE & DEBUG_MASK) != 0u) ? TRACE_EDGE_SET : TRACE_EDGE_CLEAR);\
         } while(0)
 #else
     #define mDebugToggle(DEBUG_VARIABLE, DEBUG_MASK) \
@@ -98,12 +145,14 @@ uint8 TestMux_SelectSignal1(uint8 Channel);
         } while(0)
 #endif
 
-#if (PROCESS_DEBUG_ENABLED == 1u)
+#if (DEBUG_POINTERS_ENABLED == 1u)
     #define mDebugPulse(DEBUG_VARIABLE, DEBUG_MASK) \
         do\
         {\
             * DEBUG_VARIABLE |= DEBUG_MASK;\
+            mDebugTrace(DEBUG_VARIABLE, DEBUG_MASK, TRACE_EDGE_SET);\
             * DEBUG_VARIABLE &= ~DEBUG_MASK;\
+            mDebugTrace(DEBUG_VARIABLE, DEBUG_MASK, TRACE_EDGE_CLEAR);\
         } while(0)
 #else
     #define mDebugPulse(DEBUG_VARIABLE, DEBUG_MASK) \
@@ -0,0 +1,379 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         Timer.c
+********************************************************************************
+* Description:
+*  Hierarchical timer wheel for the process timers and any other software
+*  timers the processes own, see Timer.h.
+*
+********************************************************************************
+*/
+#include <string.h>
+#include "main.h"
+
+/* Timers of each slot, unsorted */
+static TIMER * Timer_Wheel[TIMER_LEVELS][TIMER_SLOTS];
+/* Bit n set if slot n of the level holds a timer */
+static uint16 Timer_Occupied[TIMER_LEVELS];
+/* Current wheel time, ms */
+static uint32 Timer_Now;
+
+/* Local Function Declarations */
+static void Timer_Insert(TIMER * Timer);
+static void Timer_Unlink(TIMER * Timer);
+static TIMER * Timer_TakeSlot(uint8 Level, uint8 Slot);
+static uint32 Timer_NextSlot(uint8 * Level, uint8 * Slot);
+
+/*******************************************************************************
+* Function Name: Timer_InitWheel
+********************************************************************************
+*
+* Summary:
+*  Empties the wheel.  Call once before any timer is started.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Timer_InitWheel(void)
+{
+    memset(Timer_Wheel, 0, sizeof(Timer_Wheel));
+    memset(Timer_Occupied, 0, sizeof(Timer_Occupied));
+    Timer_Now = 0u;
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Timer_Init
+********************************************************************************
+*
+* Summary:
+*  Sets up a stopped timer.  TIMER_INIT() does the same for a static timer.
+*
+* Parameters:
+*  TIMER * Timer: The timer.
+*  uint8 Owner:   Process handle queued when the timer expires, PROCESS_NONE
+*                 to only count the expiries.
+*  uint16 Period: Milliseconds between expiries, 0 for a one-shot timer.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Timer_Init(TIMER * Timer, uint8 Owner, uint16 Period)
+{
+    Timer->Next = NULL;
+    Timer->Link = NULL;
+    Timer->Expiry = 0u;
+    Timer->Period = Period;
+    Timer->Owner = Owner;
+    Timer->Slot = TIMER_SLOT_NONE;
+    Timer->Expired = 0u;
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Timer_Start
+********************************************************************************
+*
+* Summary:
+*  (Re)starts a timer so it first expires Ms from now, and then every
+*  period if it is periodic.
+*
+* Parameters:
+*  TIMER * Timer: The timer.
+*  uint16 Ms:     Milliseconds until the first expiry, 0 is taken as 1.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Timer_Start(TIMER * Timer, uint16 Ms)
+{
+    if(mTimer_IsRunning(Timer))
+    {
+        Timer_Unlink(Timer);
+    }
+
+    /* The slot of the current time has already expired */
+    if(Ms == 0u)
+    {
+        Ms = 1u;
+    }
+
+    Timer->Expiry = Timer_Now + Ms;
+    Timer_Insert(Timer);
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Timer_Stop
+********************************************************************************
+*
+* Summary:
+*  Stops a timer.  Stopping a stopped timer does nothing.
+*
+* Parameters:
+*  TIMER * Timer: The timer.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Timer_Stop(TIMER * Timer)
+{
+    if(mTimer_IsRunning(Timer))
+    {
+        Timer_Unlink(Timer);
+    }
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Timer_TakeExpired
+********************************************************************************
+*
+* Summary:
+*  Returns and clears the expiry count of a timer.  A process that owns more
+*  than one timer uses this to find out which one queued it.
+*
+* Parameters:
+*  TIMER * Timer: The timer.
+*
+* Return:
+*  Expiries since the last call, saturates at 0xFF.
+*
+*******************************************************************************/
+uint8 Timer_TakeExpired(TIMER * Timer)
+{
+    uint8 expired = Timer->Expired;
+
+    Timer->Expired = 0u;
+
+    return expired;
+}
+
+/*******************************************************************************
+* Function Name: Timer_Advance
+********************************************************************************
+*
+* Summary:
+*  Moves the wheel on by the time that has passed.  Every millisecond the
+*  coarse slots it enters are cascaded, then its level 0 slot expires: the
+*  owners are queued and periodic timers restart one period after their
+*  expiry.  A tick covers many milliseconds, and after a tickless sleep many
+*  ticks, so the wheel jumps straight to the next occupied slot instead of
+*  stepping through the empty ones.  The timers due in that time all expire
+*  now, in order.
+*
+* Parameters:
+*  uint16 Ms: Milliseconds since the last call.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Timer_Advance(uint16 Ms)
+{
+    uint8 level;
+    uint8 slot;
+    uint8 shift;
+    uint32 step;
+    TIMER * timer;
+    TIMER * next;
+
+    while(Ms != 0u)
+    {
+        /* Nothing happens before the next occupied slot is entered */
+        step = Timer_NextSlot(&level, &slot);
+        if((step == 0u) || (step > Ms))
+        {
+            Timer_Now += Ms;
+            break;
+        }
+        Ms -= (uint16)step;
+        Timer_Now += step;
+
+        /* Move the timers of every coarse slot this time enters down the
+        wheel, coarsest first */
+        for(level = TIMER_LEVELS - 1u; level != 0u; level--)
+        {
+            shift = level * TIMER_SLOT_BITS;
+            if((Timer_Now & ((1uL << shift) - 1u)) == 0u)
+            {
+                timer = Timer_TakeSlot(level, (uint8)((Timer_Now >> shift) & TIMER_SLOT_MASK));
+                while(timer != NULL)
+                {
+                    next = timer->Next;
+                    Timer_Insert(timer);
+                    timer = next;
+                }
+            }
+        }
+
+        timer = Timer_TakeSlot(0u, (uint8)(Timer_Now & TIMER_SLOT_MASK));
+        while(timer != NULL)
+        {
+            next = timer->Next;
+            timer->Slot = TIMER_SLOT_NONE;
+            if(timer->Expired < 0xFFu)
+            {
+                timer->Expired++;
+            }
+            if(timer->Owner != PROCESS_NONE)
+            {
+                mProcess_Queue(timer->Owner);
+            }
+            if(timer->Period != 0u)
+            {
+                timer->Expiry += timer->Period;
+                Timer_Insert(timer);
+            }
+            timer = next;
+        }
+    }
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Timer_TimeUntilNext
+********************************************************************************
+*
+* Summary:
+*  Returns how many milliseconds until the next timer expires.  Only the
+*  nearest occupied slot of the lowest occupied level needs to be looked at:
+*  every other timer expires after the timers in it.  The slot is scanned for
+*  its earliest expiry, so a sleep is not cut short by the cascade of a
+*  coarse slot, Timer_Advance() cascades on the way.
+*
+* Parameters:
+*  uint16 MaxMs: Upper limit of the result.
+*
+* Return:
+*  Milliseconds until the next expiry, at most MaxMs.
+*
+*******************************************************************************/
+uint16 Timer_TimeUntilNext(uint16 MaxMs)
+{
+    uint8 level;
+    uint8 slot;
+    uint32 ms;
+    const TIMER * timer;
+
+    if(Timer_NextSlot(&level, &slot) != 0u)
+    {
+        for(timer = Timer_Wheel[level][slot]; timer != NULL; timer = timer->Next)
+        {
+            ms = timer->Expiry - Timer_Now;
+            if(ms < MaxMs)
+            {
+                MaxMs = (uint16)ms;
+            }
+        }
+    }
+
+    return MaxMs;
+}
+
+/* Put a timer in the lowest level where the digits of its expiry above that
+level match the current time */
+static void Timer_Insert(TIMER * Timer)
+{
+    uint32 differ = Timer->Expiry ^ Timer_Now;
+    uint8 level = 0u;
+    uint8 slot;
+    TIMER ** head;
+
+    while((level < (TIMER_LEVELS - 1u)) && ((differ >> ((level + 1u) * TIMER_SLOT_BITS)) != 0u))
+    {
+        level++;
+    }
+    slot = (uint8)((Timer->Expiry >> (level * TIMER_SLOT_BITS)) & TIMER_SLOT_MASK);
+
+    head = &Timer_Wheel[level][slot];
+    Timer->Next = *head;
+    if(Timer->Next != NULL)
+    {
+        Timer->Next->Link = &Timer->Next;
+    }
+    Timer->Link = head;
+    *head = Timer;
+
+    Timer->Slot = (uint8)((level * TIMER_SLOTS) + slot);
+    Timer_Occupied[level] |= (uint16)(1u << slot);
+}
+
+/* Take a running timer out of its slot */
+static void Timer_Unlink(TIMER * Timer)
+{
+    uint8 level = Timer->Slot / TIMER_SLOTS;
+    uint8 slot = Timer->Slot & TIMER_SLOT_MASK;
+
+    *Timer->Link = Timer->Next;
+    if(Timer->Next != NULL)
+    {
+        Timer->Next->Link = Timer->Link;
+    }
+    if(Timer_Wheel[level][slot] == NULL)
+    {
+        Timer_Occupied[level] &= (uint16)~(1u << slot);
+    }
+
+    Timer->Slot = TIMER_SLOT_NONE;
+}
+
+/* Empty a slot and return its timers */
+static TIMER * Timer_TakeSlot(uint8 Level, uint8 Slot)
+{
+    TIMER * timers = Timer_Wheel[Level][Slot];
+
+    Timer_Wheel[Level][Slot] = NULL;
+    Timer_Occupied[Level] &= (uint16)~(1u << Slot);
+
+    return timers;
+}
+
+/* Find the nearest occupied slot of the lowest occupied level and return the
+time until the wheel enters it, 0 if the wheel is empty */
+static uint32 Timer_NextSlot(uint8 * Level, uint8 * Slot)
+{
+    uint8 level;
+    uint8 shift;
+    uint8 index;
+    uint8 ahead;
+    uint32 rotated;
+
+    for(level = 0u; level < TIMER_LEVELS; level++)
+    {
+        if(Timer_Occupied[level] != 0u)
+        {
+            shift = level * TIMER_SLOT_BITS;
+            index = (uint8)((Timer_Now >> shift) & TIMER_SLOT_MASK);
+
+            /* Rotate the slots after the current one to the bottom.  The
+            current slot itself ends up last, only the top level can hold
+            timers there, one full turn ahead */
+            rotated = (uint32)Timer_Occupied[level] >> (index + 1u);
+            rotated |= (uint32)Timer_Occupied[level] << (TIMER_SLOTS - 1u - index);
+            ahead = GetLowestSetBit(rotated) + 1u;
+
+            *Level = level;
+            *Slot = (index + ahead) & TIMER_SLOT_MASK;
+
+            /* Start of the slot, counted from the current time */
+            return ((((Timer_Now >> shift) + ahead) << shift) - Timer_Now);
+        }
+    }
+
+    return 0u;
+}
+
+/* [] END OF FILE */
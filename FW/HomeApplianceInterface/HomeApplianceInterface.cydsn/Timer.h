@@ -0,0 +1,87 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         Timer.h
+********************************************************************************
+* Description:
+*  Contains defines, function prototypes, and macros for the software timers.
+*
+*  Every process timer, and any number of extra one-shot or periodic timers a
+*  process owns, sits in one hierarchical timer wheel.  Starting, stopping and
+*  expiring a timer take constant time however many timers are running, and
+*  the co-op loop only touches the timers that are due on each tick.  An
+*  expired timer queues its owner process.
+*
+*  Timers count milliseconds, not system ticks, so a timer keeps its period
+*  when the system tick rate changes (see SYSTEM_TICK_COARSE_MS in main.h).
+*  The co-op loop advances the wheel by the milliseconds each tick covered,
+*  a timer that falls between two ticks expires on the later one.
+*
+*  The wheel has TIMER_LEVELS levels of TIMER_SLOTS slots.  Level 0 slots are
+*  one millisecond wide, each level up is TIMER_SLOTS times coarser.  A timer
+*  goes in the lowest level where its expiry shares every higher digit with
+*  the current time, so its slot is always ahead of the current one.  When
+*  the current time enters a coarse slot the timers in it move down a level
+*  (cascade), and level 0 timers expire when the current time reaches them.
+*
+*  The timers are only used from the co-op loop, never from an interrupt.
+*
+********************************************************************************
+*/
+#ifndef TIMER_H
+#define TIMER_H
+
+/* Only the types are needed here.  main.h includes this file ahead of
+Process.h, which embeds a TIMER in every process control block */
+#include <project.h>
+
+/* Wheel geometry.  TIMER_LEVELS * TIMER_SLOT_BITS must be at least 16 to
+time any uint16 number of milliseconds */
+#define TIMER_SLOT_BITS                 (4u)
+#define TIMER_SLOTS                     (1u << TIMER_SLOT_BITS)
+#define TIMER_SLOT_MASK                 (TIMER_SLOTS - 1u)
+#define TIMER_LEVELS                    (4u)
+
+#if ((TIMER_LEVELS * TIMER_SLOT_BITS) < 16u) || (TIMER_SLOTS > 16u)
+    #error The timer wheel must cover 16 bits with at most 16 slots per level
+#endif
+
+/* TIMER.Slot of a timer that is not running */
+#define TIMER_SLOT_NONE                 (0xFFu)
+
+typedef struct _TIMER
+{
+    struct _TIMER * Next;               /* Next timer in the same slot */
+    struct _TIMER ** Link;              /* Pointer that points at this timer */
+    uint32 Expiry;                      /* Wheel time the timer expires at, ms */
+    uint16 Period;                      /* ms between expiries, 0 for a one-shot timer */
+    uint8 Owner;                        /* Process queued on expiry, PROCESS_NONE for none */
+    uint8 Slot;                         /* Wheel slot, TIMER_SLOT_NONE when stopped */
+    uint8 Expired;                      /* Expiries since the owner last took them */
+} TIMER;
+
+/* Static initializer for a stopped timer */
+#define TIMER_INIT(OWNER, PERIOD)       {NULL, NULL, 0u, (PERIOD), (OWNER), TIMER_SLOT_NONE, 0u}
+
+/* Function Prototypes */
+void Timer_InitWheel(void);
+void Timer_Init(TIMER * Timer, uint8 Owner, uint16 Period);
+void Timer_Start(TIMER * Timer, uint16 Ms);
+void Timer_Stop(TIMER * Timer);
+uint8 Timer_TakeExpired(TIMER * Timer);
+void Timer_Advance(uint16 Ms);
+uint16 Timer_TimeUntilNext(uint16 MaxMs);
+
+/* Macros */
+/* Non zero while the timer is running */
+#define mTimer_IsRunning(TIMER_PTR)     ((TIMER_PTR)->Slot != TIMER_SLOT_NONE)
+
+/* Change the period of a periodic timer, starting with the next period.  0
+makes it a one-shot timer */
+#define mTimer_SetPeriod(TIMER_PTR, MS)\
+    do\
+    {\
+        (TIMER_PTR)->Period = (MS);\
+    } while(0)
+
+#endif
+/* [] END OF FILE */
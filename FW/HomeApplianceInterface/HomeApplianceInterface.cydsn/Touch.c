@@ -3,7 +3,13 @@
 * File Name:         Touch.c
 ********************************************************************************
 * Description:
-*  5 element slider with swipe left, swipe right, and tap gestures.
+*  5 element slider, the gestures are recognized by the gesture engine, see
+*  Gesture.h.
+*
+*  The slider is scanned at the active period while touched and at the idle
+*  period between touches.  ACTIVE_POWER_TIMEOUT_MS after it was last touched
+*  only the ganged sensor is scanned, at the longer ganged period, until a
+*  touch on it turns the slider back on.
 *
 *  Wrist detection scans on EDA high and low measurement pins.
 *
@@ -11,8 +17,9 @@
 */
 
 #include "Touch.h"
+#include "Gesture.h"
 
-#if (PROCESS_DEBUG_ENABLED == 1u)
+#if (DEBUG_POINTERS_ENABLED == 1u)
     uint8 * Touch_DebugOutput;
 #endif
 
@@ -20,36 +27,44 @@
     #include "stdio.h"
 #endif
 
-uint8 Touch_Enable;
-uint16 Touch_Timer_Count;
-uint16 Touch_Period;
-T_TOUCH_STATE s_Touch_State;
-
-uint8 Touch_SleepCountInit = 0u;
-uint8 Touch_SleepCounter8;
-uint16 Touch_SleepCounter16;
-
 /* Gesture Variables */
 Touch_Output TouchResult;
 static uint8 Gesture = NO_GESTURE;
-static uint8 position_start;
-static uint8 position_end;
-static uint8 position_ready;
-static uint8 distance;
-static uint8 active_sensor_tick;
-static uint8 direction;
-static uint8 lift_off;
-static uint8 touch_down;
-static uint8 velocity;
-static uint8 large_object_count;
+/* Gesture of the last scan, a large object is posted once when it appears */
+static uint8 Touch_PreviousGesture = NO_GESTURE;
+static uint8 Touch_Mode;
+/* Clock when the slider was last touched */
+static uint32 Touch_LastActive;
+
+/* Gesture events, see Touch.h.  Touch_EventHead and the cursors run freely,
+a consumer has Touch_EventHead - Touch_Cursor[] events to read */
+static TOUCH_EVENT Touch_Events[TOUCH_EVENTS];
+static uint8 Touch_EventHead;
+static uint8 Touch_Cursor[NUMBER_OF_TOUCH_CONSUMERS];
+static uint16 Touch_Interest[NUMBER_OF_TOUCH_CONSUMERS];
+static uint16 Touch_Lost[NUMBER_OF_TOUCH_CONSUMERS];
+
+/* Process each consumer runs in, queued for the gestures it subscribed to */
+static const uint8 Touch_Consumer[NUMBER_OF_TOUCH_CONSUMERS] =
+{
+    /* v------------ ADD YOUR CONSUMER HERE ------------v */
+    [TOUCH_CONSUMER_LED]    = LED_PROCESS,
+    [TOUCH_CONSUMER_BLE]    = BLE_PROCESS,
+    /* ^------------ ADD YOUR CONSUMER HERE ------------^ */
+};
 
 /* Local Function Declarations */
 void ProcessGestures(void);
+static void Touch_SetMode(uint8 Mode);
+static void Touch_PostEvent(uint8 Code, uint8 Centroid);
+#if(Capsense__DISABLED == 0u)
+static void Touch_Thread(void);
+#endif
 
 /* Initialize the Process */
 void Touch_Process_Init(void)
 {
-    #if (PROCESS_DEBUG_ENABLED == 1u)
+    #if (DEBUG_POINTERS_ENABLED == 1u)
         if(TestMux_Register(TOUCH_PROCESS_ID, &Touch_DebugOutput)  == TESTMUX_FAIL)
         {
             Log_Error(TOUCH_PROCESS_ID, TOUCH_ERROR_FAILED_TO_REGISTER_TESTMUX);
@@ -60,13 +75,6 @@ void Touch_Process_Init(void)
         DUART_Start();
     #endif
     
-    Touch_Enable = TOUCH_ENABLE_INIT;
-    Touch_Timer_Count = TOUCH_IDLE_SCAN_PERIOD;
-    Touch_Period = TOUCH_IDLE_SCAN_PERIOD;
-    s_Touch_State = S_TOUCH_STATE_INIT;
-    
-    mTouch_EnableProcess();
-    
     #if(Capsense__DISABLED == 0u)
     /* Start and Initialize the Capsense component.
        InitializeAllBaselines Blocks for 1 complete scan cycle */
@@ -74,123 +82,253 @@ void Touch_Process_Init(void)
 	CapSense_InitializeAllBaselines();
     #endif
     
+    /* Start out scanning the ganged sensor */
+    Touch_SetMode(TOUCH_MODE_GANGED);
+    mProcess_SetTimer(TOUCH_PROCESS, TOUCH_GANGED_SCAN_PERIOD_MS);
+
     /* Initialize BLE data packet */
     TouchResult.CurrentCentroid = NO_TOUCH;
     return;
 }
 
-/* Touch Process state machine */
+/* Touch Process, the debug pin marks each run of the thread */
 void Touch_Process(void)
 {
     mDebugSet(Touch_DebugOutput, TOUCH_DEBUG_ENTER_SM);
 
     #if(Capsense__DISABLED == 0u)
+    Touch_Thread();
+    #endif
     
-    switch(s_Touch_State)
+    mDebugClear(Touch_DebugOutput, TOUCH_DEBUG_ENTER_SM);
+    
+    return;
+}
+
+#if(Capsense__DISABLED == 0u)
+/* Touch Process thread, one slider scan per period */
+static void Touch_Thread(void)
+{
+    PT_BEGIN(TOUCH_PROCESS);
+
+    /************************************/
+    /*    START SCAN OF TOUCH SLIDER    */
+    /************************************/
+    mDebugSet(Touch_DebugOutput, TOUCH_DEBUG_START_SCAN);
+    /* Wakeup the CSD Hardware */
+    CapSense_Wakeup();
+    /* Start the hardware Scan */
+    CapSense_ScanEnabledWidgets();
+    /* Disable Deep Sleep while hardware scan is running */
+    mProcess_DisallowDeepSleep(TOUCH_PROCESS);
+    mDebugClear(Touch_DebugOutput, TOUCH_DEBUG_START_SCAN);
+
+    /************************************/
+    /*    WAIT FOR SCAN TO COMPLETE     */
+    /************************************/
+    /* Let the system sleep while we wait, the end of scan event queues us */
+    PT_BLOCK_UNTIL(TOUCH_PROCESS, !CapSense_IsBusy());
+
+    mDebugSet(Touch_DebugOutput, TOUCH_DEBUG_WAIT_FOR_SCAN);
+    /* Scan is done, update associated touch data */
+    /* Update Baselines */
+    CapSense_UpdateEnabledBaselines();	
+    /* Check if any widget is active (this updates the SensorOn array) */
+    CapSense_CheckIsAnyWidgetActive();
+    /* Sleep the Capsense Hardware */
+    CapSense_Sleep();
+    /* Allow Deep sleep now that the hardware has finished */
+    mProcess_AllowDeepSleep(TOUCH_PROCESS);
+    mDebugClear(Touch_DebugOutput, TOUCH_DEBUG_WAIT_FOR_SCAN);
+    
+    /************************************/
+    /*PROCESS SCAN RESULTS INTO GESTURES*/
+    /************************************/
+    mDebugSet(Touch_DebugOutput, TOUCH_DEBUG_PROCESS_RESULTS);
+    
+    if(Touch_Mode == TOUCH_MODE_GANGED)
     {
-        case TOUCH_STARTSCAN:
-            /************************************/
-            /*    START SCAN OF TOUCH SLIDER    */
-            /************************************/
-            mDebugSet(Touch_DebugOutput, TOUCH_DEBUG_START_SCAN);
-            /* Wakeup the CSD Hardware */
-            CapSense_Wakeup();
-            /* Start the hardware Scan */
-            CapSense_ScanEnabledWidgets();
-            /* Disable Deep Sleep while hardware scan is running */
-            mTouch_DisallowDeepSleep();
-            
-            mTouch_SetNextState(TOUCH_IS_SCAN_COMPLETE);
-            mTouch_ExecuteOnNextCoOp();
-            mDebugClear(Touch_DebugOutput, TOUCH_DEBUG_START_SCAN);
-        break;
-            
-        case TOUCH_IS_SCAN_COMPLETE:
-            /************************************/
-            /*    WAIT FOR SCAN TO COMPLETE     */
-            /************************************/
-            mDebugSet(Touch_DebugOutput, TOUCH_DEBUG_WAIT_FOR_SCAN);
-            /* Check to see if the final capsense scan has run */
-            if(!CapSense_IsBusy())
-            {
-                /* Scan is done, update associated touch data */
-                /* Update Baselines */
-            	CapSense_UpdateEnabledBaselines();	
-                /* Check if any widget is active (this updates the SensorOn array) */
-                CapSense_CheckIsAnyWidgetActive();
-                /* Sleep the Capsense Hardware */
-                CapSense_Sleep();
-                /* Allow Deep sleep now that the hardware has finished */
-                mTouch_AllowDeepSleep();
-                
-                /* Next we will process the results */
-                mTouch_SetNextState(TOUCH_PROCESS_RESULTS);
-                mTouch_ExecuteOnNextCoOp();
-            }
-            else
-            {
-                mTouch_SetNextState(TOUCH_IS_SCAN_COMPLETE);
-                /* Wait for scan to be done.  Let the system sleep
-                   while we wait */
-                mTouch_DeQueue();
-            }
-            
-            mDebugClear(Touch_DebugOutput, TOUCH_DEBUG_WAIT_FOR_SCAN);
-        break;
-        
-        case TOUCH_PROCESS_RESULTS:
-            /************************************/
-            /*PROCESS SCAN RESULTS INTO GESTURES*/
-            /************************************/
-            mDebugSet(Touch_DebugOutput, TOUCH_DEBUG_PROCESS_RESULTS);
-            
-            /* Process Scan Results */
-            ProcessGestures();
-            
-            /* Let BLE know data is ready */
-            TouchResult.Data_Ready = true;
-            
-            /* Setup next touch scan */
-            mTouch_SetNextState(TOUCH_STARTSCAN);
-            /* finished processing, dequeue */
-            mTouch_DeQueue();
-
-            mDebugClear(Touch_DebugOutput, TOUCH_DEBUG_PROCESS_RESULTS);
-        break;
-            
-        default:
-            Log_Error(TOUCH_PROCESS_ID, TOUCH_ERROR_DEFAULT_STATE);
-            mTouch_SetNextState(TOUCH_STARTSCAN);
-            mTouch_DeQueue();
-            mTouch_DisableProcess();
-        break;
-    }     
+        /* Only the ganged sensor was scanned, a touch on it scans the slider
+        right away */
+        if(CapSense_CheckIsWidgetActive(TOUCH_GANGED_WIDGET))
+        {
+            Touch_SetMode(TOUCH_MODE_SLIDER);
+            mProcess_SetTimer(TOUCH_PROCESS, TOUCH_ACTIVE_SCAN_PERIOD_MS);
+        }
+    }
+    else
+    {
+        /* Process Scan Results */
+        ProcessGestures();
+
+        if(Gesture_IsTouching() || (Gesture == LARGE_OBJECT))
+        {
+            Touch_LastActive = WatchdogTimer_GetCount();
+        }
+        else if((WatchdogTimer_GetCount() - Touch_LastActive) >= (ACTIVE_POWER_TIMEOUT_MS * WATCHDOG_COUNTS_PER_MS))
+        {
+            Touch_SetMode(TOUCH_MODE_GANGED);
+        }
+    }
     
+    #if (CAPTURE_ENABLED == 1u)
+    Capture_Scan(TouchResult.CurrentCentroid, Gesture, Touch_Mode);
+    mBLE_QueueNotification(Capture_Notification);
     #endif
     
-    mDebugClear(Touch_DebugOutput, TOUCH_DEBUG_ENTER_SM);
+    /* Let BLE know data is ready */
+    TouchResult.Data_Ready = true;
+    mBLE_QueueNotification(Touch_Notification);
     
+    /* Hand the gesture to every consumer that wants it.  The gesture engine
+    reports a large object on every scan it stays on the slider, the consumers
+    only hear about it when it appears */
+    if((Gesture != NO_GESTURE) && !((Gesture == LARGE_OBJECT) && (Touch_PreviousGesture == LARGE_OBJECT)))
+    {
+        Touch_PostEvent(Gesture, TouchResult.CurrentCentroid);
+    }
+    Touch_PreviousGesture = Gesture;
+
+    mDebugClear(Touch_DebugOutput, TOUCH_DEBUG_PROCESS_RESULTS);
+
+    /* finished processing, the next scan starts on the next period */
+    PT_END(TOUCH_PROCESS);
+}
+#endif
+
+/*******************************************************************************
+* Function Name: Touch_PostEvent
+********************************************************************************
+*
+* Summary:
+*  Adds a gesture event to the ring and queues the consumers that subscribed
+*  to the gesture.  The ring never blocks, a consumer that is TOUCH_EVENTS
+*  behind loses its oldest event.
+*
+* Parameters:
+*  uint8 Code:     GESTURE CODE.
+*  uint8 Centroid: Slider centroid of the scan.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+static void Touch_PostEvent(uint8 Code, uint8 Centroid)
+{
+    uint8 consumer;
+    uint16 bit = mTouch_GestureBit(Code);
+    TOUCH_EVENT * event = &Touch_Events[Touch_EventHead & TOUCH_EVENT_MASK];
+
+    for(consumer = 0u; consumer < NUMBER_OF_TOUCH_CONSUMERS; consumer++)
+    {
+        /* The slot is about to be overwritten under a consumer that has not
+        read it */
+        if((uint8)(Touch_EventHead - Touch_Cursor[consumer]) >= TOUCH_EVENTS)
+        {
+            if(((Touch_Interest[consumer] & mTouch_GestureBit(event->Gesture)) != 0u) && (Touch_Lost[consumer] < 0xFFFFu))
+            {
+                Touch_Lost[consumer]++;
+            }
+            Touch_Cursor[consumer]++;
+        }
+    }
+
+    event->Timestamp = WatchdogTimer_GetTimestamp();
+    event->Gesture = Code;
+    event->Centroid = Centroid;
+    Touch_EventHead++;
+
+    for(consumer = 0u; consumer < NUMBER_OF_TOUCH_CONSUMERS; consumer++)
+    {
+        if((Touch_Interest[consumer] & bit) != 0u)
+        {
+            mProcess_Queue(Touch_Consumer[consumer]);
+        }
+    }
+
     return;
 }
 
 /*******************************************************************************
-* Function Name: GetGesture
+* Function Name: Touch_Subscribe
 ********************************************************************************
 *
 * Summary:
-*  This is the get function for the latest decoded gesture from the touch
-*  process.
+*  Sets the gestures a consumer wants.  A consumer that had no interest
+*  starts with the next gesture, not with the ones it was not subscribed to.
 *
 * Parameters:
+*  uint8 Consumer:  TOUCH_CONSUMER_.
+*  uint16 Interest: mTouch_GestureBit() of each gesture, TOUCH_INTEREST_ALL or
+*                   TOUCH_INTEREST_NONE.
+*
+* Return:
 *  None.
 *
+*******************************************************************************/
+void Touch_Subscribe(uint8 Consumer, uint16 Interest)
+{
+    if(Touch_Interest[Consumer] == TOUCH_INTEREST_NONE)
+    {
+        Touch_Cursor[Consumer] = Touch_EventHead;
+    }
+    Touch_Interest[Consumer] = Interest;
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Touch_TakeEvent
+********************************************************************************
+*
+* Summary:
+*  Takes the oldest gesture event a consumer has not read, skipping the
+*  gestures it did not subscribe to.
+*
+* Parameters:
+*  uint8 Consumer:      TOUCH_CONSUMER_.
+*  TOUCH_EVENT * Event: Output, the event.
+*
 * Return:
-*  Latest decoded gesture.
+*  TRUE if an event was taken, FALSE if the consumer has read them all.
 *
 *******************************************************************************/
-uint8 GetGesture(void)
+uint8 Touch_TakeEvent(uint8 Consumer, TOUCH_EVENT * Event)
 {
-    return Gesture;   
+    const TOUCH_EVENT * event;
+
+    while(Touch_Cursor[Consumer] != Touch_EventHead)
+    {
+        event = &Touch_Events[Touch_Cursor[Consumer] & TOUCH_EVENT_MASK];
+        Touch_Cursor[Consumer]++;
+
+        if((Touch_Interest[Consumer] & mTouch_GestureBit(event->Gesture)) != 0u)
+        {
+            *Event = *event;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*******************************************************************************
+* Function Name: Touch_GetLost
+********************************************************************************
+*
+* Summary:
+*  Returns the gesture events a consumer lost by falling TOUCH_EVENTS behind.
+*
+* Parameters:
+*  uint8 Consumer: TOUCH_CONSUMER_.
+*
+* Return:
+*  Lost events, saturated.
+*
+*******************************************************************************/
+uint16 Touch_GetLost(uint8 Consumer)
+{
+    return Touch_Lost[Consumer];
 }
 
 /*******************************************************************************
@@ -198,12 +336,8 @@ uint8 GetGesture(void)
 ********************************************************************************
 *
 * Summary:
-*  This function processes the gestures after each touch scan. Looks for the 
-*   following gestures:
-*    - Large object (all sensors active)
-*    - Swipe left
-*    - Swipe right
-*    - Tap
+*  This function processes the gestures after each slider scan, see
+*  Gesture_Rules[] for the gestures.
 *
 * Parameters:
 *  None.
@@ -213,122 +347,72 @@ uint8 GetGesture(void)
 *
 *******************************************************************************/
 void ProcessGestures(void)
-{	
-	/* Large Object Rejection: if 4 sensors are active at the same time do nothing  */
-	if ((CapSense_sensorOnMask[0] & SLIDER_MASK) == SLIDER_MASK) 
-	{
-        /* Debounce Large Object Presence */
-        /* All sensors must be active for a specified number of scans before it is considered an invalid touch */
-        large_object_count++;
-        if(large_object_count >= LARGE_OBJECT_DEBOUNCE)
-        {
-		    Gesture = LARGE_OBJECT;
-            large_object_count = 0;
-        }
-	}
+{
+    uint8 centroid;
+    uint8 wasTouching = Gesture_IsTouching();
+
+    centroid = (uint8)CapSense_GetCentroidPos(TOUCH_SLIDER_WIDGET);
+    Gesture = Gesture_Update(CapSense_sensorOnMask[0u], centroid, WatchdogTimer_GetCount());
+
+    /* A large object has no position */
+    TouchResult.CurrentCentroid = (Gesture == LARGE_OBJECT) ? NO_TOUCH : centroid;
+
+    if(Gesture_IsTouching() && !wasTouching)
+    {
+        /* Update scan period to active period, the gesture timing needs the
+        fine tick to keep up with it */
+        mProcess_SetPeriod(TOUCH_PROCESS, TOUCH_ACTIVE_SCAN_PERIOD_MS);
+        mProcess_RequestFineTick(TOUCH_PROCESS);
+    }
+    else if(!Gesture_IsTouching() && wasTouching)
+    {
+        /* No Current touch, move to Idle scan period */
+        mProcess_SetPeriod(TOUCH_PROCESS, TOUCH_IDLE_SCAN_PERIOD_MS);
+        mProcess_ReleaseFineTick(TOUCH_PROCESS);
+    }
+}
+
+/*******************************************************************************
+* Function Name: Touch_SetMode
+********************************************************************************
+*
+* Summary:
+*  Switches between scanning the ganged sensor and scanning the slider.
+*
+* Parameters:
+*  uint8 Mode: TOUCH_MODE_GANGED or TOUCH_MODE_SLIDER.
+*
+* Return:
+*  None.
+*
+* Theory:
+*  Only called with no touch in progress, ProcessGestures() moves the slider
+*  between the idle and the active period.
+*
+*******************************************************************************/
+static void Touch_SetMode(uint8 Mode)
+{
+    if(Mode == TOUCH_MODE_SLIDER)
+    {
+        CapSense_DisableWidget(TOUCH_GANGED_WIDGET);
+        CapSense_EnableWidget(TOUCH_SLIDER_WIDGET);
+        mProcess_SetPeriod(TOUCH_PROCESS, TOUCH_IDLE_SCAN_PERIOD_MS);
+        Touch_LastActive = WatchdogTimer_GetCount();
+    }
     else
     {
-        large_object_count = 0;
+        CapSense_DisableWidget(TOUCH_SLIDER_WIDGET);
+        CapSense_EnableWidget(TOUCH_GANGED_WIDGET);
+        mProcess_SetPeriod(TOUCH_PROCESS, TOUCH_GANGED_SCAN_PERIOD_MS);
+        /* Nothing has touched the slider for a while */
+        Gesture_Init();
+        Gesture = NO_GESTURE;
+        TouchResult.CurrentCentroid = NO_TOUCH;
     }
-	
-    /* After Release Clear INVALID_TOUCH Flag */
-	if ((CapSense_sensorOnMask[0] & SLIDER_MASK) == 0)
-	{
-		Gesture = NO_GESTURE;  
-	}
-	
-    /* If no current gesture (e.g. LARGE_OBJECT), then proceed with gesture detection */
-	if (Gesture == NO_GESTURE)
-	{
-        /* Get Centroid */
-		TouchResult.CurrentCentroid = CapSense_GetCentroidPos(CapSense_LINEARSLIDER0__LS); 
-        
-		/* Swipe processing */			
-		if (CapSense_sensorOnMask[0u] & SLIDER_MASK) 			
-		{
-			if (TouchResult.CurrentCentroid != NO_TOUCH) 
-			{
-				position_ready = TouchResult.CurrentCentroid;		
-			}
-			
-            /* Check to see if this is start of touch */
-			if((!touch_down)&&(TouchResult.CurrentCentroid != NO_TOUCH)) 
-			{
-				position_start = position_ready;                /* Save Start Location */
-                touch_down = TRUE;                              
-				lift_off = FALSE;
-                /* Update scan period to active period */
-                Touch_Period = TOUCH_ACTIVE_SCAN_PERIOD;
-			}
-			
-            /* Increment Touch Duration Timer */
-			active_sensor_tick++;				
-		}
-		else
-		{   
-            /* No Touch */
-            if(touch_down)      /* Is this first lift off after a touch? */
-            {
-                lift_off = TRUE;						
-				touch_down = FALSE;
-                /* No Current touch, move to Idle scan period */
-                Touch_Period = TOUCH_IDLE_SCAN_PERIOD;
-
-    			position_end = position_ready;                  /* Save End Location */
-    			
-                /* Swipe Right Direction Check */
-    			if (position_end > position_start)					
-    			{
-    				distance = position_end - position_start;
-    				direction = DIRECTION_LEFT;						
-    			}
-                /* Swipe Left Direction Check */
-    			else												
-    			{
-    				distance = position_start - position_end;
-    				direction = DIRECTION_RIGHT;
-    			}	
-                
-                /* Calculate Velocity (Not currently used) */
-    			velocity = distance / active_sensor_tick;
-                
-                /* SWIPE: Check to see if swipe distance and timing criteria are met */
-    			if ((distance > MIN_SWIPE_DISTANCE) && (active_sensor_tick >= MIN_SWIPE_TIMEOUT) && (active_sensor_tick < MAX_SWIPE_TIMEOUT))
-    			{
-    				if(direction)
-                    {
-                        Gesture = SWIPE_LEFT_GESTURE;
-                    }
-                    else
-                    {
-                        Gesture = SWIPE_RIGHT_GESTURE;
-                    }
-                    
-    			}
-                /* TAP: Check to see if tap distance and timing criteria are met */
-                else if ((distance < MAX_TAP_DISTANCE) && (active_sensor_tick >= MIN_TAP_TIMEOUT) && (active_sensor_tick < MAX_TAP_TIMEOUT))
-                {
-                    Gesture = TAP_GESTURE;
-                }
-                /* Otherwise, No Gesture */
-                else
-                {
-                    Gesture = NO_GESTURE;
-                }
-			}
-            /* Clear Touch Tick Timer */
-			active_sensor_tick = 0u;				
-		}
-	}
-	else
-	{
-        /* An Invalid Touch Occurred, Clear Variables */
-		TouchResult.CurrentCentroid = NO_TOUCH;
-		direction = 0u;
-		distance = 0u;
-        velocity = 0u;
-		active_sensor_tick = 0u;
-	}
+
+    Touch_Mode = Mode;
+
+    return;
 }
 
 /* [] END OF FILE */
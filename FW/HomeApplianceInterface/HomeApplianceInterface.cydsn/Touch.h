@@ -12,32 +12,69 @@
 
 #include "main.h"
 
-/* The process header file and mask need to be added to main.h */
-#define TOUCH_PROCESS_MASK                            ((QueueType)1u << TOUCH_PROCESS_ID)
+/* The process header file needs to be added to main.h and the process to
+Process_Table.  The handle is the process priority, see main.h */
+#define TOUCH_PROCESS                                 (TOUCH_PROCESS_PRIORITY)
 
 /* Touch active and idle scan periods must be even multiples of eachother and
  * of the Wrist detect period */
-#define TOUCH_ENABLE_INIT                             (0u)
-#define TOUCH_ACTIVE_SCAN_PERIOD_MS                   (10)
-/* How often in system ticks this process should run with an active touch */
-#define TOUCH_ACTIVE_SCAN_PERIOD                      (TOUCH_ACTIVE_SCAN_PERIOD_MS / SYSTEM_TICK_TIME_MS)
-#define TOUCH_IDLE_SCAN_PERIOD_MS                     (100)    
-/* How often in system ticks this process should run with no active touch */
-#define TOUCH_IDLE_SCAN_PERIOD                        (TOUCH_IDLE_SCAN_PERIOD_MS / SYSTEM_TICK_TIME_MS)
-
-#define S_TOUCH_STATE_INIT                            (TOUCH_STARTSCAN)
-
-/* Extern declerations */
-extern uint16 Touch_Timer_Count;
-extern uint16 Touch_Period;
-extern uint8 Touch_Enable;
-
-/* EDA Output Data Struct */
+#define TOUCH_FLAGS_INIT                              (PROCESS_FLAG_ENABLED)
+/* How often in milliseconds this process should run with an active touch */
+#define TOUCH_ACTIVE_SCAN_PERIOD_MS                   (10u)
+/* How often in milliseconds this process should run with no active touch */
+#define TOUCH_IDLE_SCAN_PERIOD_MS                     (100u)
+/* How often in milliseconds this process should run with the slider off,
+scanning only the ganged sensor */
+#define TOUCH_GANGED_SCAN_PERIOD_MS                   (100u)
+/* Shortest period the process runs at, used for its rate monotonic priority */
+#define TOUCH_PROCESS_PERIOD_INIT                     (TOUCH_ACTIVE_SCAN_PERIOD_MS)
+
+#define S_TOUCH_STATE_INIT                            (PT_STATE_INIT)
+
+/* EDA Output Data Struct.  Data_Ready only says a new centroid is ready for
+BLE, the gestures go through the gesture events */
 typedef struct{
     uint8 CurrentCentroid;
     uint8 Data_Ready;
 }Touch_Output;
 extern Touch_Output TouchResult;    
+
+/***************************************
+*         GESTURE EVENTS               *
+****************************************/
+/* Every gesture is posted to a ring of TOUCH_EVENTS and each consumer reads
+it with its own cursor, so a gesture is neither lost to a consumer that has
+not run yet nor taken away from the others by the first one that does.  A
+consumer subscribes to the gestures it wants with Touch_Subscribe(), a
+gesture only queues the processes that want it.  A consumer that falls more
+than TOUCH_EVENTS behind loses the oldest events, they are counted in its
+Lost */
+/* v------------ ADD YOUR CONSUMER HERE ------------v */
+#define TOUCH_CONSUMER_LED              (0u)
+#define TOUCH_CONSUMER_BLE              (1u)
+#define NUMBER_OF_TOUCH_CONSUMERS       (2u)
+/* ^------------ ADD YOUR CONSUMER HERE ------------^ */
+
+/* Must be a power of 2 no larger than 128 so the free running 8 bit cursors
+wrap cleanly */
+#define TOUCH_EVENTS                    (8u)
+#define TOUCH_EVENT_MASK                (TOUCH_EVENTS - 1u)
+
+#if ((TOUCH_EVENTS & TOUCH_EVENT_MASK) != 0u) || (TOUCH_EVENTS > 128u)
+    #error TOUCH_EVENTS must be a power of 2 no larger than 128
+#endif
+
+typedef struct
+{
+    uint32 Timestamp;                   /* System timestamp of the scan that made the gesture, ms */
+    uint8 Gesture;                      /* GESTURE CODE */
+    uint8 Centroid;                     /* Slider centroid of the scan, NO_TOUCH for none */
+} TOUCH_EVENT;
+
+/* Interest masks of Touch_Subscribe(), one bit per GESTURE CODE */
+#define mTouch_GestureBit(GESTURE)      (((GESTURE) == LARGE_OBJECT) ? 0x8000u : (uint16)(1u << (GESTURE)))
+#define TOUCH_INTEREST_NONE             (0x0000u)
+#define TOUCH_INTEREST_ALL              (0xFFFFu)
     
 /* Error definitions.  keep the PROCESSNAME_ERROR_DESCRIPTION format for error log parsing */
 #define TOUCH_ERROR_DEFAULT_STATE                     (0u)
@@ -51,26 +88,11 @@ extern Touch_Output TouchResult;
 #define TOUCH_DEBUG_WAIT_FOR_SCAN                     (0x04)
 #define TOUCH_DEBUG_PROCESS_RESULTS                   (0x08)
 
-/* Touch State Machine */    
-typedef enum _TOUCH_STATE
-{
-    TOUCH_STARTSCAN = 0u,
-    TOUCH_IS_SCAN_COMPLETE,
-    TOUCH_PROCESS_RESULTS,
-} T_TOUCH_STATE;
-
 /* Process Defines */
-/***************************************
-*    TUNABLE GESTURE PARAMETERS        *
-****************************************/
-#define MIN_TAP_TIMEOUT                 (1u)
-#define MAX_TAP_TIMEOUT                 (50u)
-#define MAX_TAP_DISTANCE                (15u)
-#define MIN_SWIPE_TIMEOUT               (1u)
-#define MAX_SWIPE_TIMEOUT               (50u)
-#define MIN_SWIPE_DISTANCE              (30u)
-#define LARGE_OBJECT_DEBOUNCE           (10u)   
-#define ACTIVE_POWER_TIMEOUT_MS         (3000)
+/* The gesture thresholds are the rules of Gesture_Rules[], see Gesture.c */
+/* Slider scans stop and the ganged sensor takes over when nothing has touched
+the slider for this long */
+#define ACTIVE_POWER_TIMEOUT_MS         (3000u)
 #define CUSTOM_CAPSENSE_FILTER          (1u)
 
 /***************************************
@@ -81,6 +103,17 @@ typedef enum _TOUCH_STATE
 #define SLIDER_MASK                     (0x0F)  /* Four slider sensors */
 #define GANGED_MASK                     (0x10)  /* Ganged sensor */
 
+/***************************************
+*         SCAN MODES                   *
+****************************************/
+/* The ganged sensor alone at the ganged period until it sees a touch, then
+the slider until ACTIVE_POWER_TIMEOUT_MS without a touch */
+#define TOUCH_MODE_GANGED               (0u)
+#define TOUCH_MODE_SLIDER               (1u)
+/* CapSense widgets of the slider and of the ganged sensor */
+#define TOUCH_SLIDER_WIDGET             (CapSense_LINEARSLIDER0__LS)
+#define TOUCH_GANGED_WIDGET             (CapSense_PROXIMITYSENSOR0__PROX)
+
 /***************************************
 *         GESTURE CODES                *
 ****************************************/
@@ -88,9 +121,12 @@ typedef enum _TOUCH_STATE
 #define TAP_GESTURE                     (0x01)
 #define SWIPE_LEFT_GESTURE              (0x02)
 #define SWIPE_RIGHT_GESTURE             (0x03)
+#define DOUBLE_TAP_GESTURE              (0x04)  /* A tap right after a tap, the first tap is reported too */
+#define LONG_PRESS_GESTURE              (0x05)  /* While held still */
+#define SLIDE_GESTURE                   (0x06)  /* Each step after a still hold, the centroid is the level */
+#define SWIPE_LEFT_LONG_GESTURE         (0x07)
+#define SWIPE_RIGHT_LONG_GESTURE        (0x08)
 #define LARGE_OBJECT                    (0xFF)
-#define DIRECTION_LEFT                  (0x00)
-#define DIRECTION_RIGHT                 (0x01)
 
 /* Function Prototypes */
 
@@ -100,209 +136,9 @@ void Touch_Process_Update(void);
 void Touch_Process(void);
 
 /* Process Specific Functions */
-uint8 GetGesture(void);
-    
-/* Macros */
-/* Only call Touch_Process_Update() if it is enabled */
-
-#define mTouch_ProcessTimer_Update()\
-    do\
-    {\
-        if(Touch_Enable)\
-        {\
-            Touch_Timer_Count--;\
-            if(Touch_Timer_Count == 0u)\
-            {\
-                QUEUE_NAME |= TOUCH_PROCESS_MASK;\
-                Touch_Timer_Count = Touch_Period;\
-            }\
-        }\
-    } while (0)
-    
-/* Only call Touch_Process() if it is queued */
-#define mTouch_Process()\
-    do\
-    {\
-        if((QUEUE_NAME & TOUCH_PROCESS_MASK))\
-        {\
-            Touch_Process();\
-        }\
-    } while (0)
-
-/* Enables the Touch Process */
-#define mTouch_EnableProcess()\
-    do\
-    {\
-        Touch_Enable = TOUCH_ENABLED;\
-    } while(0)
-    
-/* Disables the Touch Process */
-#define mTouch_DisableProcess()\
-    do\
-    {\
-        Touch_Enable = TOUCH_DISABLED;\
-    } while(0)
-    
-/* On the next run through the co-op loop, go to the destination next state */
-#define mTouch_SetNextState(DESTINATION_STATE)\
-    do\
-    {\
-        s_Touch_State = DESTINATION_STATE;\
-    } while(0)
-
-/* the do nothing macro */
-#define mTouch_Continue()\
-    do\
-    {\
-    } while(0)
-    
-#define mTouch_ExecuteOnNextCoOp() mTouch_Continue()
-#define mTouch_RepeatOnNextCoOp() mTouch_Continue()
-
-#define mTouch_ExecuteStateOnNextCoOp(DESTINATION_STATE)\
-    do\
-    {\
-        mTouch_SetNextState(DESTINATION_STATE);\
-        mTouch_ExecuteOnNextCoOp();\
-    } while(0)
-
-/* De-Queue and on the next tick, go to the destination state */
-#define mTouch_NextTick()\
-    do\
-    {\
-        NEXTTICK_NAME |= TOUCH_PROCESS_MASK;\
-        mTouch_DeQueue();\
-    } while(0)
-    
-#define mTouch_ExecuteOnNextTick()   mTouch_NextTick()
-#define mTouch_RepeatOnNextTick()   mTouch_NextTick()
-
-#define mTouch_ExecuteStateOnNextTick(DESTINATION_STATE)\
-    do\
-    {\
-        mTouch_SetNextState(DESTINATION_STATE);\
-        mTouch_ExecuteOnNextTick();\
-    } while(0)
-
-/* De-queue the process and when the process timer expires,
-go to the destination state */
-#define mTouch_DeQueue()\
-    do\
-    {\
-        QUEUE_NAME &= ~TOUCH_PROCESS_MASK;\
-    } while(0)
-
-#define mTouch_ExecuteOnNextPeriod() mTouch_DeQueue()
-#define mTouch_RepeatOnNextPeriod() mTouch_DeQueue()
-
-#define mTouch_ExecuteStateOnNextPeriod(DESTINATION_STATE)\
-    do\
-    {\
-        mTouch_SetNextState(DESTINATION_STATE);\
-        mTouch_ExecuteOnNextPeriod();\
-    } while(0)
-    
-/* The mTouch_ExecuteThisStateXTimes8() macro will repeat the same state 
-Multiple times through the co-op loop until the desired number of repeats has been reached.
-The maximum number of state repeats is 255 and the minimum is 1.
-When the number of repeats has been met, it will move on to the next state */
-#define mTouch_ExecuteThisStateXTimes8(REPEAT, REPEAT_ACTION, DESTINATION_STATE, DESTINATION_ACTION)\
-    do\
-    {\
-        if(Touch_SleepCountInit == TOUCH_NOT_INITIALIZED)\
-        {\
-            Touch_SleepCounter8 = REPEAT - 1u;\
-            Touch_SleepCountInit = TOUCH_INITIALIZED;\
-        }\
-        if(Touch_SleepCounter8 == 0u)\
-        {\
-            mTouch_SetNextState(DESTINATION_STATE);\
-            mTouch_##DESTINATION_ACTION();\
-            Touch_SleepCountInit = TOUCH_NOT_INITIALIZED;\
-        }\
-        else\
-        {\
-            Touch_SleepCounter8--;\
-            mTouch_##REPEAT_ACTION();\
-        }\
-    } while(0)
-    
-/* The mTouch_ExecuteThisStateXTimes16() macro will repeat the same state 
-Multiple times through the co-op loop until the desired number of repeats has been reached.
-The maximum number of state repeats is 65535 and the minimum is 1.
-When the number of repeats has been met, it will move on to the next state */
-#define mTouch_ExecuteThisStateXTimes16(REPEAT, REPEAT_ACTION, DESTINATION_STATE, DESTINATION_ACTION)\
-    do\
-    {\
-        if(Touch_SleepCountInit == TOUCH_NOT_INITIALIZED)\
-        {\
-            Touch_SleepCounter16 = REPEAT - 1u;\
-            Touch_SleepCountInit = TOUCH_INITIALIZED;\
-        }\
-        if(Touch_SleepCounter16 == 0u)\
-        {\
-            mTouch_SetNextState(DESTINATION_STATE);\
-            mTouch_##DESTINATION_ACTION();\
-            Touch_SleepCountInit = TOUCH_NOT_INITIALIZED;\
-        }\
-        else\
-        {\
-            Touch_SleepCounter16--;\
-            mTouch_##REPEAT_ACTION();\
-        }\
-    } while(0)
-    
-/* The mTouch_SleepProcess() macro will sleep the process for the
-desired number of ticks, preventing any execution of the process
-until the number of ticks has been reached.  When the desired
-number of ticks has elapsed, the state machine will execute the
-destination state.  This macro temporarily overrides the 
-process timer and sets it to the desired number of Ticks.
-The process timer will return to its original period when 
-the sleep period has ended */
-#define mTouch_SleepProcess(TICKS, DESTINATION_STATE)\
-    do\
-    {\
-        mTouch_SetNextState(DESTINATION_STATE);\
-        Touch_Timer_Count = TICKS;\
-        mTouch_DeQueue();\
-    } while(0)
-
-/* This process is OK with the device going to sleep */
-#define mTouch_AllowSleep()\
-    do\
-    {\
-        DISABLE_SLEEP_NAME &= ~TOUCH_PROCESS_MASK;\
-    } while(0)
-
-/* This process will block the device from going to sleep, but allow alt active */
-#define mTouch_DisallowSleep()\
-    do\
-    {\
-        DISABLE_SLEEP_NAME |= TOUCH_PROCESS_MASK;\
-    } while(0)
-    
-/* This process is OK with the device going to deep sleep */
-#define mTouch_AllowDeepSleep()\
-    do\
-    {\
-        DISABLE_DEEPSLEEP_NAME &= ~TOUCH_PROCESS_MASK;\
-    } while(0)
-
-/* This process will block the device from going to deep sleep, but allow alt active */
-#define mTouch_DisallowDeepSleep()\
-    do\
-    {\
-        DISABLE_DEEPSLEEP_NAME |= TOUCH_PROCESS_MASK;\
-    } while(0)
-
-
-/* Defines for Touch Process */
-#define TOUCH_ENABLED                         (0xFF)
-#define TOUCH_DISABLED                        (0u)
-
-#define TOUCH_INITIALIZED                     (0xFF)
-#define TOUCH_NOT_INITIALIZED                 (0u)
+void Touch_Subscribe(uint8 Consumer, uint16 Interest);
+uint8 Touch_TakeEvent(uint8 Consumer, TOUCH_EVENT * Event);
+uint16 Touch_GetLost(uint8 Consumer);
 
 #endif
 /* [] END OF FILE */
@@ -0,0 +1,325 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         Trace.c
+********************************************************************************
+* Description:
+*  Records the debug mask edges of every process to a RAM ring, see Trace.h.
+*
+********************************************************************************
+*/
+#include <string.h>
+#include "Trace.h"
+
+#if (TRACE_ENABLED == 1u)
+
+static TRACE_RECORD Trace_Buffer[TRACE_RECORDS];
+/* Slot of the next record and records in the ring */
+static uint16 Trace_Head;
+static uint16 Trace_Used;
+/* High bits of the clock in the last sync written, and in effect at the
+oldest record in the ring */
+static uint32 Trace_High;
+static uint16 Trace_OldestHigh;
+static uint8 Trace_Running;
+uint16 TraceOverwritten;
+
+/* Local Function Declarations */
+static void Trace_Put(uint16 Time, uint8 ID, uint8 Mask);
+
+/*******************************************************************************
+* Function Name: Trace_Init
+********************************************************************************
+*
+* Summary:
+*  Starts recording from start up.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Trace_Init(void)
+{
+    Trace_Start();
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Trace_Start
+********************************************************************************
+*
+* Summary:
+*  Clears the trace and records from now on.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Trace_Start(void)
+{
+    uint8 interruptStatus;
+
+    interruptStatus = CyEnterCriticalSection();
+    Trace_Head = 0u;
+    Trace_Used = 0u;
+    TraceOverwritten = 0u;
+    /* Not a 16 bit value, the first record writes a sync */
+    Trace_High = 0xFFFFFFFFu;
+    Trace_OldestHigh = 0u;
+    Trace_Running = TRUE;
+    CyExitCriticalSection(interruptStatus);
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Trace_Stop
+********************************************************************************
+*
+* Summary:
+*  Stops recording, the trace holds still for reading.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+*******************************************************************************/
+void Trace_Stop(void)
+{
+    Trace_Running = FALSE;
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Trace_Record
+********************************************************************************
+*
+* Summary:
+*  Records an edge of a debug mask, called by the mDebug macros.
+*
+* Parameters:
+*  const uint8 * DebugOutput: The debug pointer the mask was written through.
+*  uint8 Mask:                The debug mask.
+*  uint8 Edge:                TRACE_EDGE_SET or TRACE_EDGE_CLEAR.
+*
+* Return:
+*  None.
+*
+* Theory:
+*  May be called from interrupts.  The clock is read with interrupts masked,
+*  so the records are in time order.  A record costs the clock read and one
+*  or two 4 byte writes.
+*
+*******************************************************************************/
+void Trace_Record(const uint8 * DebugOutput, uint8 Mask, uint8 Edge)
+{
+    uint8 interruptStatus;
+    uint8 id;
+    uint32 now;
+
+    if(!Trace_Running)
+    {
+        return;
+    }
+
+    id = TestMux_GetProcessID(DebugOutput);
+    if(id >= TRACE_ID_UNKNOWN)
+    {
+        id = TRACE_ID_UNKNOWN;
+    }
+
+    interruptStatus = CyEnterCriticalSection();
+    now = WatchdogTimer_GetCount();
+    if((now >> 16u) != Trace_High)
+    {
+        Trace_High = now >> 16u;
+        Trace_Put((uint16)Trace_High, TRACE_ID_SYNC, 0u);
+    }
+    Trace_Put((uint16)now, id | Edge, Mask);
+    CyExitCriticalSection(interruptStatus);
+
+    return;
+}
+
+/*******************************************************************************
+* Function Name: Trace_Count
+********************************************************************************
+*
+* Summary:
+*  Returns the number of records Trace_Read() can read.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  The records in the ring plus the sync for the oldest one, 0 if the trace
+*  is empty.
+*
+*******************************************************************************/
+uint16 Trace_Count(void)
+{
+    return (Trace_Used != 0u) ? (Trace_Used + 1u) : 0u;
+}
+
+/*******************************************************************************
+* Function Name: Trace_Read
+********************************************************************************
+*
+* Summary:
+*  Copies a record out of the trace.
+*
+* Parameters:
+*  uint16 Index:           0 for the sync of the oldest record, 1 for the
+*                          oldest record, Trace_Count() - 1 for the newest.
+*  TRACE_RECORD * Record:  Receives the record.
+*
+* Return:
+*  TRUE if Index holds a record.
+*
+* Theory:
+*  Stop the trace first, the indexes move with every record.
+*
+*******************************************************************************/
+uint8 Trace_Read(uint16 Index, TRACE_RECORD * Record)
+{
+    uint8 interruptStatus;
+    uint8 found = FALSE;
+
+    interruptStatus = CyEnterCriticalSection();
+    if(Index < Trace_Count())
+    {
+        if(Index == 0u)
+        {
+            Record->Time = Trace_OldestHigh;
+            Record->ID = TRACE_ID_SYNC;
+            Record->Mask = 0u;
+        }
+        else
+        {
+            *Record = Trace_Buffer[((Trace_Head - Trace_Used) + (Index - 1u)) & TRACE_RECORD_MASK];
+        }
+        found = TRUE;
+    }
+    CyExitCriticalSection(interruptStatus);
+
+    return found;
+}
+
+/*******************************************************************************
+* Function Name: Trace_GetPacket
+********************************************************************************
+*
+* Summary:
+*  Fills a GATT packet with the records from Index on, see Trace.h.
+*
+* Parameters:
+*  uint16 Index:  First record.
+*  uint8 * Packet: Receives TRACE_PACKET_LEN bytes.
+*
+* Return:
+*  The number of records in the packet.
+*
+*******************************************************************************/
+uint8 Trace_GetPacket(uint16 Index, uint8 * Packet)
+{
+    uint8 i;
+    uint8 * data;
+    TRACE_RECORD record;
+
+    Set16ByPtr(&Packet[0u], Index);
+    Set16ByPtr(&Packet[2u], Trace_Count());
+
+    for(i = 0u; i < TRACE_PACKET_RECORDS; i++)
+    {
+        data = &Packet[TRACE_PACKET_HEADER_LEN + (i * 4u)];
+        if(!Trace_Read(Index + i, &record))
+        {
+            break;
+        }
+        Set16ByPtr(&data[0u], record.Time);
+        data[2u] = record.ID;
+        data[3u] = record.Mask;
+    }
+
+    memset(&Packet[TRACE_PACKET_HEADER_LEN + (i * 4u)], 0, (TRACE_PACKET_RECORDS - i) * 4u);
+
+    return i;
+}
+
+#if (PROCESS_UART_ENABLE == 1u)
+/*******************************************************************************
+* Function Name: Trace_DumpUart
+********************************************************************************
+*
+* Summary:
+*  Stops the trace and sends all of it over the UART as GATT packets, see
+*  Trace.h.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+* Theory:
+*  Blocks while the UART drains, TRACE_RECORDS / TRACE_PACKET_RECORDS
+*  packets.  Only call it when nothing else needs to run.
+*
+*******************************************************************************/
+void Trace_DumpUart(void)
+{
+    uint16 index;
+    uint8 packet[TRACE_PACKET_LEN];
+
+    Trace_Stop();
+
+    for(index = 0u; index < Trace_Count(); index += TRACE_PACKET_RECORDS)
+    {
+        (void)Trace_GetPacket(index, packet);
+        DUART_SpiUartPutArray(packet, TRACE_PACKET_LEN);
+    }
+
+    return;
+}
+#endif
+
+/* Write a record to the head of the ring, call with interrupts masked */
+static void Trace_Put(uint16 Time, uint8 ID, uint8 Mask)
+{
+    TRACE_RECORD * record = &Trace_Buffer[Trace_Head];
+
+    if(Trace_Used < TRACE_RECORDS)
+    {
+        Trace_Used++;
+    }
+    else
+    {
+        /* The head is the oldest record, the records after an overwritten
+        sync are still in its time */
+        if(record->ID == TRACE_ID_SYNC)
+        {
+            Trace_OldestHigh = record->Time;
+        }
+        if(TraceOverwritten < 0xFFFFu)
+        {
+            TraceOverwritten++;
+        }
+    }
+
+    record->Time = Time;
+    record->ID = ID;
+    record->Mask = Mask;
+    Trace_Head = (Trace_Head + 1u) & TRACE_RECORD_MASK;
+}
+
+#endif
+/* [] END OF FILE */
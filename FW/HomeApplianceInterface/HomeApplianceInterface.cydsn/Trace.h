@@ -0,0 +1,92 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         Trace.h
+********************************************************************************
+* Description:
+*  Contains defines, function prototypes, and macros for the trace recorder.
+*
+*  Every mDebugSet/mDebugClear (see TestMux.h) is recorded to a RAM ring of
+*  TRACE_RECORDS 4 byte records: the low 16 bits of the WDT clock, the
+*  process ID with the edge in bit 7, and the debug mask.  When the ring is
+*  full the oldest records are overwritten, so the trace holds the last
+*  events before it was stopped, for every process at once.
+*
+*  The clock runs at WATCHDOG_COUNTS_PER_MS counts per ms and its low 16 bits
+*  wrap every 2 s.  Whenever the high bits change a TRACE_ID_SYNC record
+*  carrying them comes first, so every record gets its full time from the
+*  last sync before it.  Reading the trace starts with a sync for the oldest
+*  record, even after the real one was overwritten.
+*
+*  The BLE diagnostics service has a TRACE_PACKET_LEN byte trace
+*  characteristic, see BLE.c.  The client writes {TRACE_COMMAND_READ, Index
+*  low, Index high}, which stops the recording so the trace holds still, and
+*  reads the packet of records from Index on.  TRACE_COMMAND_START clears the
+*  trace and records again.  With PROCESS_UART_ENABLE the same packets can
+*  be sent over the UART, see Trace_DumpUart().  The host decoder in the
+*  HostSim directory turns the packets into Chrome trace JSON.
+*
+********************************************************************************
+*/
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "main.h"
+
+/* 4 bytes each, must be a power of 2 */
+#define TRACE_RECORDS                   (256u)
+#define TRACE_RECORD_MASK               (TRACE_RECORDS - 1u)
+
+/* Edge argument of Trace_Record(), bit 7 of TRACE_RECORD.ID */
+#define TRACE_EDGE_CLEAR                (0x00u)
+#define TRACE_EDGE_SET                  (0x80u)
+#define TRACE_ID_MASK                   (0x7Fu)
+/* Time holds the high 16 bits of the clock for the records after it */
+#define TRACE_ID_SYNC                   (0x7Fu)
+/* A debug pointer the test mux does not know */
+#define TRACE_ID_UNKNOWN                (0x7Eu)
+
+#if ((TRACE_RECORDS & TRACE_RECORD_MASK) != 0u) || (TRACE_RECORDS > 0x8000u)
+    #error TRACE_RECORDS must be a power of 2 no larger than 0x8000
+#endif
+
+#if (TRACE_ENABLED == 1u) && (TESTMUX_PROCESS_ID >= TRACE_ID_UNKNOWN)
+    #error The trace has room for process IDs up to 0x7D
+#endif
+
+typedef struct
+{
+    uint16 Time;                /* low 16 bits of WatchdogTimer_GetCount() */
+    uint8 ID;                   /* process ID | edge, or TRACE_ID_SYNC */
+    uint8 Mask;                 /* the debug mask */
+} TRACE_RECORD;
+
+/* GATT packet, little endian:
+   [0..1]   Index of the first record
+   [2..3]   Records in the trace, including the first sync
+   [4..19]  Up to TRACE_PACKET_RECORDS records from Index on, as TRACE_RECORD,
+            the rest zero */
+#define TRACE_PACKET_HEADER_LEN         (4u)
+#define TRACE_PACKET_RECORDS            (4u)
+#define TRACE_PACKET_LEN                (TRACE_PACKET_HEADER_LEN + (TRACE_PACKET_RECORDS * 4u))
+
+/* First byte written to the trace characteristic */
+#define TRACE_COMMAND_READ              (0x00u)
+#define TRACE_COMMAND_START             (0x01u)
+
+/* Function Prototypes */
+void Trace_Init(void);
+void Trace_Start(void);
+void Trace_Stop(void);
+void Trace_Record(const uint8 * DebugOutput, uint8 Mask, uint8 Edge);
+uint16 Trace_Count(void);
+uint8 Trace_Read(uint16 Index, TRACE_RECORD * Record);
+uint8 Trace_GetPacket(uint16 Index, uint8 * Packet);
+#if (PROCESS_UART_ENABLE == 1u)
+void Trace_DumpUart(void);
+#endif
+
+/* Records lost to newer ones since the trace was started, saturated */
+extern uint16 TraceOverwritten;
+
+#endif
+/* [] END OF FILE */
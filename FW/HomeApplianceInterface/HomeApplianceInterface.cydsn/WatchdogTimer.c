@@ -7,6 +7,18 @@
 *  level process and therefore does not follow the same structure as block
 *  based processes.
 *
+*  The tick length can be changed at run time, see WatchdogTimer_SetTickMs().
+*  The elapsed time and the timestamp are kept in milliseconds, so nothing
+*  outside this file needs to know how long a tick is.
+*
+*  WDT0 also keeps the monotonic clock, see WatchdogTimer_GetClock().  The
+*  ISR sums the counts of the intervals that have ended and the clock adds
+*  the live count, so the clock runs at the LFCLK rate in every power mode
+*  and across tickless sleeps.
+*
+*  WDT counter 1 free runs as the alarm of the one-shot timers, see
+*  OneShot.h.  It shares the WDT interrupt with WDT0.
+*
 ********************************************************************************
 */
 
@@ -20,21 +32,38 @@
 * Macros and constants
 *****************************************************************************/
 #define WDT_PERIOD_MS               (SYSTEM_TICK_TIME_MS)
-#define WDT_TICKS_PER_MS            (32)
+#define WDT_TICKS_PER_MS            (WATCHDOG_COUNTS_PER_MS)
 #define WDT_TICKS                   (WDT_PERIOD_MS * WDT_TICKS_PER_MS)
 #define WDT_INTERRUPT_NUM           (8)
+/* Range of the 16 bit WDT0 match register */
+#define WDT_COUNTER_RANGE           (65536u)
+/* A new match value takes up to 3 LFCLK cycles to take effect.  A match this
+ * close to the current count could be missed and only hit after a wrap */
+#define WDT_MATCH_MARGIN            (4u)
 
 
 /*****************************************************************************
 * Static variables
 *****************************************************************************/
-uint16 WDT_Period = WDT_TICKS;     /* System wide WDT_Period */
+uint16 WDT_Period = WDT_TICKS;     /* System wide WDT_Period, WDT0 counts per tick */
+/* Current tick length */
+static uint16 watchdogTickMs = WDT_PERIOD_MS;
+/* Longest tickless sleep match, a whole number of ticks */
+static uint16 watchdogMaxMatch = ((WDT_COUNTER_RANGE / WDT_TICKS) * WDT_TICKS) - 1u;
 
 /*****************************************************************************
 * Public variables
 *****************************************************************************/
 /* This is the main system tick flag. Set by our regular tick event */
 static uint32 watchdogTimestamp = 0;
+/* WDT0 counts of every interval that has ended, see WatchdogTimer_GetClock() */
+static uint64 watchdogCount = 0;
+/* Milliseconds that have passed since the co-op loop last took them */
+static uint16 watchdogElapsedMs = 0;
+/* Interrupts that found the previous tick event still pending */
+static uint16 watchdogMissedTicks = 0;
+/* WDT counter 1 is counting towards an alarm */
+static uint8 watchdogAlarmArmed = FALSE;
 
 /*****************************************************************************
 * Public function definitions
@@ -47,9 +76,16 @@ static uint32 watchdogTimestamp = 0;
 * Summary:
 *  Watchdog Timer ISR. The WDT and consequently, this ISR, control the system 
 *   tick/update rate. Note that this ISR executing does not mean the WDT has
-*   expired. This function updates the WDT_ISR_Flag and resets the WDT match
-*   register, which requires reading the current value and adding the desired
-*   period to that value and updating the WDT_MATCH_REG.
+*   expired. The counter clears on match, so the match register holds the
+*   length of the interval that just ended.  With tickless idle this can be
+*   several system ticks.  That time is added to the timestamp and to the
+*   elapsed time for the co-op loop, and the match is put back to a single
+*   tick so the loop gets regular ticks while it is busy.  A tick length
+*   change takes effect here if no tickless sleep has picked it up first.
+*   If the co-op loop has not taken the previous tick yet, that tick is
+*   counted as missed.  Its time still reaches the process timers through the
+*   elapsed time, but the processes ran a tick late.
+*   A counter 1 match posts EVENT_SOURCE_ONESHOT for the one-shot timers.
 *
 * Parameters:
 *  None.
@@ -58,19 +94,57 @@ static uint32 watchdogTimestamp = 0;
 *  None.
 *
 * Global Variables:
-*  WDT_ISR_Flag - Informs main loop that a tick / WDT ISR has occurred.
+*  Event_Ring - Posts EVENT_SOURCE_COOP_TICK to inform the main loop that a
+*               tick / WDT ISR has occurred.
 *
 *******************************************************************************/
 CY_ISR(WatchdogTimer_Isr)
 {   
-	/* Set the WDT Timer ISR flag */
-    //CoOpTick = 1;
-    WakeupSource |= COOP_TICK;
+    uint16 ms;
+    uint32 match;
+    uint32 status = CySysWdtGetInterruptStatus();
+    
+    /* One-shot alarm */
+    if((status & CY_SYS_WDT_COUNTER1_INT) != 0u)
+    {
+        CySysWdtClearInterrupt(CY_SYS_WDT_COUNTER1_INT);
+        (void)Event_Post(EVENT_SOURCE_ONESHOT, 0u);
+    }
+    
+    if((status & CY_SYS_WDT_COUNTER0_INT) == 0u)
+    {
+        return;
+    }
+    
+    /* The co-op loop is still busy with the last tick */
+    if(mEvent_IsPending(EVENT_SOURCE_COOP_TICK))
+    {
+        watchdogMissedTicks++;
+    }
+    
+    /* Length of the interval that just ended.  Every match is a whole
+     * number of ticks, and so of milliseconds */
+    match = CySysWdtReadMatch(0);
+    ms = (uint16)((match + 1u) / WDT_TICKS_PER_MS);
     
     /* Update the system timestamp - the watchdog period time has elapsed
      * since the last interrupt.
      */
-    watchdogTimestamp += WDT_PERIOD_MS;
+    watchdogTimestamp += ms;
+    watchdogElapsedMs += ms;
+    watchdogCount += match + 1u;
+    
+    /* Tell the co-op loop a tick has occurred.  A full ring only loses the
+     * event, its time is already in the elapsed time */
+    Event_Post(EVENT_SOURCE_COOP_TICK, ms);
+    
+    /* Back to one tick per interrupt after a tickless sleep */
+    if(match != (WDT_Period - 1u))
+    {
+        CySysWdtUnlock();
+        CySysWdtWriteMatch(0, WDT_Period - 1u);
+        CySysWdtLock();
+    }
 	
 	/* Clear WDT interrupt */
     CySysWdtClearInterrupt(CY_SYS_WDT_COUNTER0_INT);
@@ -125,7 +199,12 @@ void WatchdogTimer_Init(void)
     
     /* Set the value of the match register. Since the count starts from zero, 
      * the actual value is the (intended - 1). */
-    CySysWdtWriteMatch(0, WDT_TICKS - 1);
+    CySysWdtWriteMatch(0, WDT_Period - 1u);
+    
+    /* Counter 1 free runs and interrupts on match when a one-shot timer
+     * enables it, see WatchdogTimer_SetAlarm() */
+    CySysWdtWriteMode(1, CY_SYS_WDT_MODE_INT);
+    CySysWdtWriteClearOnMatch(1, 0);
     
     /* Enable the WDT0 */
     CySysWdtEnable(CY_SYS_WDT_COUNTER0_MASK);
@@ -147,10 +226,13 @@ void WatchdogTimer_Init(void)
 * None
 *
 * Return:
-* uint32: Current system timestamp 
+* uint32: Current system timestamp in ms
 *
 * Theory:
-* The function returns the watchdog timestamp.
+* The function returns the watchdog timestamp.  It only moves on in the ISR,
+* a whole interval at a time, which makes it cheap enough for the interrupt
+* event records.  Use WatchdogTimer_GetClock() to time anything shorter than
+* a tick.
 *
 * Side Effects:
 * None
@@ -161,5 +243,439 @@ uint32 WatchdogTimer_GetTimestamp(void)
     return watchdogTimestamp;
 }
 
+/*****************************************************************************
+* Function Name: WatchdogTimer_GetClock
+******************************************************************************
+* Summary:
+* Returns the WDT0 counts since start up, a monotonic clock with a
+* resolution of one LFCLK cycle that keeps running in every power mode.
+*
+* Parameters:
+* None
+*
+* Return:
+* uint64: WDT0 counts since start up, WATCHDOG_COUNTS_PER_MS per ms
+*
+* Theory:
+* The counts of the intervals that have ended plus the current count.  If
+* the counter has cleared on a match the ISR has not handled yet, because
+* interrupts are disabled or we just woke up, that interval is added here
+* and the count is read again after the clear.  The match still holds the
+* length of that interval, WatchdogTimer_SetNextWakeup() leaves it alone
+* while the interrupt is pending.  Interrupts are disabled while the two
+* parts are read, so the ISR cannot move the sum in between.
+*
+* Side Effects:
+* None
+*
+*****************************************************************************/
+uint64 WatchdogTimer_GetClock(void)
+{
+    uint8 interruptStatus;
+    uint32 count;
+    uint64 base;
+    
+    interruptStatus = CyEnterCriticalSection();
+    base = watchdogCount;
+    count = CySysWdtReadCount(0);
+    if((CySysWdtGetInterruptStatus() & CY_SYS_WDT_COUNTER0_INT) != 0u)
+    {
+        base += CySysWdtReadMatch(0) + 1u;
+        count = CySysWdtReadCount(0);
+    }
+    CyExitCriticalSection(interruptStatus);
+    
+    return base + count;
+}
+
+/*****************************************************************************
+* Function Name: WatchdogTimer_GetClockUs
+******************************************************************************
+* Summary:
+* Returns the monotonic clock in microseconds.
+*
+* Parameters:
+* None
+*
+* Return:
+* uint64: Microseconds since start up, in steps of one WDT0 count
+*
+* Side Effects:
+* None
+*
+*****************************************************************************/
+uint64 WatchdogTimer_GetClockUs(void)
+{
+    return mWatchdogTimer_CountsToUs(WatchdogTimer_GetClock());
+}
+
+/*****************************************************************************
+* Function Name: WatchdogTimer_GetClockMs
+******************************************************************************
+* Summary:
+* Returns the monotonic clock in milliseconds.
+*
+* Parameters:
+* None
+*
+* Return:
+* uint64: Milliseconds since start up
+*
+* Side Effects:
+* None
+*
+*****************************************************************************/
+uint64 WatchdogTimer_GetClockMs(void)
+{
+    return WatchdogTimer_GetClock() / WDT_TICKS_PER_MS;
+}
+
+/*****************************************************************************
+* Function Name: WatchdogTimer_GetCount
+******************************************************************************
+* Summary:
+* Returns the low 32 bits of the monotonic clock, see WatchdogTimer_GetClock().
+*
+* Parameters:
+* None
+*
+* Return:
+* uint32: WDT0 counts since start up.  Wraps after 36 hours, use differences
+*
+* Side Effects:
+* None
+*
+*****************************************************************************/
+uint32 WatchdogTimer_GetCount(void)
+{
+    return (uint32)WatchdogTimer_GetClock();
+}
+
+/*****************************************************************************
+* Function Name: WatchdogTimer_TakeElapsedMs
+******************************************************************************
+* Summary:
+* Returns the number of milliseconds that have passed since the last call.
+*
+* Parameters:
+* None
+*
+* Return:
+* uint16: Milliseconds since the last call
+*
+* Theory:
+* Normally one tick per tick event.  After a tickless sleep it is the length
+* of the sleep, so the co-op loop can advance every process timer in one step.
+*
+* Side Effects:
+* None
+*
+*****************************************************************************/
+uint16 WatchdogTimer_TakeElapsedMs(void)
+{
+    uint8 interruptStatus;
+    uint16 ms;
+    
+    interruptStatus = CyEnterCriticalSection();
+    ms = watchdogElapsedMs;
+    watchdogElapsedMs = 0u;
+    CyExitCriticalSection(interruptStatus);
+    
+    return ms;
+}
+
+/*****************************************************************************
+* Function Name: WatchdogTimer_TakeMissedTicks
+******************************************************************************
+* Summary:
+* Returns the number of ticks missed since the last call.
+*
+* Parameters:
+* None
+*
+* Return:
+* uint16: WDT interrupts that arrived while the last tick event was pending
+*
+* Side Effects:
+* None
+*
+*****************************************************************************/
+uint16 WatchdogTimer_TakeMissedTicks(void)
+{
+    uint8 interruptStatus;
+    uint16 ticks;
+    
+    interruptStatus = CyEnterCriticalSection();
+    ticks = watchdogMissedTicks;
+    watchdogMissedTicks = 0u;
+    CyExitCriticalSection(interruptStatus);
+    
+    return ticks;
+}
+
+/*****************************************************************************
+* Function Name: WatchdogTimer_SetNextWakeup
+******************************************************************************
+* Summary:
+* Moves the next system tick interrupt out to the first tick boundary at or
+* after the given time.
+*
+* Parameters:
+* Ms: milliseconds from the last tick interrupt, 1 for the next tick.
+*     Limited to the longest match WDT0 can time.
+*
+* Return:
+* None
+*
+* Theory:
+* WDT0 clears on match, so its count is the time since the last interrupt,
+* the point the co-op loop last advanced the process timers to.  The new
+* match is placed on a tick boundary counted from there, which keeps the
+* tick phase when we were woken early by another source, and it is never
+* earlier than the next boundary still ahead of the count.  With a coarse
+* tick, deadlines between two ticks are served on the later one, which lets
+* the timers of several processes share a wakeup.  The ISR restores the
+* single tick match.  Call with interrupts disabled so the ISR cannot run
+* between reading the count and writing the match.  If the counter has
+* already cleared on a match the ISR has not handled, the match is left
+* alone: the ISR reads it as the length of the interval that ended, and the
+* co-op loop takes that tick before it sleeps.
+*
+* Side Effects:
+* None
+*
+*****************************************************************************/
+void WatchdogTimer_SetNextWakeup(uint16 Ms)
+{
+    uint32 count;
+    uint32 ticks;
+    uint32 match;
+    
+    if((CySysWdtGetInterruptStatus() & CY_SYS_WDT_COUNTER0_INT) != 0u)
+    {
+        return;
+    }
+    
+    /* Round up to whole ticks */
+    ticks = ((uint32)Ms + watchdogTickMs - 1u) / watchdogTickMs;
+    
+    count = CySysWdtReadCount(0);
+    if(ticks <= (count / WDT_Period))
+    {
+        ticks = (count / WDT_Period) + 1u;
+    }
+    
+    match = (ticks * WDT_Period) - 1u;
+    if(match > watchdogMaxMatch)
+    {
+        match = watchdogMaxMatch;
+    }
+    
+    /* Leave the current match alone if the new one could be missed or
+     * nothing changes */
+    if((match >= (count + WDT_MATCH_MARGIN)) && (match != CySysWdtReadMatch(0)))
+    {
+        CySysWdtUnlock();
+        CySysWdtWriteMatch(0, match);
+        CySysWdtLock();
+    }
+}
+
+/*****************************************************************************
+* Function Name: WatchdogTimer_GetTimeToWakeup
+******************************************************************************
+* Summary:
+* Returns the time until the next WDT interrupt, the WDT0 match or the
+* alarm.
+*
+* Parameters:
+* None
+*
+* Return:
+* uint32: Microseconds until the next WDT match, 0 if it is due
+*
+* Theory:
+* One WDT count is 1000 / WATCHDOG_COUNTS_PER_MS microseconds.  Counter 1
+* free runs, the alarm is due when it wraps round to its match.
+*
+* Side Effects:
+* None
+*
+*****************************************************************************/
+uint32 WatchdogTimer_GetTimeToWakeup(void)
+{
+    uint32 count = CySysWdtReadCount(0);
+    uint32 match = CySysWdtReadMatch(0);
+    uint32 counts;
+    uint32 alarm;
+    
+    if(match <= count)
+    {
+        return 0u;
+    }
+    counts = match - count;
+    
+    if(watchdogAlarmArmed)
+    {
+        alarm = (CySysWdtReadMatch(1) - CySysWdtReadCount(1)) & (WDT_COUNTER_RANGE - 1u);
+        if(alarm < counts)
+        {
+            counts = alarm;
+        }
+    }
+    
+    return mWatchdogTimer_CountsToUs(counts);
+}
+
+/*****************************************************************************
+* Function Name: WatchdogTimer_SetAlarm
+******************************************************************************
+* Summary:
+* Arms WDT counter 1 to interrupt a number of counts from now.
+*
+* Parameters:
+* Counts: WDT counts from now, WDT_MATCH_MARGIN to WDT_COUNTER_RANGE - 1.
+*         Values outside are limited to that range.
+*
+* Return:
+* None
+*
+* Theory:
+* Counter 1 free runs, so the match goes Counts ahead of the current count.
+* The counter is only enabled while an alarm is armed, enabling it takes a
+* few LFCLK cycles.  A match that was already pending still interrupts, the
+* one-shot service finds nothing due and arms the alarm again.
+*
+* Side Effects:
+* None
+*
+*****************************************************************************/
+void WatchdogTimer_SetAlarm(uint32 Counts)
+{
+    uint8 interruptStatus;
+    
+    if(Counts < WDT_MATCH_MARGIN)
+    {
+        Counts = WDT_MATCH_MARGIN;
+    }
+    else if(Counts > (WDT_COUNTER_RANGE - 1u))
+    {
+        Counts = WDT_COUNTER_RANGE - 1u;
+    }
+    
+    interruptStatus = CyEnterCriticalSection();
+    CySysWdtUnlock();
+    if(!watchdogAlarmArmed)
+    {
+        CySysWdtEnable(CY_SYS_WDT_COUNTER1_MASK);
+        watchdogAlarmArmed = TRUE;
+    }
+    CySysWdtWriteMatch(1, (CySysWdtReadCount(1) + Counts) & (WDT_COUNTER_RANGE - 1u));
+    CySysWdtLock();
+    CyExitCriticalSection(interruptStatus);
+}
+
+/*****************************************************************************
+* Function Name: WatchdogTimer_StopAlarm
+******************************************************************************
+* Summary:
+* Stops WDT counter 1.  Stopping a stopped alarm does nothing.
+*
+* Parameters:
+* None
+*
+* Return:
+* None
+*
+* Side Effects:
+* None
+*
+*****************************************************************************/
+void WatchdogTimer_StopAlarm(void)
+{
+    uint8 interruptStatus;
+    
+    if(!watchdogAlarmArmed)
+    {
+        return;
+    }
+    
+    interruptStatus = CyEnterCriticalSection();
+    CySysWdtUnlock();
+    CySysWdtDisable(CY_SYS_WDT_COUNTER1_MASK);
+    CySysWdtLock();
+    CySysWdtClearInterrupt(CY_SYS_WDT_COUNTER1_INT);
+    watchdogAlarmArmed = FALSE;
+    CyExitCriticalSection(interruptStatus);
+}
+
+/*****************************************************************************
+* Function Name: WatchdogTimer_SetTickMs
+******************************************************************************
+* Summary:
+* Changes the system tick length.
+*
+* Parameters:
+* Ms: new tick length, 1 to WATCHDOG_MAX_TICK_MS.
+*
+* Return:
+* None
+*
+* Theory:
+* Only the length of the following intervals changes.  The current interval
+* ends on its programmed match, then the ISR arms the new tick, or a tickless
+* sleep arms it first through WatchdogTimer_SetNextWakeup().  The process
+* timers count milliseconds, so they need no rescaling.
+*
+* Side Effects:
+* None
+*
+*****************************************************************************/
+void WatchdogTimer_SetTickMs(uint16 Ms)
+{
+    uint8 interruptStatus;
+    
+    if(Ms == watchdogTickMs)
+    {
+        return;
+    }
+    
+    if(Ms == 0u)
+    {
+        Ms = 1u;
+    }
+    else if(Ms > WATCHDOG_MAX_TICK_MS)
+    {
+        Ms = WATCHDOG_MAX_TICK_MS;
+    }
+    
+    interruptStatus = CyEnterCriticalSection();
+    watchdogTickMs = Ms;
+    WDT_Period = (uint16)(Ms * WDT_TICKS_PER_MS);
+    watchdogMaxMatch = (uint16)(((WDT_COUNTER_RANGE / WDT_Period) * WDT_Period) - 1u);
+    CyExitCriticalSection(interruptStatus);
+}
+
+/*****************************************************************************
+* Function Name: WatchdogTimer_GetTickMs
+******************************************************************************
+* Summary:
+* Returns the current system tick length.
+*
+* Parameters:
+* None
+*
+* Return:
+* uint16: Tick length in milliseconds
+*
+* Side Effects:
+* None
+*
+*****************************************************************************/
+uint16 WatchdogTimer_GetTickMs(void)
+{
+    return watchdogTickMs;
+}
+
 
 /* [] END OF FILE */
@@ -22,6 +22,31 @@
 CY_ISR_PROTO(WatchdogTimer_Isr);
 extern void WatchdogTimer_Init(void);
 uint32 WatchdogTimer_GetTimestamp(void);
+uint64 WatchdogTimer_GetClock(void);
+uint64 WatchdogTimer_GetClockUs(void);
+uint64 WatchdogTimer_GetClockMs(void);
+uint32 WatchdogTimer_GetCount(void);
+uint16 WatchdogTimer_TakeElapsedMs(void);
+uint16 WatchdogTimer_TakeMissedTicks(void);
+void WatchdogTimer_SetNextWakeup(uint16 Ms);
+uint32 WatchdogTimer_GetTimeToWakeup(void);
+void WatchdogTimer_SetAlarm(uint32 Counts);
+void WatchdogTimer_StopAlarm(void);
+void WatchdogTimer_SetTickMs(uint16 Ms);
+uint16 WatchdogTimer_GetTickMs(void);
+
+/*****************************************************************************
+* Public defines
+*****************************************************************************/
+/* WDT0 counts per millisecond */
+#define WATCHDOG_COUNTS_PER_MS      (32u)
+/* Longest tickless sleep the 16 bit WDT0 match register can time */
+#define WATCHDOG_MAX_SLEEP_MS       (65536u / WATCHDOG_COUNTS_PER_MS)
+/* Longest tick, a tick must fit in the match register */
+#define WATCHDOG_MAX_TICK_MS        (WATCHDOG_MAX_SLEEP_MS - 1u)
+
+/* WDT0 counts to microseconds, a count is 31.25 us */
+#define mWatchdogTimer_CountsToUs(COUNTS)   (((COUNTS) * 1000u) / WATCHDOG_COUNTS_PER_MS)
 
 /*****************************************************************************
 * Public variables
@@ -14,36 +14,65 @@
 /* There is no need to modify these variables */
 /* These variables are bit fields where each bit corresponds to a process
 The ActiveQueue indicates which processes are active for the current tick */
-QueueType ActiveQueue_Flags = 0u;
+QueueType ActiveQueue_Flags = {0u};
 /* The NextTick bit fields indicate which processes would like to be executed
 on the next tick event */
-QueueType NextTick_Flags = 0u;
+QueueType NextTick_Flags = {0u};
 /* The DisableSleep and DisableAltActive bitfields indicate which processes
 cannot allow sleep or alt active modes */
-QueueType DisableSleep_Flags = 0u;
-QueueType DisableDeepSleep_Flags = 0u;
-/* Bit flag variable used to identify wakeup source.  This is in turn
- * used to decide which process timers need to be updated */
-uint8 WakeupSource;
-
+QueueType DisableSleep_Flags = {0u};
+QueueType DisableDeepSleep_Flags = {0u};
+/* The FineTick bit fields indicate which processes need the fine system tick */
+QueueType FineTick_Flags = {0u};
 /* Controls shared access to the ADC */
-MUTEX ADC_Mutex = UNLOCKED;
+MUTEX ADC_Mutex = MUTEX_INIT;
 
 /* If process debugging is enabled, define the debug pointer */
-#if (PROCESS_DEBUG_ENABLED == 1u)
+#if (DEBUG_POINTERS_ENABLED == 1u)
     uint8 * System_DebugOutput;
 #endif
 
 void main()
 {
+    uint8 Priority;
+    uint16 ElapsedMs;
+    EVENT Tick;
+    EVENT Alarm;
+    #if (PROFILER_ENABLED == 1u)
+    PROFILER_SAMPLE Profile;
+    #endif
+    #if (ENABLE_SLEEP == 0u)
+    uint32 BusyStart;
+    #endif
+    #if (ENABLE_SLEEP == 1u) && (TICKLESS_IDLE_ENABLED == 1u)
+    uint16 SleepMs;
+    uint8 interruptStatus;
+    #endif
+    
     CyGlobalIntEnable;
     
     /* low power and system initializations */
     Sleep_Init();
-    #if (PROCESS_DEBUG_ENABLED == 1u)
+    #if (DEBUG_POINTERS_ENABLED == 1u)
     TestMux_Init();
+    /* register the system debug pointer with the test mux before anything
+    can log an error, Log_Error() writes through it */
+    if(TestMux_Register(SYSTEM_PROCESS_ID, &System_DebugOutput) == TESTMUX_FAIL)
+    {
+        /* if there was a failure during registration, log the error */
+        Log_Error(SYSTEM_PROCESS_ID, SYSTEM_ERROR_FAILED_TO_REGISTER_TESTMUX);
+    }
     #endif
     WatchdogTimer_Init();
+    Profiler_Init();
+    #if (ERROR_STORE_ENABLED == 1u)
+    /* Find the newest saved row before anything logs */
+    ErrorStore_Init();
+    #endif
+    #if (TRACE_ENABLED == 1u)
+    Trace_Init();
+    #endif
+    Timer_InitWheel();
 
     /* System initializations */
     
@@ -55,14 +84,9 @@ void main()
     CySysClkWriteEcoDiv(CY_SYS_CLK_ECO_DIV8);
     
     /* Initialize added Processes. This executes any initialization that the processes
-    need to run only once after a reset event */
-    
-    /* v------------- ADD YOUR PROCESS HERE -------------v */
-    Batt_Process_Init();
-    BLE_Process_Init();
-    LED_Process_Init();
-    Touch_Process_Init();
-    /* ^------------- ADD YOUR PROCESS HERE -------------^ */
+    need to run only once after a reset event.  Processes are added in
+    Process.c */
+    Process_InitAll();
     
     /* Call after processes have been initialized so that their test mux
     outputs can be used */
@@ -72,8 +96,7 @@ void main()
     first time */
 //    CoOpTick = 0u;
 //    while (CoOpTick == 0u){};
-    WakeupSource = 0u;
-    while((WakeupSource & COOP_TICK) == 0){};
+    while(!mEvent_IsPending(EVENT_SOURCE_COOP_TICK)){ mBusyWaitHook(); };
     
     /* A tick event has occurred.
     Run the multi-tasking, process sharing co-operative loop */
@@ -82,76 +105,119 @@ void main()
         /* Process Timer updates. This allows each process to update its
         internal timer to decide if it needs to add itself to the queue */
         
-        /* v------------- ADD YOUR PROCESS HERE -------------v */
         /* Only update processes if the system tick woke us up */
-        if(WakeupSource & COOP_TICK)
+        if(mEvent_IsPending(EVENT_SOURCE_COOP_TICK))
         {            
             /* If process debugging is enabled, pulse the tick event pin */
             mDebugSet(System_DebugOutput, DEBUG_COOP_TICK_MASK);
             
+            /* Record processes the last tick left queued and ticks the
+            loop was too busy to see */
+            Process_CheckOverrun(WatchdogTimer_TakeMissedTicks());
+            
             /* Place any NextTick processes into queue and then clear 
             the next tick requests */
-            QUEUE_NAME |= NEXTTICK_NAME;
-            NEXTTICK_NAME = 0u;
+            mQueue_MoveAll(QUEUE_NAME, NEXTTICK_NAME);
             
-            /* Clear SysTick Flag (set in WatchdogTimer_Isr) 
-             * This flag must be cleared only when the coop loop
-             * sees that it is set, otherwise we will miss system ticks */
-            //CoOpTick = 0u;
-            WakeupSource &= ~COOP_TICK;
+            /* Take the tick events (posted in WatchdogTimer_Isr).  More
+             * than one is pending if the loop ran late, the time of every
+             * one of them reaches the process timers through the elapsed
+             * time */
+            while(Event_Take(EVENT_SOURCE_COOP_TICK, &Tick)){}
             
-            /* ^------------- ADD YOUR PROCESS UPDATE HERE -------------^ */
-            mBatt_ProcessTimer_Update();
-            mLED_ProcessTimer_Update();
-            mTouch_ProcessTimer_Update();
+            /* More than one tick has passed if we slept tickless.  The
+             * timer wheel queues the processes whose timers expired */
+            ElapsedMs = WatchdogTimer_TakeElapsedMs();
+            Timer_Advance(ElapsedMs);
             mDebugClear(System_DebugOutput, DEBUG_COOP_TICK_MASK);
         }
-        /* If a CSD scan woke us up run the touch process to finish up the scan
-        */
-        if(WakeupSource & CSD_SCAN)
+        /* Queue the owners of the other interrupt events, e.g. a CSD scan
+        queues the touch process to finish up the scan */
+        Event_Route();
+        
+        /* Queue the owners of the one-shot timers that are due */
+        if(mEvent_IsPending(EVENT_SOURCE_ONESHOT))
         {
-            QUEUE_NAME |= (TOUCH_PROCESS_MASK);
-            WakeupSource &= ~CSD_SCAN;
-        }       
-        /* BLE runs everytime the system wakes up */
-        mBLE_ProcessTimer_Update();
+            while(Event_Take(EVENT_SOURCE_ONESHOT, &Alarm)){}
+            OneShot_Service();
+        }
+        
+        /* Processes flagged PROCESS_FLAG_EVERY_WAKEUP run whatever woke us */
+        Process_QueueOnWakeup();
         
         /* Co-operative Loop
         Run all processes until queue is empty or we run out of time */
-        while((ActiveQueue_Flags != 0u) && ((WakeupSource & COOP_TICK) == 0))
+        while(!mQueue_IsEmpty(QUEUE_NAME) && !mEvent_IsPending(EVENT_SOURCE_COOP_TICK))
         {
             /* If process debugging is enabled, set the CoOp pin */
             mDebugSet(System_DebugOutput, DEBUG_COOP_LOOP_MASK);
             
-            /* execute the processes */
+            /* Find the next queued process, see SCHEDULER_ROUND_ROBIN */
+            Priority = Process_GetNext();
             
-            /* v------------- ADD YOUR PROCESS HERE -------------v */
-            mBatt_Process();
-            mBLE_Process();
-            mLED_Process();
-            mTouch_Process();
-            /* ^------------- ADD YOUR PROCESS HERE -------------^ */
+            /* execute the process */
+            mProfiler_Start(Profile, Process_Table[Priority].State);
+            Process_Table[Priority].Function();
+            mProfiler_Stop(Profile, Process_Table[Priority].ID);
             
             /* If process debugging is enabled, clear the CoOp pin */
             mDebugClear(System_DebugOutput, DEBUG_COOP_LOOP_MASK);
         }
         
+        #if (ERROR_STORE_ENABLED == 1u)
+        /* Save changed error records in batches while we are awake anyway */
+        if(mQueue_IsEmpty(QUEUE_NAME) && !mEvent_IsPending(EVENT_SOURCE_COOP_TICK))
+        {
+            ErrorStore_Service();
+        }
+        #endif
+        
+        #if (ADAPTIVE_TICK_ENABLED == 1u)
+        /* Coarse ticks unless a process needs the fine one */
+        if(mQueue_IsEmpty(FINETICK_NAME))
+        {
+            WatchdogTimer_SetTickMs(SYSTEM_TICK_COARSE_MS);
+        }
+        else
+        {
+            WatchdogTimer_SetTickMs(SYSTEM_TICK_TIME_MS);
+        }
+        #endif
+        
         #if(ENABLE_SLEEP == (1u))
         /* Go to sleep with remaining time, unless a tick has already occurred */
-        if((WakeupSource & COOP_TICK) == 0)
+        if(!mEvent_IsPending(EVENT_SOURCE_COOP_TICK))
         {   
+            #if (TICKLESS_IDLE_ENABLED == 1u)
+            /* Sleep until the earliest process deadline */
+            SleepMs = Process_TimeUntilDue(WATCHDOG_MAX_SLEEP_MS);
+            
+            /* A tick that arrives while the match is moved would be lost */
+            interruptStatus = CyEnterCriticalSection();
+            if(!mEvent_IsPending(EVENT_SOURCE_COOP_TICK))
+            {
+                WatchdogTimer_SetNextWakeup(SleepMs);
+            }
+            CyExitCriticalSection(interruptStatus);
+            #endif
+            
             /* If process debugging is enabled, set the Sleep pin */
             mDebugSet(System_DebugOutput, DEBUG_SLEEP_MASK);
             
             /* enter Sleep mode */
+            mProfiler_Start(Profile, 0u);
             Sleep_Process();   
+            mProfiler_Stop(Profile, SLEEP_PROCESS_ID);
             
             /* If process debugging is enabled, clear the Sleep pin */
             mDebugClear(System_DebugOutput, DEBUG_SLEEP_MASK);
         }
         #else
         /* wait for the next system tick */
-        while(WakeupSource == 0){}
+        BusyStart = WatchdogTimer_GetCount();
+        while(!Event_IsAnyPending()){ mBusyWaitHook(); }
+        Sleep_AddResidency(SLEEP_MODE_NONE, BusyStart);
+        Sleep_CountWakeup();
         #endif
     }
 }
@@ -159,13 +225,6 @@ void main()
 void System_TestMux_Init(void)
 {
     #if (PROCESS_DEBUG_ENABLED == 1u)
-        /* register the system debug pointer with the test mux */
-        if(TestMux_Register(SYSTEM_PROCESS_ID, &System_DebugOutput) == TESTMUX_FAIL)
-        {
-            /* if there was a failure during registration, log the error */
-            Log_Error(SYSTEM_PROCESS_ID, SYSTEM_ERROR_FAILED_TO_REGISTER_TESTMUX);
-        }
-        
         /* DEBUG 0 - P3[4] */
         /* select a process to go to the control 0 debug output register  */
         if(TestMux_SelectProcess0(SYSTEM_PROCESS_ID) == TESTMUX_FAIL)
@@ -31,13 +31,13 @@
 #include "BLE.h"
 #define BLE_PROCESS_ID               (1u)
     
-#include "LED.h"
-#define LED_PROCESS_ID               (2u)
+#include "Touch.h"
+#define TOUCH_PROCESS_ID             (2u)
     
-#include "TOUCH.h"
-#define TOUCH_PROCESS_ID             (3u)
+#include "LED.h"
+#define LED_PROCESS_ID               (3u)
     
-#include "SLEEP.h"
+#include "Sleep.h"
 #define SLEEP_PROCESS_ID             (4u)    
 /* ^------------- ADD YOUR PROCESS HERE -------------^ */
 
@@ -47,6 +47,27 @@
 #define NUMBER_OF_PROCESSES         (5u)
 /* ^------------- UPDATE THIS VALUE -------------^ */
 
+/* Process priorities are assigned rate monotonic: the shorter a process'
+*_PROCESS_PERIOD_INIT, the higher its priority.  Processes with equal periods
+are ordered by process ID, so give lower IDs to the more latency sensitive
+processes.  Priority 0 is the highest and is also the process' bit in the
+queue variables and its entry in Process_Table, see Process.h */
+#define mHigherPriority(OTHER_PERIOD, OTHER_ID, PERIOD, ID)\
+    (((OTHER_PERIOD) < (PERIOD)) || (((OTHER_PERIOD) == (PERIOD)) && ((OTHER_ID) < (ID))))
+
+/* v------------- ADD YOUR PROCESS HERE -------------v */
+#define mProcessPriority(PERIOD, ID)\
+    (mHigherPriority(BATT_PROCESS_PERIOD_INIT, BATT_PROCESS_ID, PERIOD, ID) +\
+     mHigherPriority(BLE_PROCESS_PERIOD_INIT, BLE_PROCESS_ID, PERIOD, ID) +\
+     mHigherPriority(TOUCH_PROCESS_PERIOD_INIT, TOUCH_PROCESS_ID, PERIOD, ID) +\
+     mHigherPriority(LED_PROCESS_PERIOD_INIT, LED_PROCESS_ID, PERIOD, ID))
+
+#define BATT_PROCESS_PRIORITY        mProcessPriority(BATT_PROCESS_PERIOD_INIT, BATT_PROCESS_ID)
+#define BLE_PROCESS_PRIORITY         mProcessPriority(BLE_PROCESS_PERIOD_INIT, BLE_PROCESS_ID)
+#define TOUCH_PROCESS_PRIORITY       mProcessPriority(TOUCH_PROCESS_PERIOD_INIT, TOUCH_PROCESS_ID)
+#define LED_PROCESS_PRIORITY         mProcessPriority(LED_PROCESS_PERIOD_INIT, LED_PROCESS_ID)
+/* ^------------- ADD YOUR PROCESS HERE -------------^ */
+
 #define ProjectMajorVersion         (0u)
 #define ProjectMinorVersion         (0u)
 
@@ -54,12 +75,50 @@
 *        SYSTEM DEFINES                *
 ****************************************/
 #define SYSTEM_TICK_TIME_MS             (10u)   
+/* Adaptive tick: tick at SYSTEM_TICK_TIME_MS while a process needs the fine
+tick, see mProcess_RequestFineTick(), and at SYSTEM_TICK_COARSE_MS when idle.
+Process timers count milliseconds, so their periods hold at either rate, only
+their resolution drops to the coarse tick */
+#define ADAPTIVE_TICK_ENABLED       (1u)
+#define SYSTEM_TICK_COARSE_MS       (100u)
     
+/* Co-op loop dispatch order.  With round robin disabled the highest priority
+queued process always runs next.  With it enabled the search starts just below
+the process that ran last, so a process that stays queued cannot starve the
+lower priority processes until the next tick */
+#define SCHEDULER_ROUND_ROBIN       (0u)
+
 /* Enable or disable the firmware testmux outputs */
 #define PROCESS_DEBUG_ENABLED       (0u)
 #define ENABLE_SLEEP                (1u)
+/* Tickless idle: before sleeping, move the WDT match out to the earliest
+process deadline instead of waking every system tick.  Requires ENABLE_SLEEP */
+#define TICKLESS_IDLE_ENABLED       (1u)
 #define PROCESS_UART_ENABLE         (0u)
-/* do not move this #include.  PROCESS_DEBUG_ENABLED must be defined before this file is included */
+/* Measure the execution time of every process dispatch, see Profiler.h */
+#define PROFILER_ENABLED            (1u)
+/* Save the error log to flash in batches, see ErrorStore.h */
+#define ERROR_STORE_ENABLED         (1u)
+/* Record every mDebugSet/mDebugClear to a RAM trace that can be read over
+BLE, see Trace.h.  Unlike the test mux pins it sees every process at once.
+Off in production builds, it costs every debug edge of every process.  The
+host build sets it from its Makefile */
+#if !defined(TRACE_ENABLED)
+    #define TRACE_ENABLED           (0u)
+#endif
+/* Record every CapSense scan for the host replay tool, over the UART and the
+BLE capture characteristic, see Capture.h.  Off in production builds, turn it
+on to collect a capture.  The host build sets it from its Makefile */
+#if !defined(CAPTURE_ENABLED)
+    #define CAPTURE_ENABLED         (0u)
+#endif
+/* The process debug pointers are needed by the test mux pins and the trace */
+#if (PROCESS_DEBUG_ENABLED == 1u) || (TRACE_ENABLED == 1u)
+    #define DEBUG_POINTERS_ENABLED  (1u)
+#else
+    #define DEBUG_POINTERS_ENABLED  (0u)
+#endif
+/* do not move this #include.  PROCESS_DEBUG_ENABLED and DEBUG_POINTERS_ENABLED must be defined before this file is included */
 #include "TestMux.h"
     
 /* if you choose to alter the names of the queue varaibles in main.c
@@ -68,10 +127,11 @@ update these names to reflect the change */
 #define NEXTTICK_NAME               NextTick_Flags
 #define DISABLE_SLEEP_NAME          DisableSleep_Flags
 #define DISABLE_DEEPSLEEP_NAME      DisableDeepSleep_Flags    
+#define FINETICK_NAME               FineTick_Flags
     
 void System_TestMux_Init(void);
 
-#if (PROCESS_DEBUG_ENABLED == 1u)
+#if (DEBUG_POINTERS_ENABLED == 1u)
     extern uint8 * System_DebugOutput;
 #endif
 
@@ -88,6 +148,10 @@ void System_TestMux_Init(void);
 #define SYSTEM_ERROR_FAILED_TO_REGISTER_TESTMUX         (0x00)
 #define SYSTEM_ERROR_FAILED_TO_SWITCH_FIRMWAREMUX       (0x01)
 #define SYSTEM_ERROR_FAILED_TO_SWITCH_HARDWAREMUX       (0x02)
+#define SYSTEM_ERROR_TICK_OVERRUN                       (0x03)
+#define SYSTEM_ERROR_MISSED_TICK                        (0x04)
+#define SYSTEM_ERROR_MUTEX_WAITERS_FULL                 (0x05)
+#define SYSTEM_ERROR_FLASH_WRITE                        (0x06)
 
 #define ENABLED                     (0x01)
 #define DISABLED                    (0x00)
@@ -99,42 +163,94 @@ void System_TestMux_Init(void);
 #define ADC_TEMP_CHAN3              (0x03)              /* Offset */
 #define ADC_BATT_CHAN0              (0x04)
 
-#if(NUMBER_OF_PROCESSES > 32u)
-    #error The maximum number of processes allowed is 32
+/* The queue variables are bitmaps with one bit per process priority, made of
+as many QueueWords as the number of processes needs.  Only access them through
+the mQueue_ macros below and in Process.h */
+#if(NUMBER_OF_PROCESSES > 224u)
+    #error The maximum number of processes allowed is 224
 #elif(NUMBER_OF_PROCESSES > 16u)
-    typedef uint32                      QueueType;
-    #define NUMBER_OF_PROCESSES_MAX     (32u)
+    typedef uint32                      QueueWord;
+    #define QUEUE_WORD_BITS             (32u)
 #elif (NUMBER_OF_PROCESSES > 8u)
-    typedef uint16                      QueueType;
-    #define NUMBER_OF_PROCESSES_MAX     (16u)
+    typedef uint16                      QueueWord;
+    #define QUEUE_WORD_BITS             (16u)
 #else
-    typedef uint8                       QueueType;
-    #define NUMBER_OF_PROCESSES_MAX     (8u)
+    typedef uint8                       QueueWord;
+    #define QUEUE_WORD_BITS             (8u)
 #endif
 
-#if (NUMBER_OF_PROCESSES_MAX == 8)
-    #define SYSTEM_PROCESS_ID           (8u)
-    #define TESTMUX_PROCESS_ID          (9u)
-#elif (NUMBER_OF_PROCESSES_MAX == 16)
-    #define SYSTEM_PROCESS_ID           (16u)
-    #define TESTMUX_PROCESS_ID          (17u)
-#elif (NUMBER_OF_PROCESSES_MAX == 32)
-    #define SYSTEM_PROCESS_ID           (32u)
-    #define TESTMUX_PROCESS_ID          (33u)
+#define QUEUE_WORDS                 ((NUMBER_OF_PROCESSES + QUEUE_WORD_BITS - 1u) / QUEUE_WORD_BITS)
+#define NUMBER_OF_PROCESSES_MAX     (QUEUE_WORDS * QUEUE_WORD_BITS)
+typedef QueueWord                   QueueType[QUEUE_WORDS];
+
+/* The system and the test mux log errors with the IDs just above the last
+process ID.  Process IDs are uint8, hence the 224 process limit */
+#define SYSTEM_PROCESS_ID           (NUMBER_OF_PROCESSES_MAX)
+#define TESTMUX_PROCESS_ID          (NUMBER_OF_PROCESSES_MAX + 1u)
+
+/* Queue bitmap access by process priority */
+#define mQueue_Word(PRIORITY)       ((PRIORITY) / QUEUE_WORD_BITS)
+#define mQueue_Bit(PRIORITY)        ((QueueWord)((QueueWord)1u << ((PRIORITY) % QUEUE_WORD_BITS)))
+
+#define mQueue_Set(QUEUE, PRIORITY)\
+    do\
+    {\
+        (QUEUE)[mQueue_Word(PRIORITY)] |= mQueue_Bit(PRIORITY);\
+    } while(0)
+
+#define mQueue_Clear(QUEUE, PRIORITY)\
+    do\
+    {\
+        (QUEUE)[mQueue_Word(PRIORITY)] &= (QueueWord)~mQueue_Bit(PRIORITY);\
+    } while(0)
+
+#define mQueue_IsSet(QUEUE, PRIORITY)   (((QUEUE)[mQueue_Word(PRIORITY)] & mQueue_Bit(PRIORITY)) != 0u)
+
+/* A single word queue is tested and merged inline, longer ones loop over
+their words in Process.c */
+#if (QUEUE_WORDS == 1u)
+    #define mQueue_IsEmpty(QUEUE)       ((QUEUE)[0] == 0u)
+    
+    /* Move every bit of SOURCE into DESTINATION and clear SOURCE */
+    #define mQueue_MoveAll(DESTINATION, SOURCE)\
+        do\
+        {\
+            (DESTINATION)[0] |= (SOURCE)[0];\
+            (SOURCE)[0] = 0u;\
+        } while(0)
+#else
+    #define mQueue_IsEmpty(QUEUE)       (Queue_IsEmpty(QUEUE))
+    #define mQueue_MoveAll(DESTINATION, SOURCE)   Queue_MoveAll((DESTINATION), (SOURCE))
 #endif
 
-/* Wakeup Sources.  These defines are to be used as bit flags for the
- * wakeup source variable
-*/
-#define COOP_TICK                        (0x01)
-#define CSD_SCAN                         (0x02)
+/* Body of every busy-wait on the interrupt events, see Event.h.  Nothing to do on the target, the
+ * interrupt sets the flag on its own.  The host simulation build defines this
+ * in its project.h to advance virtual time to the next interrupt */
+#if !defined(mBusyWaitHook)
+    #define mBusyWaitHook()\
+        do\
+        {\
+        } while(0)
+#endif
 
 extern uint8 CoOpTick; 
 extern QueueType ActiveQueue_Flags;
 extern QueueType NextTick_Flags;
 extern QueueType DisableSleep_Flags;
 extern QueueType DisableDeepSleep_Flags;
-extern uint8 WakeupSource;
+extern QueueType FineTick_Flags;
 extern MUTEX ADC_Mutex;
 
+/* do not move these #includes.  The queue types must be defined before these files are
+included, and Timer.h before Process.h */
+#include "Timer.h"
+#include "Process.h"
+#include "OneShot.h"
+#include "Protothread.h"
+#include "Profiler.h"
+#include "Event.h"
+#include "ErrorStore.h"
+#include "Trace.h"
+#include "Capture.h"
+
 #endif
@@ -0,0 +1,96 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         HostSim.h
+********************************************************************************
+* Description:
+*  Control interface of the virtual hardware used by the host simulation
+*  build.  Virtual time only advances when the firmware waits for an
+*  interrupt (sleep, busy-wait) or when the benchmark driver charges CPU
+*  time for a process dispatch, so every run is fully deterministic.
+*
+********************************************************************************
+*/
+#ifndef HOSTSIM_H
+#define HOSTSIM_H
+
+#include <stdint.h>
+
+/* Entry point of the firmware.  main.c is compiled with -Dmain=Firmware_Main */
+void Firmware_Main(void);
+
+/***************************************
+*         Virtual time                 *
+****************************************/
+/* Virtual microseconds since reset */
+uint64_t HostSim_Now(void);
+/* Charge CPU time to the firmware.  Interrupts that become due are delivered
+   as soon as they are unmasked */
+void HostSim_Advance(uint32_t microseconds);
+/* Wait for interrupt: jump virtual time to the next hardware event */
+void HostSim_WaitForInterrupt(void);
+/* CY_PM_WFI: the same with only the CPU halted, charged as WFI idle */
+void HostSim_Wfi(void);
+/* 1u masks all interrupts (PRIMASK), 0u unmasks them */
+void HostSim_SetInterruptMask(uint8_t masked);
+
+/* Run the firmware from reset for the given amount of virtual time.
+   Returns 0u when the time ran out, 0xFFu if the firmware dead-locked */
+uint8_t HostSim_Run(uint64_t duration_us);
+
+/***************************************
+*         Stimulus                     *
+****************************************/
+typedef struct
+{
+    uint8_t SensorOnMask;           /* CapSense_sensorOnMask[0] */
+    uint16_t Centroid;              /* 0xFFFF when nothing is touching */
+    uint16_t Raw[5];                /* CapSense_sensorRaw[] */
+} HostSim_TouchSample;
+
+/* Called at the end of every CapSense scan to fill in the scan result */
+typedef void (* HostSim_TouchSource)(uint64_t now_us, HostSim_TouchSample * sample);
+void HostSim_SetTouchSource(HostSim_TouchSource source);
+
+/* Battery voltage applied to the divider */
+void HostSim_SetBatteryVoltage(uint16_t millivolts);
+
+/***************************************
+*         Observation                  *
+****************************************/
+/* Power mode residency and interrupt accounting of the virtual hardware */
+typedef struct
+{
+    uint64_t Active_us;
+    uint64_t Sleep_us;
+    uint64_t SleepEco_us;           /* CPU sleep with the IMO stopped */
+    uint64_t DeepSleep_us;
+    uint64_t BusyWait_us;           /* spinning on the event rings */
+    uint64_t WfiIdle_us;            /* CY_PM_WFI outside the sleep APIs */
+    uint32_t SleepEntries;
+    uint32_t SleepEcoEntries;
+    uint32_t DeepSleepEntries;
+    uint32_t WdtInterrupts;
+    uint32_t CapSenseInterrupts;
+    uint32_t BlessInterrupts;
+    uint32_t Interrupts;            /* all sources */
+    uint64_t LastInterrupt_us;      /* virtual time of the latest interrupt */
+    uint32_t DeepSleepViolations;   /* deep sleep entered with CSD/ADC busy */
+    uint32_t FlashRowWrites;
+    uint64_t FlashStall_us;         /* CPU stalled on flash writes, part of Active_us */
+} HostSim_Counters;
+
+extern HostSim_Counters HostSim_Stats;
+
+/***************************************
+*         Flash model                  *
+****************************************/
+/* RAM model of the flash rows written with CySysFlashWriteRow().  A row
+   write stalls the CPU with interrupts held off.  The driver may read and
+   corrupt the rows, e.g. to tear a write */
+#define HOSTSIM_FLASH_ROWS              (16u)
+#define HOSTSIM_FLASH_ROW_SIZE          (128u)
+extern uint8_t HostSim_Flash[HOSTSIM_FLASH_ROWS * HOSTSIM_FLASH_ROW_SIZE];
+extern uint32_t HostSim_FlashRowWrites[HOSTSIM_FLASH_ROWS];
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,711 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         HostSim_Bench.c
+********************************************************************************
+* Description:
+*  Benchmark driver for the host simulation build.  Runs the unmodified
+*  co-op loop for a number of virtual system ticks and reports, per process:
+*   - dispatch latency: virtual time from the interrupt that woke the loop to
+*     the first dispatch of the process after that interrupt
+*   - jitter: standard deviation and spread of that latency
+*  plus loop throughput (host time per virtual tick), power mode residency,
+*  the firmware's tick overrun statistics (Process.c) and its own execution
+*  time profile (Profiler.c).
+*
+*  The BLE process is fed errors like a flaky link produces, and at the end
+*  the error store (ErrorStore.c) is recovered from the flash model as it
+*  would be after a reset, once as written and once with the newest row torn.
+*
+*  Process entry points are intercepted with the linker's --wrap option, so
+*  the firmware sources are compiled exactly as they are for the target.  Each
+*  dispatch is charged a fixed amount of virtual CPU time from the cost table
+*  below, standing in for the execution time on the Cortex-M0.
+*
+*  Usage: hostsim_bench [ticks [trace.bin [capture.bin]]]
+*  The run length is counted in fine system ticks (SYSTEM_TICK_TIME_MS),
+*  whatever tick rate the firmware picks while it runs.  With a trace file
+*  the firmware trace (Trace.c) is read out packet by packet the way a BLE
+*  client reads it and saved for trace_decode.  With a capture file every
+*  touch capture record (Capture.c) is saved as the UART would stream it, for
+*  touch_replay.
+*
+********************************************************************************
+*/
+#include <project.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "main.h"
+
+#define BENCH_TICKS_DEFAULT             (1000000u)
+
+/* Error stimulus: BLE_ERROR_BAS_ERROR on every BLE dispatch, and one of
+BENCH_ERROR_CODES distinct errors every BENCH_ERROR_PERIOD dispatches */
+#define BENCH_ERROR_PERIOD              (50u)
+#define BENCH_ERROR_CODES               (64u)
+#define BENCH_ERROR_BASE                (0x80u)
+
+/* Touch stimulus: a swipe followed by a tap every BENCH_TOUCH_CYCLE_MS */
+#define BENCH_TOUCH_CYCLE_MS            (2000u)
+#define BENCH_SWIPE_START_MS            (0u)
+#define BENCH_SWIPE_LENGTH_MS           (150u)
+#define BENCH_TAP_START_MS              (1000u)
+#define BENCH_TAP_LENGTH_MS             (60u)
+/* Raw counts of the slider sensors, and what a finger adds */
+#define BENCH_RAW_BASELINE              (1000u)
+#define BENCH_RAW_TOUCH                 (300u)
+
+/***************************************
+*         Per process statistics       *
+****************************************/
+typedef struct
+{
+    const char * Name;
+    uint32 Cost_us;                 /* virtual CPU time charged per dispatch */
+    uint64_t Dispatches;
+    uint64_t Samples;
+    uint64_t LatencyMin_us;
+    uint64_t LatencyMax_us;
+    double LatencySum;
+    double LatencySumSq;
+    uint32 LastWakeup;              /* HostSim_Stats.Interrupts at the last sample */
+} BenchProcess;
+
+enum
+{
+    BENCH_BATT = 0u,
+    BENCH_BLE,
+    BENCH_LED,
+    BENCH_TOUCH,
+    BENCH_SLEEP,
+    BENCH_NUMBER_OF_PROCESSES
+};
+
+static BenchProcess Bench[BENCH_NUMBER_OF_PROCESSES] =
+{
+    { "Batt",   40u },
+    { "BLE",   120u },
+    { "LED",    15u },
+    { "Touch",  60u },
+    { "Sleep",   5u },
+};
+
+static void Bench_Dispatch(BenchProcess * process, void (* function)(void))
+{
+    uint64_t latency;
+
+    process->Dispatches++;
+
+    /* Only the first dispatch after each wakeup measures latency */
+    if(process->LastWakeup != HostSim_Stats.Interrupts)
+    {
+        process->LastWakeup = HostSim_Stats.Interrupts;
+        latency = HostSim_Now() - HostSim_Stats.LastInterrupt_us;
+
+        if((process->Samples == 0u) || (latency < process->LatencyMin_us))
+        {
+            process->LatencyMin_us = latency;
+        }
+        if(latency > process->LatencyMax_us)
+        {
+            process->LatencyMax_us = latency;
+        }
+        process->LatencySum += (double)latency;
+        process->LatencySumSq += (double)latency * (double)latency;
+        process->Samples++;
+    }
+
+    function();
+    HostSim_Advance(process->Cost_us);
+}
+
+/***************************************
+*         Wrapped process entries      *
+****************************************/
+void __real_Batt_Process(void);
+void __real_BLE_Process(void);
+void __real_LED_Process(void);
+void __real_Touch_Process(void);
+void __real_Sleep_Process(void);
+
+void __wrap_Batt_Process(void)
+{
+    Bench_Dispatch(&Bench[BENCH_BATT], &__real_Batt_Process);
+}
+
+void __wrap_BLE_Process(void)
+{
+    static uint32 dispatches = 0u;
+
+    Log_Error(BLE_PROCESS_ID, BLE_ERROR_BAS_ERROR);
+    if((dispatches % BENCH_ERROR_PERIOD) == 0u)
+    {
+        Log_Error(SYSTEM_PROCESS_ID, BENCH_ERROR_BASE + ((dispatches / BENCH_ERROR_PERIOD) % BENCH_ERROR_CODES));
+    }
+    dispatches++;
+
+    Bench_Dispatch(&Bench[BENCH_BLE], &__real_BLE_Process);
+}
+
+void __wrap_LED_Process(void)
+{
+    Bench_Dispatch(&Bench[BENCH_LED], &__real_LED_Process);
+}
+
+static FILE * Bench_CaptureFile = NULL;
+
+void __wrap_Touch_Process(void)
+{
+    #if (CAPTURE_ENABLED == 1u)
+    uint8 record[CAPTURE_RECORD_LEN];
+    #endif
+
+    Bench_Dispatch(&Bench[BENCH_TOUCH], &__real_Touch_Process);
+
+    #if (CAPTURE_ENABLED == 1u)
+    /* Stands in for the UART, in step with the scans */
+    while(Capture_Peek(record))
+    {
+        if(Bench_CaptureFile != NULL)
+        {
+            (void)fwrite(record, 1u, CAPTURE_RECORD_LEN, Bench_CaptureFile);
+        }
+        Capture_Drop();
+    }
+    #endif
+}
+
+void __wrap_Sleep_Process(void)
+{
+    Bench_Dispatch(&Bench[BENCH_SLEEP], &__real_Sleep_Process);
+}
+
+/***************************************
+*         Stimulus                     *
+****************************************/
+static void Bench_TouchSource(uint64_t now_us, HostSim_TouchSample * sample)
+{
+    uint32 phase_ms = (uint32)((now_us / 1000u) % BENCH_TOUCH_CYCLE_MS);
+    uint8 i;
+
+    if((phase_ms >= BENCH_SWIPE_START_MS) && (phase_ms < (BENCH_SWIPE_START_MS + BENCH_SWIPE_LENGTH_MS)))
+    {
+        /* Slide from 10 to 90 across the swipe */
+        sample->Centroid = (uint16)(10u + ((phase_ms - BENCH_SWIPE_START_MS) * 80u) / BENCH_SWIPE_LENGTH_MS);
+        sample->SensorOnMask = (sample->Centroid < 50u) ? 0x03u : 0x0Cu;
+    }
+    else if((phase_ms >= BENCH_TAP_START_MS) && (phase_ms < (BENCH_TAP_START_MS + BENCH_TAP_LENGTH_MS)))
+    {
+        sample->Centroid = 50u;
+        sample->SensorOnMask = 0x06u;
+    }
+
+    for(i = 0u; i < 4u; i++)
+    {
+        sample->Raw[i] = BENCH_RAW_BASELINE + (((sample->SensorOnMask >> i) & 1u) * BENCH_RAW_TOUCH);
+    }
+}
+
+/***************************************
+*         Report                       *
+****************************************/
+static double Bench_Percent(uint64_t part, uint64_t whole)
+{
+    return (whole != 0u) ? (100.0 * (double)part / (double)whole) : 0.0;
+}
+
+/* Process names by process ID, for the profiler table */
+static const char * const Bench_ProcessName[NUMBER_OF_PROCESSES] =
+{
+    [BATT_PROCESS_ID]   = "Batt",
+    [BLE_PROCESS_ID]    = "BLE",
+    [TOUCH_PROCESS_ID]  = "Touch",
+    [LED_PROCESS_ID]    = "LED",
+    [SLEEP_PROCESS_ID]  = "Sleep",
+};
+
+static void Bench_ReportProfileLine(const char * name, const char * state, const PROFILER_STATS * stats)
+{
+    double scale = 1.0 / (double)PROFILER_CYCLES_PER_US;
+
+    printf("%-8s %-6s %10u %10.1f %10.1f %10.1f\n", name, state, stats->Count,
+           (double)stats->Min * scale,
+           (stats->Count != 0u) ? ((double)stats->Sum * scale / (double)stats->Count) : 0.0,
+           (double)stats->Max * scale);
+}
+
+static void Bench_ReportProfile(void)
+{
+    uint8 id;
+    uint8 state;
+    char label[8];
+
+    printf("\nFirmware profile (SysTick, WDT clock for the sleep)\n%-8s %-6s %10s %10s %10s %10s\n",
+           "Process", "State", "Count", "Min(us)", "Mean(us)", "Max(us)");
+    for(id = 0u; id < NUMBER_OF_PROCESSES; id++)
+    {
+        const PROFILER_ENTRY * entry = &Profiler_Table[id];
+
+        if(entry->Process.Count == 0u)
+        {
+            continue;
+        }
+        Bench_ReportProfileLine(Bench_ProcessName[id], "all", &entry->Process);
+        for(state = 0u; state < PROFILER_STATES_MAX; state++)
+        {
+            if(entry->State[state].Count != 0u)
+            {
+                snprintf(label, sizeof(label), "%u", state);
+                Bench_ReportProfileLine("", label, &entry->State[state]);
+            }
+        }
+    }
+}
+
+static void Bench_ReportTickStats(void)
+{
+    uint8 priority;
+
+    printf("Tick overruns      : %u (longest %u ticks), missed ticks %u, left pending:",
+           Process_TickStats.Overruns, Process_TickStats.LongestOverrun, Process_TickStats.MissedTicks);
+    for(priority = 0u; priority < NUMBER_OF_PROCESSES; priority++)
+    {
+        if(mQueue_IsSet(Process_TickStats.PendingHistory, priority))
+        {
+            printf(" %s", Bench_ProcessName[Process_Table[priority].ID]);
+        }
+    }
+    printf("\n");
+}
+
+/* Error log and store statistics, then recover the store the way the next
+start up would.  Returns 1u if the recovery found the wrong row */
+static uint8 Bench_ReportErrorStore(void)
+{
+    uint8 result = 0u;
+    #if (ERROR_STORE_ENABLED == 1u)
+    uint8 i;
+    uint32 writesMin = UINT32_MAX;
+    uint32 writesMax = 0u;
+    uint32 sequence = ErrorStore_Status.Sequence;
+    uint16 boot = ErrorStore_Status.Boot;
+    uint32 tornRow;
+    uint8 saved;
+
+    printf("Error log          : %u records, %u overwritten, %u changed not saved\n",
+           ErrorCount, ErrorsOverwritten, ErrorsChanged);
+    for(i = 0u; i < ERROR_STORE_ROWS; i++)
+    {
+        if(HostSim_FlashRowWrites[ERROR_STORE_FIRST_ROW + i] < writesMin)
+        {
+            writesMin = HostSim_FlashRowWrites[ERROR_STORE_FIRST_ROW + i];
+        }
+        if(HostSim_FlashRowWrites[ERROR_STORE_FIRST_ROW + i] > writesMax)
+        {
+            writesMax = HostSim_FlashRowWrites[ERROR_STORE_FIRST_ROW + i];
+        }
+    }
+    printf("Error store        : %u rows written (%u to %u per row), %u write errors, CPU stalled %.2f s\n",
+           ErrorStore_Status.Writes, writesMin, writesMax, ErrorStore_Status.WriteErrors,
+           (double)HostSim_Stats.FlashStall_us / 1e6);
+
+    /* A reset: the newest row and, once a row was saved, the next boot are
+    found again */
+    ErrorStore_Init();
+    printf("Store recovery     : sequence %u of %u in %u row reads",
+           ErrorStore_Status.Sequence, sequence, ErrorStore_Status.RecoveryReads);
+    if((ErrorStore_Status.Sequence != sequence) ||
+       ((sequence != 0u) && (ErrorStore_Status.Boot != (uint16)(boot + 1u))))
+    {
+        result = 1u;
+    }
+
+    /* A reset during the write of the newest row: the one before is newest */
+    if(sequence != 0u)
+    {
+        tornRow = ERROR_STORE_FIRST_ROW + ((sequence - 1u) & ERROR_STORE_ROW_MASK);
+        saved = HostSim_Flash[(tornRow * HOSTSIM_FLASH_ROW_SIZE) + ERROR_STORE_HEADER_SIZE];
+        HostSim_Flash[(tornRow * HOSTSIM_FLASH_ROW_SIZE) + ERROR_STORE_HEADER_SIZE] = (uint8)~saved;
+        ErrorStore_Init();
+        printf(", torn newest row: sequence %u in %u row reads",
+               ErrorStore_Status.Sequence, ErrorStore_Status.RecoveryReads);
+        if(ErrorStore_Status.Sequence != (sequence - 1u))
+        {
+            result = 1u;
+        }
+        HostSim_Flash[(tornRow * HOSTSIM_FLASH_ROW_SIZE) + ERROR_STORE_HEADER_SIZE] = saved;
+    }
+    printf(" -> %s\n", (result == 0u) ? "OK" : "FAILED");
+    #endif
+
+    return result;
+}
+
+/* Sleep mode names, for the sleep policy check */
+static const char * const Bench_SleepModeName[NUMBER_OF_SLEEP_MODES] =
+{
+    [SLEEP_MODE_NONE]       = "none",
+    [SLEEP_MODE_SLEEP]      = "sleep",
+    [SLEEP_MODE_SLEEP_ECO]  = "ECO",
+    [SLEEP_MODE_DEEP_SLEEP] = "deep sleep",
+};
+
+/* Charge of a mode over a gap in pC, in doubles so it shares nothing with
+the integer arithmetic of Sleep_SelectMode() */
+static double Bench_SleepCharge(uint8 mode, uint32 gap_us)
+{
+    const SLEEP_MODE_COST * cost = &Sleep_ModeCost[mode];
+
+    return (double)cost->Transition_pC + ((double)cost->Current_uA * ((double)gap_us - (double)cost->Latency_us));
+}
+
+/* The mode with the least charge over the gap, the deeper one on a tie */
+static uint8 Bench_SleepExpected(uint32 gap_us, uint8 allowed)
+{
+    uint8 mode;
+    uint8 best = SLEEP_MODE_NONE;
+
+    for(mode = SLEEP_MODE_NONE + 1u; mode < NUMBER_OF_SLEEP_MODES; mode++)
+    {
+        if(((allowed & mSleep_ModeBit(mode)) != 0u) && (Sleep_ModeCost[mode].Latency_us <= gap_us) &&
+           (Bench_SleepCharge(mode, gap_us) <= Bench_SleepCharge(best, gap_us)))
+        {
+            best = mode;
+        }
+    }
+
+    return best;
+}
+
+/* Shortest gap at which the deeper mode costs no more than the shallower
+one, from the SLEEP_COST_ values */
+static uint32 Bench_SleepBreakEven(uint8 shallow, uint8 deep)
+{
+    const SLEEP_MODE_COST * s = &Sleep_ModeCost[shallow];
+    const SLEEP_MODE_COST * d = &Sleep_ModeCost[deep];
+    int64_t numerator = (int64_t)d->Transition_pC - (int64_t)s->Transition_pC -
+                        ((int64_t)d->Current_uA * d->Latency_us) + ((int64_t)s->Current_uA * s->Latency_us);
+    int64_t denominator = (int64_t)s->Current_uA - (int64_t)d->Current_uA;
+    int64_t gap = (d->Latency_us > s->Latency_us) ? d->Latency_us : s->Latency_us;
+
+    if(denominator <= 0)
+    {
+        /* No saving per us, the deeper mode pays off at once or never */
+        return ((denominator == 0) && (numerator <= 0)) ? (uint32)gap : UINT32_MAX;
+    }
+    if(numerator > (gap * denominator))
+    {
+        gap = (numerator + denominator - 1) / denominator;
+    }
+
+    return (uint32)gap;
+}
+
+/* Unit check of the sleep policy: Sleep_SelectMode() against the break-even
+gaps and a sweep of gaps up to SLEEP_GAP_MAX_US, and Sleep_EstimateGap() with
+BLESS awake, a CapSense scan and an ADC conversion in every combination.
+Returns 1u on a wrong result */
+static uint8 Bench_CheckSleepPolicy(void)
+{
+    /* The modes BLESS asleep, BLESS awake, no deep sleep, every mode allow */
+    static const uint8 allowedModes[] =
+    {
+        mSleep_ModeBit(SLEEP_MODE_NONE) | mSleep_ModeBit(SLEEP_MODE_SLEEP) | mSleep_ModeBit(SLEEP_MODE_DEEP_SLEEP),
+        mSleep_ModeBit(SLEEP_MODE_NONE) | mSleep_ModeBit(SLEEP_MODE_SLEEP) | mSleep_ModeBit(SLEEP_MODE_SLEEP_ECO),
+        mSleep_ModeBit(SLEEP_MODE_NONE) | mSleep_ModeBit(SLEEP_MODE_SLEEP),
+        0x0Fu,
+    };
+    /* WDT counts to the next match: past SLEEP_GAP_MAX_US, and shorter than
+    every hardware limit */
+    static const uint32 wdtCounts[] = { 40000u, 3u };
+    uint8 result = 0u;
+    uint8 shallow;
+    uint8 deep;
+    uint8 mode;
+    uint8 i;
+    uint8 j;
+    uint8 combination;
+    uint32 gap;
+    uint32 expected;
+    uint32 checks = 0u;
+    uint32 wrong = 0u;
+    MUTEX adc = ADC_Mutex;
+    CYBLE_BLESS_STATE_T ble;
+
+    printf("Sleep policy       : break even");
+    for(shallow = SLEEP_MODE_NONE; shallow < NUMBER_OF_SLEEP_MODES; shallow++)
+    {
+        for(deep = shallow + 1u; deep < NUMBER_OF_SLEEP_MODES; deep++)
+        {
+            gap = Bench_SleepBreakEven(shallow, deep);
+            if(gap > SLEEP_GAP_MAX_US)
+            {
+                continue;
+            }
+            printf(" %s over %s %u us,", Bench_SleepModeName[deep], Bench_SleepModeName[shallow], gap);
+
+            /* Only the two modes allowed: the deeper one from the break even
+            gap on, not a microsecond before */
+            mode = mSleep_ModeBit(shallow) | mSleep_ModeBit(deep);
+            if((Sleep_SelectMode(gap, mode) != Bench_SleepExpected(gap, mode)) ||
+               ((Bench_SleepExpected(gap, mode) == deep) && (gap != 0u) && (Sleep_SelectMode(gap - 1u, mode) == deep)))
+            {
+                printf(" WRONG %s over %s at %u us,", Bench_SleepModeName[deep], Bench_SleepModeName[shallow], gap);
+                wrong++;
+            }
+            checks += 2u;
+        }
+    }
+
+    for(i = 0u; i < (sizeof(allowedModes) / sizeof(allowedModes[0])); i++)
+    {
+        for(gap = 0u; gap <= SLEEP_GAP_MAX_US; gap += (gap < 2000u) ? 1u : 997u)
+        {
+            mode = Sleep_SelectMode(gap, allowedModes[i]);
+            if((mode != Bench_SleepExpected(gap, allowedModes[i])) || ((allowedModes[i] & mSleep_ModeBit(mode)) == 0u))
+            {
+                if(wrong < 4u)
+                {
+                    printf(" WRONG %s at %u us,", Bench_SleepModeName[mode], gap);
+                }
+                wrong++;
+            }
+            checks++;
+        }
+        mode = Sleep_SelectMode(SLEEP_GAP_MAX_US, allowedModes[i]);
+        if(mode != Bench_SleepExpected(SLEEP_GAP_MAX_US, allowedModes[i]))
+        {
+            wrong++;
+        }
+        checks++;
+    }
+
+    /* Let a scan the run left going finish, then restart the WDT counters so
+    the next wakeup is exactly where the check puts it */
+    if(CapSense_IsBusy())
+    {
+        HostSim_Advance(1000u);
+    }
+    for(i = 0u; i < (sizeof(wdtCounts) / sizeof(wdtCounts[0])); i++)
+    {
+        CySysWdtDisable(CY_SYS_WDT_COUNTER0_MASK | CY_SYS_WDT_COUNTER1_MASK);
+        CySysWdtEnable(CY_SYS_WDT_COUNTER0_MASK);
+        CySysWdtWriteMatch(0u, wdtCounts[i]);
+        CySysWdtWriteMatch(1u, 0xFFFFu);
+
+        /* Bit 0 BLESS awake, bit 1 ADC converting, bit 2 CapSense scanning.
+        The scan cannot be stopped, so it comes last */
+        for(combination = 0u; combination < 8u; combination++)
+        {
+            if(combination == 4u)
+            {
+                CapSense_ScanEnabledWidgets();
+            }
+            ble = ((combination & 1u) != 0u) ? CYBLE_BLESS_STATE_ACTIVE : CYBLE_BLESS_STATE_DEEPSLEEP;
+            ADC_Mutex.Owner = ((combination & 2u) != 0u) ? BATT_PROCESS : MUTEX_NO_OWNER;
+
+            expected = mWatchdogTimer_CountsToUs(wdtCounts[i]);
+            for(j = 0u; j < 4u; j++)
+            {
+                static const uint32 limit[] = { SLEEP_GAP_MAX_US, SLEEP_BLE_WAKEUP_US, SLEEP_ADC_CONVERSION_US, SLEEP_CSD_SCAN_US };
+
+                if(((j == 0u) || ((combination & (1u << (j - 1u))) != 0u)) && (limit[j] < expected))
+                {
+                    expected = limit[j];
+                }
+            }
+
+            gap = Sleep_EstimateGap(ble);
+            if(gap != expected)
+            {
+                printf(" WRONG gap %u us for %u us (BLESS %s%s%s),", gap, expected,
+                       ((combination & 1u) != 0u) ? "awake" : "asleep",
+                       ((combination & 2u) != 0u) ? ", ADC" : "", ((combination & 4u) != 0u) ? ", CapSense" : "");
+                wrong++;
+            }
+            checks++;
+        }
+    }
+    ADC_Mutex = adc;
+
+    if(wrong != 0u)
+    {
+        result = 1u;
+    }
+    printf(" %u checks -> %s\n", checks, (result == 0u) ? "OK" : "FAILED");
+
+    return result;
+}
+
+/* Trace fill and the time span it covers */
+static void Bench_ReportTrace(void)
+{
+    #if (TRACE_ENABLED == 1u)
+    TRACE_RECORD record;
+    uint16 i;
+    uint16 syncs = 0u;
+
+    for(i = 0u; Trace_Read(i, &record); i++)
+    {
+        if(record.ID == TRACE_ID_SYNC)
+        {
+            syncs++;
+        }
+    }
+    printf("Trace              : %u records (%u syncs), %u overwritten\n",
+           Trace_Count(), syncs, TraceOverwritten);
+    #endif
+}
+
+/* Save the trace as the GATT packets a client would read */
+static uint8 Bench_DumpTrace(const char * path)
+{
+    uint8 result = 0u;
+    #if (TRACE_ENABLED == 1u)
+    FILE * file;
+    uint16 index;
+    uint8 packet[TRACE_PACKET_LEN];
+
+    if((file = fopen(path, "wb")) == NULL)
+    {
+        perror(path);
+        return 1u;
+    }
+    for(index = 0u; index < Trace_Count(); index += TRACE_PACKET_RECORDS)
+    {
+        (void)Trace_GetPacket(index, packet);
+        if(fwrite(packet, 1u, TRACE_PACKET_LEN, file) != TRACE_PACKET_LEN)
+        {
+            result = 1u;
+        }
+    }
+    fclose(file);
+    #endif
+
+    return result;
+}
+
+/* The firmware's own power statistics (Sleep.c), to check against the
+simulator's residency */
+static void Bench_ReportPowerStats(void)
+{
+    double uptime = (double)Sleep_GetStat(SLEEP_STAT_UPTIME);
+
+    printf("Firmware residency : uptime %u ms, active %.2f%%, idle %.2f%%, sleep %.2f%%, sleep(ECO) %.2f%%, deep sleep %.2f%%\n",
+           Sleep_GetStat(SLEEP_STAT_UPTIME),
+           100.0 * Sleep_GetStat(SLEEP_STAT_ACTIVE) / uptime,
+           100.0 * Sleep_GetStat(SLEEP_STAT_RESIDENCY + SLEEP_MODE_NONE) / uptime,
+           100.0 * Sleep_GetStat(SLEEP_STAT_RESIDENCY + SLEEP_MODE_SLEEP) / uptime,
+           100.0 * Sleep_GetStat(SLEEP_STAT_RESIDENCY + SLEEP_MODE_SLEEP_ECO) / uptime,
+           100.0 * Sleep_GetStat(SLEEP_STAT_RESIDENCY + SLEEP_MODE_DEEP_SLEEP) / uptime);
+    printf("Firmware wakeups   : tick %u, CapSense %u, BLE %u, other %u\n",
+           Sleep_GetStat(SLEEP_STAT_WAKEUPS + EVENT_SOURCE_COOP_TICK),
+           Sleep_GetStat(SLEEP_STAT_WAKEUPS + EVENT_SOURCE_CSD_SCAN),
+           Sleep_GetStat(SLEEP_STAT_WAKEUPS + EVENT_SOURCE_BLE),
+           Sleep_GetStat(SLEEP_STAT_WAKEUPS_OTHER));
+}
+
+static uint8 Bench_Report(uint32 ticks, double host_s)
+{
+    uint8 i;
+    uint8 failed;
+    double mean;
+    double variance;
+    uint64_t dispatches = 0u;
+    uint64_t total_us = HostSim_Now();
+    const HostSim_Counters * c = &HostSim_Stats;
+
+    printf("Virtual time       : %u ticks (%.1f s)\n", ticks, (double)total_us / 1e6);
+    printf("\n%-8s %12s %10s %10s %10s %10s %10s\n",
+           "Process", "Dispatches", "Min(us)", "Mean(us)", "Max(us)", "StdDev(us)", "Spread(us)");
+    for(i = 0u; i < BENCH_NUMBER_OF_PROCESSES; i++)
+    {
+        const BenchProcess * p = &Bench[i];
+
+        mean = (p->Samples != 0u) ? (p->LatencySum / (double)p->Samples) : 0.0;
+        variance = (p->Samples != 0u) ? ((p->LatencySumSq / (double)p->Samples) - (mean * mean)) : 0.0;
+        printf("%-8s %12llu %10llu %10.1f %10llu %10.1f %10llu\n",
+               p->Name, (unsigned long long)p->Dispatches,
+               (unsigned long long)p->LatencyMin_us, mean, (unsigned long long)p->LatencyMax_us,
+               sqrt((variance > 0.0) ? variance : 0.0),
+               (unsigned long long)(p->LatencyMax_us - p->LatencyMin_us));
+        dispatches += p->Dispatches;
+    }
+
+    printf("\nLoop throughput    : %.0f ticks/s, %.0f dispatches/s (host %.3f s)\n",
+           (double)ticks / host_s, (double)dispatches / host_s, host_s);
+    printf("Interrupts         : %u (WDT %u, CapSense %u, BLESS %u), %.1f wakeups/s\n",
+           c->Interrupts, c->WdtInterrupts, c->CapSenseInterrupts, c->BlessInterrupts,
+           (double)c->Interrupts * 1e6 / (double)total_us);
+    printf("Residency          : active %.2f%%, busy-wait %.2f%%, WFI idle %.2f%%, sleep %.2f%%, sleep(ECO) %.2f%%, deep sleep %.2f%%\n",
+           Bench_Percent(c->Active_us, total_us), Bench_Percent(c->BusyWait_us, total_us),
+           Bench_Percent(c->WfiIdle_us, total_us),
+           Bench_Percent(c->Sleep_us, total_us), Bench_Percent(c->SleepEco_us, total_us),
+           Bench_Percent(c->DeepSleep_us, total_us));
+    Bench_ReportPowerStats();
+    printf("Mode entries       : sleep %u, sleep(ECO) %u, deep sleep %u, deep sleep violations %u\n",
+           c->SleepEntries, c->SleepEcoEntries, c->DeepSleepEntries, c->DeepSleepViolations);
+
+    printf("ADC mutex          : %u locks, %u contentions, hold max %u ms, total %u ms\n",
+           ADC_Mutex.Locks, ADC_Mutex.Contentions, ADC_Mutex.HoldMax, ADC_Mutex.HoldTotal);
+    Bench_ReportTickStats();
+    failed = Bench_ReportErrorStore();
+    Bench_ReportTrace();
+    Bench_ReportProfile();
+    /* Last, it leaves the WDT and CapSense as the check set them */
+    failed |= Bench_CheckSleepPolicy();
+
+    return failed;
+}
+
+int main(int argc, char * argv[])
+{
+    uint32 ticks = BENCH_TICKS_DEFAULT;
+    struct timespec start;
+    struct timespec stop;
+    double host_s;
+    uint8 result;
+
+    if(argc > 1)
+    {
+        ticks = (uint32)strtoul(argv[1], NULL, 0);
+    }
+
+    if((argc > 3) && ((Bench_CaptureFile = fopen(argv[3], "wb")) == NULL))
+    {
+        perror(argv[3]);
+        return EXIT_FAILURE;
+    }
+
+    HostSim_SetTouchSource(&Bench_TouchSource);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    result = HostSim_Run((uint64_t)ticks * SYSTEM_TICK_TIME_MS * 1000u);
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+
+    #if (TRACE_ENABLED == 1u)
+    /* Hold the trace as it was at the end of the run */
+    Trace_Stop();
+    #endif
+
+    host_s = (double)(stop.tv_sec - start.tv_sec) + ((double)(stop.tv_nsec - start.tv_nsec) / 1e9);
+    if(Bench_Report(ticks, host_s) != 0u)
+    {
+        result = 0xFFu;
+    }
+
+    if((argc > 2) && (Bench_DumpTrace(argv[2]) != 0u))
+    {
+        result = 0xFFu;
+    }
+
+    if((Bench_CaptureFile != NULL) && (fclose(Bench_CaptureFile) != 0))
+    {
+        result = 0xFFu;
+    }
+
+    return (result == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,870 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         HostSim_Hal.c
+********************************************************************************
+* Description:
+*  Virtual hardware for the host simulation build.  Models the parts of the
+*  PSoC 4 BLE that the co-op loop depends on:
+*   - WDT counters 0 and 1 with clear on match, running at 32 counts per ms
+*   - NVIC masking (PRIMASK) with latched, pending interrupts
+*   - CPU power modes, with residency accounting
+*   - CapSense scans and SAR ADC conversions that take time to complete
+*   - A BLE stack that only reports CYBLE_EVT_STACK_ON
+*   - Flash rows in RAM, with the CPU stall of a row write
+*
+********************************************************************************
+*/
+#include <project.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include "main.h"
+
+/***************************************
+*         Model parameters             *
+****************************************/
+#define HOSTSIM_WDT_COUNTS_PER_MS       (32u)   /* WCO / LFCLK as used by WatchdogTimer.c */
+#define HOSTSIM_WDT_COUNTER_RANGE       (65536u)
+#define HOSTSIM_WDT_INTERRUPT_NUM       (8u)
+#define HOSTSIM_BLESS_INTERRUPT_NUM     (BLE_1_bless_isr__INTC_NUMBER)
+#define HOSTSIM_CAPSENSE_INTERRUPT_NUM  (16u)
+#define HOSTSIM_NUMBER_OF_VECTORS       (32u)
+#define HOSTSIM_CAPSENSE_SENSOR_SCAN_US (100u)  /* per enabled sensor */
+#define HOSTSIM_ADC_CONVERSION_US       (50u)
+#define HOSTSIM_BLESS_INTERVAL_US       (1000000u)  /* slow advertising, one BLESS interrupt per event */
+#define HOSTSIM_BATTERY_MV_DEFAULT      (3000u)
+#define HOSTSIM_FLASH_WRITE_US          (20000u)    /* erase and program of one row */
+#define HOSTSIM_NEVER                   (UINT64_MAX)
+
+/***************************************
+*         Virtual hardware state       *
+****************************************/
+HostSim_Counters HostSim_Stats;
+
+static uint64_t Now_us = 0u;
+static uint64_t RunEnd_us = HOSTSIM_NEVER;
+static jmp_buf RunExit;
+
+/* NVIC */
+static uint8 IntMasked = 1u;
+static uint32 IntEnabled = 0u;
+static uint32 IntPending = 0u;
+static cyisraddress Vectors[HOSTSIM_NUMBER_OF_VECTORS];
+
+/* Clocks */
+static uint8 ImoRunning = 1u;
+
+/* SysTick, see CySysTickGetValue() */
+static struct
+{
+    uint8 Enabled;
+    uint32 Reload;
+    uint64_t Base_us;               /* clocked time at the last clear */
+} SysTick;
+
+/* WDT counters 0 and 1, they share the WDT interrupt */
+typedef struct
+{
+    uint8 Enabled;
+    uint8 ClearOnMatch;
+    uint32 Match;
+    uint64_t Base_us;               /* virtual time at which the count was 0 */
+    uint64_t Due_us;                /* virtual time of the next match */
+} HostSim_WdtCounter;
+
+static HostSim_WdtCounter Wdt[2];
+static const uint32 WdtEnableMask[2] = {CY_SYS_WDT_COUNTER0_MASK, CY_SYS_WDT_COUNTER1_MASK};
+static const uint32 WdtIntMask[2] = {CY_SYS_WDT_COUNTER0_INT, CY_SYS_WDT_COUNTER1_INT};
+static uint32 WdtIntStatus;         /* CY_SYS_WDT_COUNTERn_INT until cleared */
+
+/* CapSense */
+static uint8 CapSenseBusy = 0u;
+static uint64_t CapSenseDue_us = HOSTSIM_NEVER;
+static uint16 CapSenseCentroid = 0xFFFFu;
+/* Enabled sensors, the slider is sensors 0 to 3 and the ganged sensor 4 */
+static uint8 CapSenseEnabled = 0x1Fu;
+static HostSim_TouchSource TouchSource = NULL;
+uint8 CapSense_sensorOnMask[(CapSense_TOTAL_SENSOR_COUNT + 7u) / 8u];
+uint16 CapSense_sensorRaw[CapSense_TOTAL_SENSOR_COUNT];
+
+/* ADC */
+uint32 HostSim_ADC_SAR_CTRL = ADC_DEFAULT_CTRL_REG_CFG;
+static uint8 AdcRunning = 0u;
+static uint64_t AdcDue_us = HOSTSIM_NEVER;
+static uint16 BatteryVoltage_mV = HOSTSIM_BATTERY_MV_DEFAULT;
+
+/* BLE */
+CYBLE_CONN_HANDLE_T cyBle_connHandle;
+static CYBLE_CALLBACK_T StackCallback = NULL;
+static uint8 StackOnSent = 0u;
+static uint64_t BlessDue_us = HOSTSIM_NEVER;
+
+/* Flash */
+uint8_t HostSim_Flash[HOSTSIM_FLASH_ROWS * HOSTSIM_FLASH_ROW_SIZE];
+uint32_t HostSim_FlashRowWrites[HOSTSIM_FLASH_ROWS];
+
+/* Pins and control registers */
+uint8 FirmwareDebugOutput0_Control;
+uint8 FirmwareDebugOutput1_Control;
+uint8 HardwareDebugMuxSelect_Control;
+static uint8 PinState[4];
+
+/***************************************
+*         Local helpers                *
+****************************************/
+static uint64_t WdtCountsToUs(uint64_t counts)
+{
+    return ((counts * 1000u) + (HOSTSIM_WDT_COUNTS_PER_MS - 1u)) / HOSTSIM_WDT_COUNTS_PER_MS;
+}
+
+static uint64_t WdtUsToCounts(uint64_t microseconds)
+{
+    return (microseconds * HOSTSIM_WDT_COUNTS_PER_MS) / 1000u;
+}
+
+/* Next match of a WDT counter relative to its current count.  A match below
+   the current count is only reached after the 16 bit counter wraps.  With
+   clear on match the counter clears the count after the match count, without
+   it the interrupt comes as the count reaches the match */
+static void WdtScheduleMatch(HostSim_WdtCounter * counter)
+{
+    uint64_t elapsed = WdtUsToCounts(Now_us - counter->Base_us);
+    uint64_t target = (uint64_t)counter->Match + (counter->ClearOnMatch ? 1u : 0u);
+
+    while(target <= elapsed)
+    {
+        target += HOSTSIM_WDT_COUNTER_RANGE;
+    }
+    counter->Due_us = counter->Base_us + WdtCountsToUs(target);
+}
+
+/* Latch every hardware event that is due by now into the pending register.
+   Like the NVIC, several matches of the same source collapse into one */
+static void LatchEvents(void)
+{
+    HostSim_TouchSample sample;
+    uint8 i;
+
+    for(i = 0u; i < 2u; i++)
+    {
+        while(Wdt[i].Enabled && (Wdt[i].Due_us <= Now_us))
+        {
+            IntPending |= (1u << HOSTSIM_WDT_INTERRUPT_NUM);
+            WdtIntStatus |= WdtIntMask[i];
+            if(Wdt[i].ClearOnMatch)
+            {
+                Wdt[i].Base_us = Wdt[i].Due_us;
+                WdtScheduleMatch(&Wdt[i]);
+            }
+            else
+            {
+                /* Free running, the next match is a whole wrap away */
+                Wdt[i].Due_us = Wdt[i].Base_us +
+                    WdtCountsToUs(WdtUsToCounts(Wdt[i].Due_us - Wdt[i].Base_us) + HOSTSIM_WDT_COUNTER_RANGE);
+            }
+        }
+    }
+
+    if(CapSenseBusy && (CapSenseDue_us <= Now_us))
+    {
+        CapSenseBusy = 0u;
+        CapSenseDue_us = HOSTSIM_NEVER;
+
+        memset(&sample, 0, sizeof(sample));
+        sample.Centroid = 0xFFFFu;
+        if(TouchSource != NULL)
+        {
+            TouchSource(Now_us, &sample);
+        }
+        /* The ganged sensor is all the slider electrodes together */
+        if((sample.SensorOnMask & 0x0Fu) != 0u)
+        {
+            sample.SensorOnMask |= 0x10u;
+        }
+        CapSense_sensorOnMask[0] = sample.SensorOnMask & CapSenseEnabled;
+        for(i = 0u; i < CapSense_TOTAL_SENSOR_COUNT; i++)
+        {
+            CapSense_sensorRaw[i] = ((CapSenseEnabled & (1u << i)) != 0u) ? sample.Raw[i] : 0u;
+        }
+        CapSenseCentroid = ((CapSenseEnabled & 0x0Fu) != 0u) ? sample.Centroid : 0xFFFFu;
+
+        IntPending |= (1u << HOSTSIM_CAPSENSE_INTERRUPT_NUM);
+    }
+
+    while(BlessDue_us <= Now_us)
+    {
+        IntPending |= (1u << HOSTSIM_BLESS_INTERRUPT_NUM);
+        BlessDue_us += HOSTSIM_BLESS_INTERVAL_US;
+    }
+}
+
+/* Deliver pending, enabled interrupts while PRIMASK is clear */
+static void Service(void)
+{
+    uint32 ready;
+    uint8 vector;
+
+    LatchEvents();
+
+    while(IntMasked == 0u)
+    {
+        ready = IntPending & IntEnabled;
+        if(ready == 0u)
+        {
+            break;
+        }
+
+        /* Lowest vector number first */
+        for(vector = 0u; (ready & (1u << vector)) == 0u; vector++)
+        {
+        }
+        IntPending &= ~(1u << vector);
+
+        HostSim_Stats.Interrupts++;
+        HostSim_Stats.LastInterrupt_us = Now_us;
+        if(vector == HOSTSIM_WDT_INTERRUPT_NUM)
+        {
+            HostSim_Stats.WdtInterrupts++;
+        }
+        else if(vector == HOSTSIM_CAPSENSE_INTERRUPT_NUM)
+        {
+            HostSim_Stats.CapSenseInterrupts++;
+        }
+        else if(vector == HOSTSIM_BLESS_INTERRUPT_NUM)
+        {
+            HostSim_Stats.BlessInterrupts++;
+        }
+
+        if(Vectors[vector] != NULL)
+        {
+            Vectors[vector]();
+        }
+    }
+
+    if((IntMasked == 0u) && (Now_us >= RunEnd_us))
+    {
+        longjmp(RunExit, 1);
+    }
+}
+
+/* Time of the next event that can wake the CPU */
+static uint64_t NextWakeupEvent(void)
+{
+    uint64_t next = HOSTSIM_NEVER;
+
+    uint8 i;
+
+    for(i = 0u; i < 2u; i++)
+    {
+        if(Wdt[i].Enabled && (IntEnabled & (1u << HOSTSIM_WDT_INTERRUPT_NUM)) && (Wdt[i].Due_us < next))
+        {
+            next = Wdt[i].Due_us;
+        }
+    }
+    if(CapSenseBusy && (CapSenseDue_us < next))
+    {
+        next = CapSenseDue_us;
+    }
+    if((IntEnabled & (1u << HOSTSIM_BLESS_INTERRUPT_NUM)) && (BlessDue_us < next))
+    {
+        next = BlessDue_us;
+    }
+
+    return next;
+}
+
+/* Common body of WFI.  Moves virtual time to the next interrupt and charges
+   the waited time to the given residency counter */
+static void WaitForInterrupt(uint64_t * residency)
+{
+    uint64_t next;
+
+    LatchEvents();
+    if((IntPending & IntEnabled) == 0u)
+    {
+        next = NextWakeupEvent();
+        if(next == HOSTSIM_NEVER)
+        {
+            fprintf(stderr, "HostSim: WFI with no interrupt source at %llu us\n",
+                    (unsigned long long)Now_us);
+            longjmp(RunExit, 2);
+        }
+        *residency += next - Now_us;
+        Now_us = next;
+    }
+
+    Service();
+}
+
+/* CapSense end of scan interrupt.  Mirrors the CapSense_ISR_EXIT user section
+   of Generated_Source/PSoC4/CapSense_INT.c */
+static void CapSense_Isr(void)
+{
+    Event_Post(EVENT_SOURCE_CSD_SCAN, 0u);
+}
+
+/* BLESS interrupt handler of the BLE stack.  The link layer is not modelled,
+   the firmware only sees the interrupt */
+static void Bless_Isr(void)
+{
+}
+
+/***************************************
+*         Simulation control           *
+****************************************/
+uint64_t HostSim_Now(void)
+{
+    return Now_us;
+}
+
+void HostSim_Advance(uint32_t microseconds)
+{
+    Now_us += microseconds;
+    HostSim_Stats.Active_us += microseconds;
+    Service();
+}
+
+void HostSim_WaitForInterrupt(void)
+{
+    WaitForInterrupt(&HostSim_Stats.BusyWait_us);
+}
+
+void HostSim_Wfi(void)
+{
+    WaitForInterrupt(&HostSim_Stats.WfiIdle_us);
+}
+
+void HostSim_SetInterruptMask(uint8_t masked)
+{
+    IntMasked = masked;
+    Service();
+}
+
+uint8_t HostSim_Run(uint64_t duration_us)
+{
+    int reason;
+
+    RunEnd_us = Now_us + duration_us;
+    reason = setjmp(RunExit);
+    if(reason == 0)
+    {
+        Firmware_Main();
+    }
+
+    /* The driver may call into the firmware after the run, e.g. to read its
+       statistics.  That must not jump back here */
+    RunEnd_us = HOSTSIM_NEVER;
+
+    return (reason == 1) ? 0u : 0xFFu;
+}
+
+void HostSim_SetTouchSource(HostSim_TouchSource source)
+{
+    TouchSource = source;
+}
+
+void HostSim_SetBatteryVoltage(uint16_t millivolts)
+{
+    BatteryVoltage_mV = millivolts;
+}
+
+/***************************************
+*         CyLib / interrupts           *
+****************************************/
+uint8 CyEnterCriticalSection(void)
+{
+    uint8 saved = IntMasked;
+
+    IntMasked = 1u;
+    return saved;
+}
+
+void CyExitCriticalSection(uint8 savedIntrStatus)
+{
+    IntMasked = savedIntrStatus;
+    Service();
+}
+
+cyisraddress CyIntSetVector(uint8 number, cyisraddress address)
+{
+    cyisraddress previous = Vectors[number];
+
+    Vectors[number] = address;
+    return previous;
+}
+
+void CyIntEnable(uint8 number)
+{
+    IntEnabled |= (1u << number);
+}
+
+void CyIntDisable(uint8 number)
+{
+    IntEnabled &= ~(1u << number);
+}
+
+void CyDelayUs(uint16 microseconds)
+{
+    HostSim_Advance(microseconds);
+}
+
+/***************************************
+*         Clocks and power modes       *
+****************************************/
+void CySysClkIloStop(void)
+{
+}
+
+void CySysClkWriteEcoDiv(uint32 divider)
+{
+    (void)divider;
+}
+
+void CySysClkWriteHfclkDirect(uint32 clkSelect)
+{
+    (void)clkSelect;
+}
+
+void CySysClkImoStart(void)
+{
+    ImoRunning = 1u;
+}
+
+void CySysClkImoStop(void)
+{
+    ImoRunning = 0u;
+}
+
+void CySysPmSleep(void)
+{
+    if(ImoRunning)
+    {
+        HostSim_Stats.SleepEntries++;
+        WaitForInterrupt(&HostSim_Stats.Sleep_us);
+    }
+    else
+    {
+        HostSim_Stats.SleepEcoEntries++;
+        WaitForInterrupt(&HostSim_Stats.SleepEco_us);
+    }
+}
+
+void CySysPmDeepSleep(void)
+{
+    /* High frequency peripherals stop in deep sleep */
+    if(CapSenseBusy || AdcRunning)
+    {
+        HostSim_Stats.DeepSleepViolations++;
+    }
+    HostSim_Stats.DeepSleepEntries++;
+    WaitForInterrupt(&HostSim_Stats.DeepSleep_us);
+}
+
+/***************************************
+*         SysTick                      *
+****************************************/
+/* SysTick counts down at SYSCLK while the CPU is clocked and stops in deep
+sleep.  Wrapping at the reload value is modelled, the interrupt is not */
+void CySysTickInit(void)
+{
+}
+
+void CySysTickEnable(void)
+{
+    SysTick.Enabled = 1u;
+}
+
+void CySysTickStop(void)
+{
+    SysTick.Enabled = 0u;
+}
+
+void CySysTickEnableInterrupt(void)
+{
+}
+
+void CySysTickDisableInterrupt(void)
+{
+}
+
+void CySysTickSetReload(uint32 value)
+{
+    SysTick.Reload = value & CY_SYS_SYST_RVR_CNT_MASK;
+}
+
+void CySysTickClear(void)
+{
+    SysTick.Base_us = Now_us - HostSim_Stats.DeepSleep_us;
+}
+
+uint32 CySysTickGetValue(void)
+{
+    uint64_t cycles;
+
+    if(!SysTick.Enabled)
+    {
+        return SysTick.Reload;
+    }
+    cycles = (Now_us - HostSim_Stats.DeepSleep_us - SysTick.Base_us) * (CYDEV_BCLK__SYSCLK__HZ / 1000000u);
+    return SysTick.Reload - (uint32)(cycles % ((uint64_t)SysTick.Reload + 1u));
+}
+
+/***************************************
+*         Watchdog timer               *
+****************************************/
+void CySysWdtUnlock(void)
+{
+}
+
+void CySysWdtLock(void)
+{
+}
+
+void CySysWdtWriteMode(uint32 counterNum, uint32 mode)
+{
+    (void)counterNum;
+    (void)mode;
+}
+
+void CySysWdtWriteClearOnMatch(uint32 counterNum, uint32 enable)
+{
+    if(counterNum < 2u)
+    {
+        Wdt[counterNum].ClearOnMatch = (uint8)enable;
+    }
+}
+
+void CySysWdtWriteMatch(uint32 counterNum, uint32 match)
+{
+    if(counterNum < 2u)
+    {
+        /* Matches that were due under the old match still interrupt */
+        LatchEvents();
+        Wdt[counterNum].Match = match & 0xFFFFu;
+        if(Wdt[counterNum].Enabled)
+        {
+            WdtScheduleMatch(&Wdt[counterNum]);
+        }
+    }
+}
+
+uint32 CySysWdtReadMatch(uint32 counterNum)
+{
+    return (counterNum < 2u) ? Wdt[counterNum].Match : 0u;
+}
+
+uint32 CySysWdtReadCount(uint32 counterNum)
+{
+    if((counterNum >= 2u) || (Wdt[counterNum].Enabled == 0u))
+    {
+        return 0u;
+    }
+    /* A match that is due has cleared the counter */
+    LatchEvents();
+    return (uint32)(WdtUsToCounts(Now_us - Wdt[counterNum].Base_us) % HOSTSIM_WDT_COUNTER_RANGE);
+}
+
+void CySysWdtEnable(uint32 counterMask)
+{
+    uint8 i;
+
+    for(i = 0u; i < 2u; i++)
+    {
+        if((counterMask & WdtEnableMask[i]) && (Wdt[i].Enabled == 0u))
+        {
+            Wdt[i].Enabled = 1u;
+            Wdt[i].Base_us = Now_us;
+            WdtScheduleMatch(&Wdt[i]);
+        }
+    }
+}
+
+void CySysWdtDisable(uint32 counterMask)
+{
+    uint8 i;
+
+    for(i = 0u; i < 2u; i++)
+    {
+        if(counterMask & WdtEnableMask[i])
+        {
+            Wdt[i].Enabled = 0u;
+        }
+    }
+}
+
+void CySysWdtClearInterrupt(uint32 counterMask)
+{
+    WdtIntStatus &= ~counterMask;
+}
+
+uint32 CySysWdtGetInterruptStatus(void)
+{
+    LatchEvents();
+    return WdtIntStatus;
+}
+
+/***************************************
+*         Flash                        *
+****************************************/
+uint32 CySysFlashWriteRow(uint32 rowNum, const uint8 rowData[])
+{
+    uint8 saved = IntMasked;
+
+    if(rowNum >= HOSTSIM_FLASH_ROWS)
+    {
+        return CY_SYS_FLASH_INVALID_ADDR;
+    }
+
+    memcpy(&HostSim_Flash[rowNum * HOSTSIM_FLASH_ROW_SIZE], rowData, HOSTSIM_FLASH_ROW_SIZE);
+    HostSim_FlashRowWrites[rowNum]++;
+    HostSim_Stats.FlashRowWrites++;
+
+    /* The CPU stalls on the flash, interrupts wait for the write to end */
+    IntMasked = 1u;
+    Now_us += HOSTSIM_FLASH_WRITE_US;
+    HostSim_Stats.Active_us += HOSTSIM_FLASH_WRITE_US;
+    HostSim_Stats.FlashStall_us += HOSTSIM_FLASH_WRITE_US;
+    IntMasked = saved;
+    Service();
+
+    return CY_SYS_FLASH_SUCCESS;
+}
+
+/***************************************
+*         Pins                         *
+****************************************/
+void Batt_SwitchControl_P0_3_Write(uint8 value)
+{
+    PinState[0] = value;
+}
+
+void BLUE_P3_7_Write(uint8 value)
+{
+    PinState[1] = value;
+}
+
+void GREEN_P3_6_Write(uint8 value)
+{
+    PinState[2] = value;
+}
+
+void RED_P2_6_Write(uint8 value)
+{
+    PinState[3] = value;
+}
+
+void DUART_Start(void)
+{
+}
+
+/***************************************
+*         ADC (SAR)                    *
+****************************************/
+void ADC_Start(void)
+{
+}
+
+void ADC_Stop(void)
+{
+    AdcRunning = 0u;
+}
+
+void ADC_StartConvert(void)
+{
+    AdcRunning = 1u;
+    AdcDue_us = Now_us + HOSTSIM_ADC_CONVERSION_US;
+}
+
+uint32 ADC_IsEndConversion(uint32 retMode)
+{
+    (void)retMode;
+    return (AdcRunning && (Now_us >= AdcDue_us)) ? 1u : 0u;
+}
+
+int16 ADC_GetResult16(uint32 chan)
+{
+    uint32 divided_mV;
+
+    (void)chan;
+    AdcRunning = 0u;
+
+    /* Voltage at the divider tap, scaled to the 1.024 V reference */
+    divided_mV = ((uint32)BatteryVoltage_mV * BATT_R2) / (BATT_R1 + BATT_R2);
+    return (int16)((divided_mV * ADC_DEFAULT_HIGH_LIMIT) / ADC_VREF_MV);
+}
+
+void ADC_Amux_Select(uint8 chan)
+{
+    (void)chan;
+}
+
+/***************************************
+*         CapSense                     *
+****************************************/
+void CapSense_Start(void)
+{
+    CyIntSetVector(HOSTSIM_CAPSENSE_INTERRUPT_NUM, &CapSense_Isr);
+    CyIntEnable(HOSTSIM_CAPSENSE_INTERRUPT_NUM);
+}
+
+void CapSense_Sleep(void)
+{
+}
+
+void CapSense_Wakeup(void)
+{
+}
+
+void CapSense_InitializeAllBaselines(void)
+{
+}
+
+void CapSense_UpdateEnabledBaselines(void)
+{
+}
+
+static uint8 CapSense_WidgetSensors(uint32 widget)
+{
+    return (widget == CapSense_PROXIMITYSENSOR0__PROX) ? 0x10u : 0x0Fu;
+}
+
+void CapSense_EnableWidget(uint32 widget)
+{
+    CapSenseEnabled |= CapSense_WidgetSensors(widget);
+}
+
+void CapSense_DisableWidget(uint32 widget)
+{
+    CapSenseEnabled &= (uint8)~CapSense_WidgetSensors(widget);
+}
+
+/* The scan takes longer the more sensors are enabled */
+void CapSense_ScanEnabledWidgets(void)
+{
+    uint8 sensors = 0u;
+    uint8 i;
+
+    for(i = 0u; i < CapSense_TOTAL_SENSOR_COUNT; i++)
+    {
+        sensors += (CapSenseEnabled >> i) & 1u;
+    }
+
+    CapSenseBusy = 1u;
+    CapSenseDue_us = Now_us + ((uint64_t)sensors * HOSTSIM_CAPSENSE_SENSOR_SCAN_US);
+}
+
+uint32 CapSense_IsBusy(void)
+{
+    LatchEvents();
+    return CapSenseBusy;
+}
+
+uint32 CapSense_CheckIsAnyWidgetActive(void)
+{
+    return (CapSense_sensorOnMask[0] != 0u) ? 1u : 0u;
+}
+
+uint32 CapSense_CheckIsWidgetActive(uint32 widget)
+{
+    return ((CapSense_sensorOnMask[0] & CapSense_WidgetSensors(widget)) != 0u) ? 1u : 0u;
+}
+
+uint16 CapSense_GetCentroidPos(uint32 widget)
+{
+    (void)widget;
+    return CapSenseCentroid;
+}
+
+/***************************************
+*         BLE                          *
+****************************************/
+CYBLE_API_RESULT_T CyBle_Start(CYBLE_CALLBACK_T callbackFunc)
+{
+    StackCallback = callbackFunc;
+    StackOnSent = 0u;
+
+    /* The stack's own BLESS handler, the firmware may chain onto it */
+    CyIntSetVector(HOSTSIM_BLESS_INTERRUPT_NUM, &Bless_Isr);
+    CyIntEnable(HOSTSIM_BLESS_INTERRUPT_NUM);
+    BlessDue_us = Now_us + HOSTSIM_BLESS_INTERVAL_US;
+    return CYBLE_ERROR_OK;
+}
+
+void CyBle_ProcessEvents(void)
+{
+    if((StackCallback != NULL) && (StackOnSent == 0u))
+    {
+        StackOnSent = 1u;
+        StackCallback(CYBLE_EVT_STACK_ON, NULL);
+    }
+}
+
+CYBLE_LP_MODE_T CyBle_EnterLPM(CYBLE_LP_MODE_T pwrMode)
+{
+    return pwrMode;
+}
+
+CYBLE_BLESS_STATE_T CyBle_GetBleSsState(void)
+{
+    return CYBLE_BLESS_STATE_DEEPSLEEP;
+}
+
+CYBLE_STATE_T CyBle_GetState(void)
+{
+    return CYBLE_STATE_ADVERTISING;
+}
+
+CYBLE_API_RESULT_T CyBle_GappStartAdvertisement(uint8 advertisingIntervalType)
+{
+    (void)advertisingIntervalType;
+    return CYBLE_ERROR_OK;
+}
+
+CYBLE_API_RESULT_T CyBle_GattsWriteRsp(CYBLE_CONN_HANDLE_T connHandle)
+{
+    (void)connHandle;
+    return CYBLE_ERROR_OK;
+}
+
+CYBLE_API_RESULT_T CyBle_GattsNotification(CYBLE_CONN_HANDLE_T connHandle, CYBLE_GATTS_HANDLE_VALUE_NTF_T * ntfParam)
+{
+    (void)connHandle;
+    (void)ntfParam;
+    return CYBLE_ERROR_OK;
+}
+
+uint8 CyBle_GattsWriteAttributeValue(CYBLE_GATT_HANDLE_VALUE_PAIR_T * handleValuePair, uint16 offset,
+                                     CYBLE_CONN_HANDLE_T * connHandle, uint8 flags)
+{
+    (void)handleValuePair;
+    (void)offset;
+    (void)connHandle;
+    (void)flags;
+    return 0u;
+}
+
+void CyBle_BasRegisterAttrCallback(CYBLE_CALLBACK_T callbackFunc)
+{
+    (void)callbackFunc;
+}
+
+CYBLE_API_RESULT_T CyBle_BassSendNotification(CYBLE_CONN_HANDLE_T connHandle, uint8 serviceIndex,
+                                              uint8 attrType, uint8 attrSize, uint8 * attrValue)
+{
+    (void)connHandle;
+    (void)serviceIndex;
+    (void)attrType;
+    (void)attrSize;
+    (void)attrValue;
+    return CYBLE_ERROR_OK;
+}
+
+CYBLE_API_RESULT_T CyBle_DissSetCharacteristicValue(uint8 charIndex, uint8 attrSize, uint8 * attrValue)
+{
+    (void)charIndex;
+    (void)attrSize;
+    (void)attrValue;
+    return CYBLE_ERROR_OK;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,603 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         TouchReplay.c
+********************************************************************************
+* Description:
+*  Replays a touch capture (Capture.c) through the unmodified firmware and
+*  reports how the gestures it recognizes compare with a reference:
+*   - accuracy: reference gestures replayed as the same gesture within
+*     REPLAY_MATCH_MS, as another gesture, or not at all, and gestures the
+*     reference does not have
+*   - latency: from the scan that saw the touch come down to the scan that
+*     reported the gesture
+*   - per-scan CPU: host time of the touch process dispatches of each scan
+*
+*  The capture is the stream of CAPTURE_RECORD_LEN byte records as the UART
+*  or the capture characteristic sends it, or as hostsim_bench saves it.
+*  Every CapSense scan of the replay returns the newest record at or before
+*  its time, on the capture's own clock, so the firmware may scan at other
+*  periods than the one that made the capture.  A scan stops at a record
+*  where the sensors change, no touch down or lift off is skipped.
+*
+*  The reference is the gestures the capturing firmware recognized, which
+*  makes the replay a regression test of gesture changes, or a labels file
+*  of "<ms> <gesture>" lines, ms from the first record and the gesture by
+*  name (tap, double_tap, long_press, slide, swipe_left, swipe_right,
+*  swipe_left_long, swipe_right_long, large_object) or number.  A large
+*  object counts once per touch.
+*
+*  Usage: touch_replay capture.bin [labels.txt]
+*  Exits with failure when fewer than REPLAY_PASS_PERMILLE of the reference
+*  gestures replay as they were, or too many replayed gestures are extra.
+*
+********************************************************************************
+*/
+#include <project.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "main.h"
+
+#if (CAPTURE_ENABLED != 1u)
+    #error touch_replay reads the touch capture, build it with CAPTURE_ENABLED=1
+#endif
+
+/* Firmware start up before the first record, and run on after the last.  A
+capture that starts within the lead in of reset keeps its own times, so the
+replay scans in step with the firmware that made it */
+#define REPLAY_LEAD_IN_US               (1000000u)
+#define REPLAY_TAIL_US                  (1000000u)
+/* Most time between a reference gesture and the replayed one */
+#define REPLAY_MATCH_MS                 (150u)
+/* The replay does not scan on exactly the grid of the capture, so a touch
+the capture cut at a scan period change can come out differently.  Pass with
+at least this many per thousand correct, and as few extra */
+#define REPLAY_PASS_PERMILLE            (995u)
+#define REPLAY_GESTURES                 (256u)
+
+typedef struct
+{
+    uint64_t Time_us;               /* replay time */
+    uint8 SensorOnMask;
+    uint8 Centroid;
+    uint8 Gesture;
+    uint16 Raw[CAPTURE_SENSORS];
+} ReplayScan;
+
+typedef struct
+{
+    uint64_t Time_us;
+    uint64_t Down_us;               /* touch down before it */
+    uint8 Gesture;
+    uint8 Matched;
+} ReplayEvent;
+
+typedef struct
+{
+    ReplayEvent * Event;
+    uint32 Count;
+    uint32 Size;
+} ReplayEvents;
+
+static ReplayScan * Replay_Scans;
+static uint32 Replay_ScanCount;
+static uint32 Replay_Next;
+static ReplayEvents Replay_Reference;
+static ReplayEvents Replay_Result;
+static uint8 Replay_LastGesture = NO_GESTURE;
+
+/* Host time of the touch process dispatches since the last scan result */
+static uint64_t Replay_Scan_ns;
+static uint64_t Replay_CpuSum_ns;
+static uint64_t Replay_CpuMax_ns;
+static uint32 Replay_CpuScans;
+
+static const char * const Replay_GestureName[] =
+{
+    [NO_GESTURE]                = "none",
+    [TAP_GESTURE]               = "tap",
+    [SWIPE_LEFT_GESTURE]        = "swipe_left",
+    [SWIPE_RIGHT_GESTURE]       = "swipe_right",
+    [DOUBLE_TAP_GESTURE]        = "double_tap",
+    [LONG_PRESS_GESTURE]        = "long_press",
+    [SLIDE_GESTURE]             = "slide",
+    [SWIPE_LEFT_LONG_GESTURE]   = "swipe_left_long",
+    [SWIPE_RIGHT_LONG_GESTURE]  = "swipe_right_long",
+};
+#define REPLAY_NAMES                    (sizeof(Replay_GestureName) / sizeof(Replay_GestureName[0]))
+
+static const char * Replay_Name(uint8 gesture)
+{
+    if(gesture == LARGE_OBJECT)
+    {
+        return "large_object";
+    }
+
+    return ((gesture < REPLAY_NAMES) && (Replay_GestureName[gesture] != NULL)) ? Replay_GestureName[gesture] : "unknown";
+}
+
+static uint64_t Replay_HostNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000u) + (uint64_t)now.tv_nsec;
+}
+
+/* Touch down of the capture at or before Time_us */
+static uint64_t Replay_DownBefore(uint64_t Time_us)
+{
+    static uint32 scan = 0u;
+    static uint64_t down = 0u;
+    uint8 was;
+
+    for(; (scan < Replay_ScanCount) && (Replay_Scans[scan].Time_us <= Time_us); scan++)
+    {
+        was = (scan > 0u) ? (Replay_Scans[scan - 1u].SensorOnMask & SLIDER_MASK) : 0u;
+        if(((Replay_Scans[scan].SensorOnMask & SLIDER_MASK) != 0u) && (was == 0u))
+        {
+            down = Replay_Scans[scan].Time_us;
+        }
+    }
+
+    return down;
+}
+
+static void Replay_Add(ReplayEvents * events, uint64_t Time_us, uint8 Gesture)
+{
+    if(events->Count == events->Size)
+    {
+        events->Size = (events->Size != 0u) ? (events->Size * 2u) : REPLAY_GESTURES;
+        events->Event = realloc(events->Event, events->Size * sizeof(ReplayEvent));
+        if(events->Event == NULL)
+        {
+            perror("touch_replay");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    events->Event[events->Count].Time_us = Time_us;
+    events->Event[events->Count].Down_us = 0u;
+    events->Event[events->Count].Gesture = Gesture;
+    events->Event[events->Count].Matched = FALSE;
+    events->Count++;
+}
+
+/***************************************
+*         Capture                      *
+****************************************/
+/* Reads the records, skipping bytes up to the next CAPTURE_MAGIC where the
+stream lost sync.  Returns the scans the sequence numbers say were lost */
+static uint32 Replay_Load(FILE * file)
+{
+    uint8 record[CAPTURE_RECORD_LEN];
+    uint32 size = 0u;
+    uint32 lost = 0u;
+    uint32 time;
+    uint32 lastTime = 0u;
+    uint64_t counts = 0u;
+    uint64_t start_us = REPLAY_LEAD_IN_US;
+    uint8 sequence = 0u;
+    uint8 i;
+    uint8 previousGesture = NO_GESTURE;
+    ReplayScan * scan;
+    size_t have = 0u;
+
+    for(;;)
+    {
+        have += fread(&record[have], 1u, CAPTURE_RECORD_LEN - have, file);
+        if(have < CAPTURE_RECORD_LEN)
+        {
+            break;
+        }
+        if(record[CAPTURE_OFFSET_MAGIC] != CAPTURE_MAGIC)
+        {
+            memmove(record, &record[1u], CAPTURE_RECORD_LEN - 1u);
+            have = CAPTURE_RECORD_LEN - 1u;
+            continue;
+        }
+        have = 0u;
+
+        if(Replay_ScanCount == size)
+        {
+            size = (size != 0u) ? (size * 2u) : 4096u;
+            Replay_Scans = realloc(Replay_Scans, size * sizeof(ReplayScan));
+            if(Replay_Scans == NULL)
+            {
+                perror("touch_replay");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        /* The clock wraps, the time is the sum of the steps */
+        time = record[CAPTURE_OFFSET_TIME] | ((uint32)record[CAPTURE_OFFSET_TIME + 1u] << 8u) |
+               ((uint32)record[CAPTURE_OFFSET_TIME + 2u] << 16u) | ((uint32)record[CAPTURE_OFFSET_TIME + 3u] << 24u);
+        if(Replay_ScanCount != 0u)
+        {
+            counts += (uint32)(time - lastTime);
+            lost += (uint8)(record[CAPTURE_OFFSET_SEQUENCE] - sequence - 1u);
+        }
+        else if((((uint64_t)time * 1000u) / WATCHDOG_COUNTS_PER_MS) <= REPLAY_LEAD_IN_US)
+        {
+            start_us = ((uint64_t)time * 1000u) / WATCHDOG_COUNTS_PER_MS;
+        }
+        lastTime = time;
+        sequence = record[CAPTURE_OFFSET_SEQUENCE];
+
+        scan = &Replay_Scans[Replay_ScanCount++];
+        scan->Time_us = start_us + ((counts * 1000u) / WATCHDOG_COUNTS_PER_MS);
+        scan->SensorOnMask = record[CAPTURE_OFFSET_SENSOR_ON];
+        scan->Centroid = record[CAPTURE_OFFSET_CENTROID];
+        scan->Gesture = record[CAPTURE_OFFSET_GESTURE];
+        for(i = 0u; i < CAPTURE_SENSORS; i++)
+        {
+            scan->Raw[i] = record[CAPTURE_OFFSET_RAW + (i * 2u)] | ((uint16)record[CAPTURE_OFFSET_RAW + (i * 2u) + 1u] << 8u);
+        }
+
+        /* The gestures the capturing firmware recognized */
+        if((scan->Gesture != NO_GESTURE) &&
+           !((scan->Gesture == LARGE_OBJECT) && (previousGesture == LARGE_OBJECT)))
+        {
+            Replay_Add(&Replay_Reference, scan->Time_us, scan->Gesture);
+        }
+        previousGesture = scan->Gesture;
+    }
+
+    return lost;
+}
+
+/* Replaces the reference with the labels file */
+static uint8 Replay_LoadLabels(const char * path)
+{
+    FILE * file;
+    char line[128];
+    char name[32];
+    double ms;
+    uint32 number;
+    uint8 gesture;
+    uint8 i;
+    uint32 lineNumber = 0u;
+
+    if((file = fopen(path, "r")) == NULL)
+    {
+        perror(path);
+        return FALSE;
+    }
+
+    Replay_Reference.Count = 0u;
+    while(fgets(line, sizeof(line), file) != NULL)
+    {
+        lineNumber++;
+        if((line[0] == '#') || (sscanf(line, "%lf %31s", &ms, name) != 2))
+        {
+            continue;
+        }
+
+        gesture = NO_GESTURE;
+        if(strcmp(name, "large_object") == 0)
+        {
+            gesture = LARGE_OBJECT;
+        }
+        for(i = 1u; i < REPLAY_NAMES; i++)
+        {
+            if((Replay_GestureName[i] != NULL) && (strcmp(name, Replay_GestureName[i]) == 0))
+            {
+                gesture = i;
+            }
+        }
+        if((gesture == NO_GESTURE) && (sscanf(name, "%u", &number) == 1))
+        {
+            gesture = (uint8)number;
+        }
+        if(gesture == NO_GESTURE)
+        {
+            fprintf(stderr, "%s:%u: unknown gesture %s\n", path, lineNumber, name);
+            continue;
+        }
+
+        Replay_Add(&Replay_Reference, Replay_Scans[0].Time_us + (uint64_t)(ms * 1000.0), gesture);
+    }
+    fclose(file);
+
+    return TRUE;
+}
+
+/***************************************
+*         Firmware hooks               *
+****************************************/
+/* The CapSense stand-in: the newest record at or before now.  A replay scan
+never passes over a record where the sensors change, so a touch shorter than
+the replay scan period is seen as it was in the capture */
+static void Replay_TouchSource(uint64_t now_us, HostSim_TouchSample * sample)
+{
+    static uint8 shown = 0u;
+    const ReplayScan * scan;
+
+    while((Replay_Next < Replay_ScanCount) && (Replay_Scans[Replay_Next].Time_us <= now_us))
+    {
+        Replay_Next++;
+        if(Replay_Scans[Replay_Next - 1u].SensorOnMask != shown)
+        {
+            break;
+        }
+    }
+    /* Nothing touches before the capture or once it has ended */
+    if((Replay_Next == 0u) || ((Replay_Next == Replay_ScanCount) && (now_us > Replay_Scans[Replay_Next - 1u].Time_us)))
+    {
+        return;
+    }
+
+    scan = &Replay_Scans[Replay_Next - 1u];
+    shown = scan->SensorOnMask;
+    sample->SensorOnMask = scan->SensorOnMask;
+    sample->Centroid = (scan->Centroid == NO_TOUCH) ? 0xFFFFu : scan->Centroid;
+    memcpy(sample->Raw, scan->Raw, sizeof(sample->Raw));
+}
+
+void __real_Batt_Process(void);
+void __real_BLE_Process(void);
+void __real_LED_Process(void);
+void __real_Touch_Process(void);
+void __real_Sleep_Process(void);
+
+/* Virtual time only moves when a dispatch is charged, so the processes cost
+what hostsim_bench charges them */
+void __wrap_Batt_Process(void)
+{
+    __real_Batt_Process();
+    HostSim_Advance(40u);
+}
+
+void __wrap_BLE_Process(void)
+{
+    __real_BLE_Process();
+    HostSim_Advance(120u);
+}
+
+void __wrap_LED_Process(void)
+{
+    __real_LED_Process();
+    HostSim_Advance(15u);
+}
+
+void __wrap_Sleep_Process(void)
+{
+    __real_Sleep_Process();
+    HostSim_Advance(5u);
+}
+
+/* Every scan result the firmware makes goes to the capture ring, which tells
+the replay the gesture of the scan */
+void __wrap_Touch_Process(void)
+{
+    uint8 record[CAPTURE_RECORD_LEN];
+    uint8 gesture;
+    uint64_t start = Replay_HostNs();
+
+    __real_Touch_Process();
+    Replay_Scan_ns += Replay_HostNs() - start;
+    HostSim_Advance(60u);
+
+    while(Capture_Peek(record))
+    {
+        Capture_Drop();
+
+        Replay_CpuSum_ns += Replay_Scan_ns;
+        if(Replay_Scan_ns > Replay_CpuMax_ns)
+        {
+            Replay_CpuMax_ns = Replay_Scan_ns;
+        }
+        Replay_CpuScans++;
+        Replay_Scan_ns = 0u;
+
+        gesture = record[CAPTURE_OFFSET_GESTURE];
+        if((gesture != NO_GESTURE) &&
+           !((gesture == LARGE_OBJECT) && (Replay_LastGesture == LARGE_OBJECT)))
+        {
+            Replay_Add(&Replay_Result, HostSim_Now(), gesture);
+        }
+        Replay_LastGesture = gesture;
+    }
+}
+
+/***************************************
+*         Report                       *
+****************************************/
+static uint64_t Replay_Distance(uint64_t a, uint64_t b)
+{
+    return (a > b) ? (a - b) : (b - a);
+}
+
+/* Pairs every reference gesture with the first unmatched replayed gesture
+near it, the same gesture if there is one.  Returns the correct ones */
+static uint32 Replay_Match(uint32 * wrong, uint32 * missed)
+{
+    uint32 i;
+    uint32 j;
+    uint32 correct = 0u;
+    uint32 other;
+    ReplayEvent * reference;
+    ReplayEvent * result;
+
+    *wrong = 0u;
+    *missed = 0u;
+
+    for(i = 0u; i < Replay_Reference.Count; i++)
+    {
+        reference = &Replay_Reference.Event[i];
+        other = Replay_Result.Count;
+
+        for(j = 0u; j < Replay_Result.Count; j++)
+        {
+            result = &Replay_Result.Event[j];
+            if(result->Matched || (Replay_Distance(result->Time_us, reference->Time_us) > (REPLAY_MATCH_MS * 1000u)))
+            {
+                continue;
+            }
+            if(result->Gesture == reference->Gesture)
+            {
+                break;
+            }
+            if(other == Replay_Result.Count)
+            {
+                other = j;
+            }
+        }
+
+        if(j < Replay_Result.Count)
+        {
+            Replay_Result.Event[j].Matched = TRUE;
+            reference->Matched = TRUE;
+            correct++;
+        }
+        else if(other < Replay_Result.Count)
+        {
+            Replay_Result.Event[other].Matched = TRUE;
+            (*wrong)++;
+        }
+        else
+        {
+            (*missed)++;
+        }
+    }
+
+    return correct;
+}
+
+static void Replay_ReportGestures(void)
+{
+    uint32 i;
+    uint32 code;
+    uint32 reference;
+    uint32 replayed;
+    uint32 correct;
+    uint64_t latency;
+    uint64_t latencySum;
+    uint64_t latencyMax;
+    const ReplayEvent * event;
+
+    printf("\n%-18s %10s %10s %10s %12s %12s\n", "Gesture", "Reference", "Replayed", "Correct", "Latency(ms)", "Max(ms)");
+    for(code = 0u; code <= 0xFFu; code++)
+    {
+        reference = 0u;
+        replayed = 0u;
+        correct = 0u;
+        latencySum = 0u;
+        latencyMax = 0u;
+
+        for(i = 0u; i < Replay_Reference.Count; i++)
+        {
+            reference += (Replay_Reference.Event[i].Gesture == code) ? 1u : 0u;
+        }
+        for(i = 0u; i < Replay_Result.Count; i++)
+        {
+            event = &Replay_Result.Event[i];
+            if(event->Gesture != code)
+            {
+                continue;
+            }
+            replayed++;
+
+            latency = event->Time_us - event->Down_us;
+            latencySum += latency;
+            if(latency > latencyMax)
+            {
+                latencyMax = latency;
+            }
+        }
+        for(i = 0u; i < Replay_Reference.Count; i++)
+        {
+            correct += ((Replay_Reference.Event[i].Gesture == code) && Replay_Reference.Event[i].Matched) ? 1u : 0u;
+        }
+
+        if((reference != 0u) || (replayed != 0u))
+        {
+            printf("%-18s %10u %10u %10u %12.1f %12.1f\n", Replay_Name((uint8)code), reference, replayed, correct,
+                   (replayed != 0u) ? ((double)latencySum / 1000.0 / (double)replayed) : 0.0,
+                   (double)latencyMax / 1000.0);
+        }
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    FILE * file;
+    uint32 lost;
+    uint32 touches = 0u;
+    uint32 correct;
+    uint32 wrong;
+    uint32 missed;
+    uint32 extra = 0u;
+    uint32 i;
+    uint8 result;
+
+    if(argc < 2)
+    {
+        fprintf(stderr, "usage: touch_replay capture.bin [labels.txt]\n");
+        return EXIT_FAILURE;
+    }
+    if((file = fopen(argv[1], "rb")) == NULL)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    lost = Replay_Load(file);
+    fclose(file);
+    if(Replay_ScanCount == 0u)
+    {
+        fprintf(stderr, "%s: no capture records\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    if((argc > 2) && !Replay_LoadLabels(argv[2]))
+    {
+        return EXIT_FAILURE;
+    }
+
+    for(i = 0u; i < Replay_ScanCount; i++)
+    {
+        if(((Replay_Scans[i].SensorOnMask & SLIDER_MASK) != 0u) &&
+           ((i == 0u) || ((Replay_Scans[i - 1u].SensorOnMask & SLIDER_MASK) == 0u)))
+        {
+            touches++;
+        }
+    }
+
+    HostSim_SetTouchSource(&Replay_TouchSource);
+    result = HostSim_Run(Replay_Scans[Replay_ScanCount - 1u].Time_us + REPLAY_TAIL_US);
+
+    for(i = 0u; i < Replay_Result.Count; i++)
+    {
+        Replay_Result.Event[i].Down_us = Replay_DownBefore(Replay_Result.Event[i].Time_us);
+    }
+    correct = Replay_Match(&wrong, &missed);
+    for(i = 0u; i < Replay_Result.Count; i++)
+    {
+        extra += Replay_Result.Event[i].Matched ? 0u : 1u;
+    }
+
+    printf("Capture            : %u scans over %.1f s, %u lost, %u touches\n", Replay_ScanCount,
+           (double)(Replay_Scans[Replay_ScanCount - 1u].Time_us - Replay_Scans[0].Time_us) / 1e6, lost, touches);
+    printf("Reference          : %u gestures, %s\n", Replay_Reference.Count,
+           (argc > 2) ? argv[2] : "as the capturing firmware recognized them");
+    printf("Replay             : %u gestures in %u scans\n", Replay_Result.Count, Replay_CpuScans);
+    printf("Accuracy           : %u of %u correct (%.1f%%), %u wrong, %u missed, %u extra\n", correct,
+           Replay_Reference.Count,
+           (Replay_Reference.Count != 0u) ? (100.0 * (double)correct / (double)Replay_Reference.Count) : 100.0,
+           wrong, missed, extra);
+    printf("Per-scan CPU (host): mean %.0f ns, max %llu ns\n",
+           (Replay_CpuScans != 0u) ? ((double)Replay_CpuSum_ns / (double)Replay_CpuScans) : 0.0,
+           (unsigned long long)Replay_CpuMax_ns);
+    Replay_ReportGestures();
+
+    if((result != 0u) ||
+       (((uint64_t)correct * 1000u) < ((uint64_t)Replay_Reference.Count * REPLAY_PASS_PERMILLE)) ||
+       (((uint64_t)extra * 1000u) > ((uint64_t)Replay_Result.Count * (1000u - REPLAY_PASS_PERMILLE))))
+    {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* [] END OF FILE */
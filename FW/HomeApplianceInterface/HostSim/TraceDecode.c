@@ -0,0 +1,217 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         TraceDecode.c
+********************************************************************************
+* Description:
+*  Host decoder of the firmware trace (Trace.c).  Reads the trace packets as
+*  they come off the trace characteristic or the UART, TRACE_PACKET_LEN bytes
+*  each in any order, and writes Chrome trace event JSON that chrome://tracing
+*  and Perfetto open.
+*
+*  Every bit of every process's debug mask is its own track, named after the
+*  process and the bit, with a slice from each set to the following clear.
+*  Timestamps are the firmware's WDT clock in microseconds since start up.
+*
+*  Usage: trace_decode [packets.bin [trace.json]]
+*  Reads stdin and writes stdout when the files are left out.
+*
+********************************************************************************
+*/
+#include <project.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+
+/* Indexes of the packets, the largest trace there can be */
+#define DECODE_RECORDS_MAX              (0x10000u)
+
+typedef struct
+{
+    uint8 Valid;
+    TRACE_RECORD Record;
+} DecodeSlot;
+
+static DecodeSlot Decode_Trace[DECODE_RECORDS_MAX];
+/* Mask bits that are set, and the tracks that were named, per process */
+static uint8 Decode_State[TRACE_ID_MASK + 1u];
+static uint8 Decode_Named[TRACE_ID_MASK + 1u];
+
+static const char * Decode_ProcessName(uint8 id)
+{
+    static char name[16];
+
+    switch(id)
+    {
+        case BATT_PROCESS_ID:       return "Batt";
+        case BLE_PROCESS_ID:        return "BLE";
+        case TOUCH_PROCESS_ID:      return "Touch";
+        case LED_PROCESS_ID:        return "LED";
+        case SLEEP_PROCESS_ID:      return "Sleep";
+        case SYSTEM_PROCESS_ID:     return "System";
+        case TESTMUX_PROCESS_ID:    return "TestMux";
+        case TRACE_ID_UNKNOWN:      return "Unknown";
+        default:
+            snprintf(name, sizeof(name), "Process %u", id);
+            return name;
+    }
+}
+
+static const char * Decode_MaskName(uint8 id, uint8 bit)
+{
+    static char name[12];
+
+    if(id == SYSTEM_PROCESS_ID)
+    {
+        switch(1u << bit)
+        {
+            case DEBUG_COOP_TICK_MASK:      return "tick";
+            case DEBUG_COOP_LOOP_MASK:      return "loop";
+            case DEBUG_SLEEP_MASK:          return "sleep";
+            case DEBUG_ALTACTIVE_MASK:      return "alt active";
+            case DEBUG_WHILE_WAIT_MASK:     return "wait";
+            case DEBUG_ERROR_LOGGED_MASK:   return "logging error";
+            case DEBUG_ERROR_MASK:          return "error";
+            default:                        break;
+        }
+    }
+
+    snprintf(name, sizeof(name), "0x%02X", 1u << bit);
+    return name;
+}
+
+static void Decode_Event(FILE * out, char phase, uint8 id, uint8 bit, double ts)
+{
+    uint32 track = ((uint32)id * 8u) + bit;
+
+    if((Decode_Named[id] & (1u << bit)) == 0u)
+    {
+        Decode_Named[id] |= (uint8)(1u << bit);
+        fprintf(out, ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %s\"}}",
+                track, Decode_ProcessName(id), Decode_MaskName(id, bit));
+        fprintf(out, ",\n{\"ph\":\"M\",\"name\":\"thread_sort_index\",\"pid\":1,\"tid\":%u,\"args\":{\"sort_index\":%u}}",
+                track, track);
+    }
+
+    fprintf(out, ",\n{\"ph\":\"%c\",\"name\":\"%s\",\"cat\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}",
+            phase, Decode_MaskName(id, bit), Decode_ProcessName(id), track, ts);
+}
+
+int main(int argc, char * argv[])
+{
+    FILE * in = stdin;
+    FILE * out = stdout;
+    uint8 packet[TRACE_PACKET_LEN];
+    uint32 index;
+    uint32 count = 0u;
+    uint32 i;
+    uint32 missing = 0u;
+    uint32 events = 0u;
+    uint8 bit;
+    uint8 id;
+    uint32 high = 0u;
+    double ts = 0.0;
+    const TRACE_RECORD * record;
+
+    if((argc > 1) && ((in = fopen(argv[1], "rb")) == NULL))
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    if((argc > 2) && ((out = fopen(argv[2], "w")) == NULL))
+    {
+        perror(argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    /* Place the records of every packet at their index */
+    while(fread(packet, 1u, TRACE_PACKET_LEN, in) == TRACE_PACKET_LEN)
+    {
+        index = packet[0u] | ((uint32)packet[1u] << 8u);
+        count = packet[2u] | ((uint32)packet[3u] << 8u);
+        for(i = 0u; (i < TRACE_PACKET_RECORDS) && ((index + i) < count); i++)
+        {
+            const uint8 * data = &packet[TRACE_PACKET_HEADER_LEN + (i * 4u)];
+
+            Decode_Trace[index + i].Valid = 1u;
+            Decode_Trace[index + i].Record.Time = data[0u] | ((uint16)data[1u] << 8u);
+            Decode_Trace[index + i].Record.ID = data[2u];
+            Decode_Trace[index + i].Record.Mask = data[3u];
+        }
+    }
+
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    fprintf(out, "\n{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"args\":{\"name\":\"HomeApplianceInterface\"}}");
+
+    for(i = 0u; i < count; i++)
+    {
+        if(!Decode_Trace[i].Valid)
+        {
+            missing++;
+            continue;
+        }
+
+        record = &Decode_Trace[i].Record;
+        if(record->ID == TRACE_ID_SYNC)
+        {
+            high = record->Time;
+            continue;
+        }
+
+        ts = (double)(((uint64_t)high << 16u) | record->Time) * 1000.0 / WATCHDOG_COUNTS_PER_MS;
+        id = record->ID & TRACE_ID_MASK;
+        events++;
+
+        /* A set of a bit that is already set, or a clear of one that is not,
+        only repeats the state */
+        for(bit = 0u; bit < 8u; bit++)
+        {
+            if((record->Mask & (1u << bit)) == 0u)
+            {
+                continue;
+            }
+            if((record->ID & TRACE_EDGE_SET) != 0u)
+            {
+                if((Decode_State[id] & (1u << bit)) == 0u)
+                {
+                    Decode_State[id] |= (uint8)(1u << bit);
+                    Decode_Event(out, 'B', id, bit, ts);
+                }
+            }
+            else if((Decode_State[id] & (1u << bit)) != 0u)
+            {
+                Decode_State[id] &= (uint8)~(1u << bit);
+                Decode_Event(out, 'E', id, bit, ts);
+            }
+        }
+    }
+
+    /* Close what was still set when the trace stopped */
+    for(id = 0u; id <= TRACE_ID_MASK; id++)
+    {
+        for(bit = 0u; bit < 8u; bit++)
+        {
+            if((Decode_State[id] & (1u << bit)) != 0u)
+            {
+                Decode_Event(out, 'E', id, bit, ts);
+            }
+        }
+    }
+
+    fprintf(out, "\n]}\n");
+
+    fprintf(stderr, "trace_decode: %u records, %u events, %u missing\n", count, events, missing);
+
+    if(in != stdin)
+    {
+        fclose(in);
+    }
+    if(out != stdout)
+    {
+        fclose(out);
+    }
+
+    return (missing == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,332 @@
+/*******************************************************************************
+* Project Name:      PSoC 4 BLE Home Appliance Interface
+* File Name:         project.h (Host Simulation)
+********************************************************************************
+* Description:
+*  Stand-in for the PSoC Creator generated project.h.  Provides the cytypes,
+*  the system APIs (WDT, power modes, clocks, interrupts) and the component
+*  APIs (CapSense, ADC, BLE, pins) used by the firmware so that the co-op
+*  loop can be compiled and run on a Linux host.  Every hardware access is
+*  routed to the virtual hardware model in HostSim_Hal.c.
+*
+********************************************************************************
+*/
+#ifndef HOSTSIM_PROJECT_H
+#define HOSTSIM_PROJECT_H
+
+#include <stdint.h>
+#include <string.h>
+
+/***************************************
+*         cytypes.h                    *
+****************************************/
+typedef uint8_t     uint8;
+typedef uint16_t    uint16;
+typedef uint32_t    uint32;
+typedef int8_t      int8;
+typedef int16_t     int16;
+typedef int32_t     int32;
+typedef uint64_t    uint64;
+typedef int64_t     int64;
+typedef uint8_t     reg8;
+typedef uint32_t    reg32;
+
+#define CYDATA
+#define CYCODE
+#define CY_INLINE                       inline
+
+#define CY_ISR(FuncName)                void FuncName(void)
+#define CY_ISR_PROTO(FuncName)          void FuncName(void)
+typedef void (* cyisraddress)(void);
+
+/***************************************
+*         Virtual hardware control     *
+****************************************/
+#include "HostSim.h"
+
+/* Busy-waits on the event rings jump virtual time to the next interrupt */
+#define mBusyWaitHook()\
+    do\
+    {\
+        HostSim_WaitForInterrupt();\
+    } while(0)
+
+/***************************************
+*         CyLib / interrupts           *
+****************************************/
+#define CyGlobalIntEnable               HostSim_SetInterruptMask(0u)
+#define CyGlobalIntDisable              HostSim_SetInterruptMask(1u)
+
+uint8 CyEnterCriticalSection(void);
+void CyExitCriticalSection(uint8 savedIntrStatus);
+cyisraddress CyIntSetVector(uint8 number, cyisraddress address);
+void CyIntEnable(uint8 number);
+void CyIntDisable(uint8 number);
+void CyDelayUs(uint16 microseconds);
+
+/***************************************
+*         Clocks and power modes       *
+****************************************/
+#define CYDEV_BCLK__SYSCLK__HZ          (24000000u)
+#define CY_SYS_CLK_ECO_DIV8             (3u)
+#define CY_SYS_CLK_HFCLK_IMO            (0u)
+#define CY_SYS_CLK_HFCLK_ECO            (2u)
+
+void CySysClkIloStop(void);
+void CySysClkWriteEcoDiv(uint32 divider);
+void CySysClkWriteHfclkDirect(uint32 clkSelect);
+void CySysClkImoStart(void);
+void CySysClkImoStop(void);
+void CySysPmSleep(void);
+void CySysPmDeepSleep(void);
+
+/* cyPm.h, CPU wait for interrupt */
+#define CY_PM_WFI                       HostSim_Wfi()
+
+/***************************************
+*         SysTick                      *
+****************************************/
+#define CY_SYS_SYST_RVR_CNT_MASK        (0x00FFFFFFu)
+
+void CySysTickInit(void);
+void CySysTickEnable(void);
+void CySysTickStop(void);
+void CySysTickEnableInterrupt(void);
+void CySysTickDisableInterrupt(void);
+void CySysTickSetReload(uint32 value);
+void CySysTickClear(void);
+uint32 CySysTickGetValue(void);
+
+/***************************************
+*         Watchdog timer               *
+****************************************/
+#define CY_SYS_WDT_MODE_NONE            (0u)
+#define CY_SYS_WDT_MODE_INT             (1u)
+#define CY_SYS_WDT_COUNTER0_MASK        (0x01u)
+#define CY_SYS_WDT_COUNTER1_MASK        (0x0100u)
+#define CY_SYS_WDT_COUNTER0_INT         (0x04u)
+#define CY_SYS_WDT_COUNTER1_INT         (0x08u)
+
+void CySysWdtUnlock(void);
+void CySysWdtLock(void);
+void CySysWdtWriteMode(uint32 counterNum, uint32 mode);
+void CySysWdtWriteClearOnMatch(uint32 counterNum, uint32 enable);
+void CySysWdtWriteMatch(uint32 counterNum, uint32 match);
+uint32 CySysWdtReadMatch(uint32 counterNum);
+uint32 CySysWdtReadCount(uint32 counterNum);
+void CySysWdtEnable(uint32 counterMask);
+void CySysWdtDisable(uint32 counterMask);
+void CySysWdtClearInterrupt(uint32 counterMask);
+uint32 CySysWdtGetInterruptStatus(void);
+
+/***************************************
+*         Flash                        *
+****************************************/
+#define CY_FLASH_SIZEOF_ROW             (HOSTSIM_FLASH_ROW_SIZE)
+#define CY_SYS_FLASH_SUCCESS            (0x00u)
+#define CY_SYS_FLASH_INVALID_ADDR       (0x04u)
+#define CY_ALIGN(align)                 __attribute__((aligned(align)))
+
+uint32 CySysFlashWriteRow(uint32 rowNum, const uint8 rowData[]);
+
+/* The error store lives in the flash model from row 0, see HostSim.h */
+#define ERROR_STORE_FLASH               (HostSim_Flash)
+#define ERROR_STORE_FIRST_ROW           (0u)
+
+/***************************************
+*         Pins and control registers   *
+****************************************/
+void Batt_SwitchControl_P0_3_Write(uint8 value);
+void BLUE_P3_7_Write(uint8 value);
+void GREEN_P3_6_Write(uint8 value);
+void RED_P2_6_Write(uint8 value);
+void DUART_Start(void);
+
+extern uint8 FirmwareDebugOutput0_Control;
+extern uint8 FirmwareDebugOutput1_Control;
+extern uint8 HardwareDebugMuxSelect_Control;
+
+/***************************************
+*         ADC (SAR)                    *
+****************************************/
+extern uint32 HostSim_ADC_SAR_CTRL;
+#define ADC_SAR_CTRL_REG                (HostSim_ADC_SAR_CTRL)
+#define ADC_DEFAULT_CTRL_REG_CFG        (0x80000000u)
+#define ADC_VREF_INTERNAL1024           (0x00000040u)
+#define ADC_NEG_VSSA                    (0x00000000u)
+#define ADC_DEFAULT_HIGH_LIMIT          (2047u)
+#define ADC_RETURN_STATUS               (1u)
+#define ADC_WAIT_FOR_RESULT             (2u)
+
+void ADC_Start(void);
+void ADC_Stop(void);
+void ADC_StartConvert(void);
+uint32 ADC_IsEndConversion(uint32 retMode);
+int16 ADC_GetResult16(uint32 chan);
+void ADC_Amux_Select(uint8 chan);
+
+/***************************************
+*         CapSense                     *
+****************************************/
+#define CapSense_LINEARSLIDER0__LS      (0u)
+#define CapSense_PROXIMITYSENSOR0__PROX (1u)
+#define CapSense_TOTAL_SENSOR_COUNT     (5u)
+
+extern uint8 CapSense_sensorOnMask[];
+extern uint16 CapSense_sensorRaw[];
+
+void CapSense_Start(void);
+void CapSense_Sleep(void);
+void CapSense_Wakeup(void);
+void CapSense_InitializeAllBaselines(void);
+void CapSense_UpdateEnabledBaselines(void);
+void CapSense_EnableWidget(uint32 widget);
+void CapSense_DisableWidget(uint32 widget);
+void CapSense_ScanEnabledWidgets(void);
+uint32 CapSense_IsBusy(void);
+uint32 CapSense_CheckIsAnyWidgetActive(void);
+uint32 CapSense_CheckIsWidgetActive(uint32 widget);
+uint16 CapSense_GetCentroidPos(uint32 widget);
+
+/***************************************
+*         BLE                          *
+****************************************/
+typedef uint16 CYBLE_GATT_DB_ATTR_HANDLE_T;
+
+typedef struct
+{
+    uint8 * val;
+    uint16 len;
+    uint16 actualLen;
+} CYBLE_GATT_VALUE_T;
+
+typedef struct
+{
+    CYBLE_GATT_VALUE_T value;
+    CYBLE_GATT_DB_ATTR_HANDLE_T attrHandle;
+} CYBLE_GATT_HANDLE_VALUE_PAIR_T;
+
+typedef CYBLE_GATT_HANDLE_VALUE_PAIR_T CYBLE_GATTS_HANDLE_VALUE_NTF_T;
+
+typedef struct
+{
+    uint8 bdHandle;
+    uint8 attId;
+} CYBLE_CONN_HANDLE_T;
+
+typedef struct
+{
+    CYBLE_CONN_HANDLE_T connHandle;
+    CYBLE_GATT_HANDLE_VALUE_PAIR_T handleValPair;
+} CYBLE_GATTS_WRITE_REQ_PARAM_T;
+
+typedef struct
+{
+    CYBLE_CONN_HANDLE_T connHandle;
+    uint8 serviceIndex;
+    uint8 charIndex;
+    CYBLE_GATT_VALUE_T * value;
+} CYBLE_BAS_CHAR_VALUE_T;
+
+typedef enum
+{
+    CYBLE_ERROR_OK = 0u,
+    CYBLE_ERROR_INVALID_PARAMETER,
+    CYBLE_ERROR_INVALID_OPERATION
+} CYBLE_API_RESULT_T;
+
+typedef enum
+{
+    CYBLE_BLESS_STATE_ACTIVE = 1u,
+    CYBLE_BLESS_STATE_EVENT_CLOSE,
+    CYBLE_BLESS_STATE_SLEEP,
+    CYBLE_BLESS_STATE_ECO_ON,
+    CYBLE_BLESS_STATE_ECO_STABLE,
+    CYBLE_BLESS_STATE_DEEPSLEEP,
+    CYBLE_BLESS_STATE_HIBERNATE,
+    CYBLE_BLESS_STATE_INVALID = 0xFFu
+} CYBLE_BLESS_STATE_T;
+
+typedef enum
+{
+    CYBLE_BLESS_ACTIVE = 1u,
+    CYBLE_BLESS_SLEEP,
+    CYBLE_BLESS_DEEPSLEEP,
+    CYBLE_BLESS_HIBERNATE
+} CYBLE_LP_MODE_T;
+
+typedef enum
+{
+    CYBLE_STATE_STOPPED = 0u,
+    CYBLE_STATE_INITIALIZING,
+    CYBLE_STATE_CONNECTED,
+    CYBLE_STATE_ADVERTISING,
+    CYBLE_STATE_DISCONNECTED
+} CYBLE_STATE_T;
+
+typedef enum
+{
+    CYBLE_GATT_DB_PEER_INITIATED = 1u,
+    CYBLE_GATT_DB_LOCALLY_INITIATED = 2u
+} CYBLE_GATT_DB_WRITE_FLAGS_T;
+
+typedef void (* CYBLE_CALLBACK_T)(uint32 eventCode, void * eventParam);
+
+/* Stack events */
+#define CYBLE_EVT_STACK_ON                          (0x01u)
+#define CYBLE_EVT_GAP_DEVICE_DISCONNECTED           (0x02u)
+#define CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP     (0x03u)
+#define CYBLE_EVT_GATTS_WRITE_REQ                   (0x04u)
+#define CYBLE_EVT_GATT_CONNECT_IND                  (0x05u)
+#define CYBLE_EVT_GATT_DISCONNECT_IND               (0x06u)
+
+/* Battery service events */
+#define CYBLE_EVT_BASS_NOTIFICATION_ENABLED         (0x40u)
+#define CYBLE_EVT_BASS_NOTIFICATION_DISABLED        (0x41u)
+#define CYBLE_EVT_BASC_NOTIFICATION                 (0x42u)
+#define CYBLE_EVT_BASC_READ_CHAR_RESPONSE           (0x43u)
+#define CYBLE_EVT_BASC_READ_DESCR_RESPONSE          (0x44u)
+#define CYBLE_EVT_BASC_WRITE_DESCR_RESPONSE         (0x45u)
+
+#define CYBLE_ADVERTISING_FAST                      (0x00u)
+#define CYBLE_DIS_FIRMWARE_REV                      (0x05u)
+#define CYBLE_BATTERY_SERVICE_INDEX                 (0x00u)
+#define CYBLE_BAS_BATTERY_LEVEL                     (0x00u)
+
+/* Custom service handles of the GATT database in TopDesign.cysch */
+#define CYBLE_TOUCH_SLIDER_CURRENT_CENTROID_CHAR_HANDLE                                   (0x001Au)
+#define CYBLE_TOUCH_SLIDER_CURRENT_CENTROID_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE (0x001Bu)
+#define CYBLE_TOUCH_SLIDER_CURRENT_CENTROID_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_INDEX  (0x00u)
+#define CYBLE_TOUCH_SLIDER_GESTURE_CHAR_HANDLE                                            (0x001Eu)
+#define CYBLE_TOUCH_SLIDER_GESTURE_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE        (0x001Fu)
+#define CYBLE_TOUCH_SLIDER_GESTURE_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_INDEX         (0x00u)
+#define CYBLE_DIAGNOSTICS_PROFILER_CHAR_HANDLE                                            (0x0023u)
+#define CYBLE_DIAGNOSTICS_POWER_CHAR_HANDLE                                               (0x0026u)
+#define CYBLE_DIAGNOSTICS_TRACE_CHAR_HANDLE                                               (0x0029u)
+#define CYBLE_DIAGNOSTICS_TESTMUX_CHAR_HANDLE                                             (0x002Cu)
+#define CYBLE_DIAGNOSTICS_CAPTURE_CHAR_HANDLE                                             (0x002Fu)
+#define CYBLE_DIAGNOSTICS_CAPTURE_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_HANDLE         (0x0030u)
+#define CYBLE_DIAGNOSTICS_CAPTURE_CLIENT_CHARACTERISTIC_CONFIGURATION_DESC_INDEX          (0x00u)
+
+/* cyfitter.h, BLESS interrupt of the BLE component */
+#define BLE_1_bless_isr__INTC_NUMBER    (12u)
+
+extern CYBLE_CONN_HANDLE_T cyBle_connHandle;
+
+CYBLE_API_RESULT_T CyBle_Start(CYBLE_CALLBACK_T callbackFunc);
+void CyBle_ProcessEvents(void);
+CYBLE_LP_MODE_T CyBle_EnterLPM(CYBLE_LP_MODE_T pwrMode);
+CYBLE_BLESS_STATE_T CyBle_GetBleSsState(void);
+CYBLE_STATE_T CyBle_GetState(void);
+CYBLE_API_RESULT_T CyBle_GappStartAdvertisement(uint8 advertisingIntervalType);
+CYBLE_API_RESULT_T CyBle_GattsWriteRsp(CYBLE_CONN_HANDLE_T connHandle);
+CYBLE_API_RESULT_T CyBle_GattsNotification(CYBLE_CONN_HANDLE_T connHandle, CYBLE_GATTS_HANDLE_VALUE_NTF_T * ntfParam);
+uint8 CyBle_GattsWriteAttributeValue(CYBLE_GATT_HANDLE_VALUE_PAIR_T * handleValuePair, uint16 offset,
+                                     CYBLE_CONN_HANDLE_T * connHandle, uint8 flags);
+void CyBle_BasRegisterAttrCallback(CYBLE_CALLBACK_T callbackFunc);
+CYBLE_API_RESULT_T CyBle_BassSendNotification(CYBLE_CONN_HANDLE_T connHandle, uint8 serviceIndex,
+                                              uint8 attrType, uint8 attrSize, uint8 * attrValue);
+CYBLE_API_RESULT_T CyBle_DissSetCharacteristicValue(uint8 charIndex, uint8 attrSize, uint8 * attrValue);
+
+#endif
+/* [] END OF FILE */